@@ -51,6 +51,14 @@ shared_ptr<ExpressionNode> ArgListNode::getArg(int index) const
     return args[index];
 }
 
+void ArgListNode::setArg(int index, shared_ptr<ExpressionNode> arg)
+{
+    if (index >= 0 && index < static_cast<int>(args.size()))
+    {
+        args[index] = arg;
+    }
+}
+
 int ArgListNode::getArgCount() const
 {
     return static_cast<int>(args.size());
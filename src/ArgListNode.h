@@ -29,6 +29,7 @@ public:
     void addAllArgs(shared_ptr<ArgListNode> other);
 
     shared_ptr<ExpressionNode> getArg(int index) const;
+    void setArg(int index, shared_ptr<ExpressionNode> arg);
 
     const vector<shared_ptr<ExpressionNode>> &getArgs() const;
 
@@ -24,6 +24,11 @@ shared_ptr<ExpressionNode> ArrayAccessNode::getIndex() const
     return index;
 }
 
+void ArrayAccessNode::setIndex(shared_ptr<ExpressionNode> index)
+{
+    this->index = index;
+}
+
 bool ArrayAccessNode::isLval() const
 {
     return true;
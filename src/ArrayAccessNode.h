@@ -24,6 +24,7 @@ public:
     shared_ptr<ExpressionNode> getArray() const;
 
     shared_ptr<ExpressionNode> getIndex() const;
+    void setIndex(shared_ptr<ExpressionNode> index);
 
     bool isLval() const override;
 
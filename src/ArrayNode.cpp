@@ -1,13 +1,32 @@
 #include "ArrayNode.h"
+#include "NumberNode.h"
+#include "StringNode.h"
+#include "BooleanNode.h"
+#include "NullNode.h"
+
+using std::dynamic_pointer_cast;
 
 ArrayNode::ArrayNode(const vector<shared_ptr<ExpressionNode>> &elements):
-    elements(elements)
+    elements(elements),
+    constant(true)
 {
     if (!elements.empty())
     {
         setRangeStart(elements.front()->getRange().getStart());
         setRangeEnd(elements.back()->getRange().getEnd());
     }
+
+    for (const auto &element : elements)
+    {
+        if (!dynamic_pointer_cast<NumberNode>(element) &&
+            !dynamic_pointer_cast<StringNode>(element) &&
+            !dynamic_pointer_cast<BooleanNode>(element) &&
+            !dynamic_pointer_cast<NullNode>(element))
+        {
+            constant = false;
+            break;
+        }
+    }
 }
 
 const vector<shared_ptr<ExpressionNode>> &ArrayNode::getElements() const
@@ -15,6 +34,41 @@ const vector<shared_ptr<ExpressionNode>> &ArrayNode::getElements() const
     return elements;
 }
 
+void ArrayNode::setElement(size_t index, shared_ptr<ExpressionNode> element)
+{
+    elements.at(index) = element;
+
+    // a folded element can make the whole literal constant
+    constant = true;
+    for (const auto &each : elements)
+    {
+        if (!dynamic_pointer_cast<NumberNode>(each) &&
+            !dynamic_pointer_cast<StringNode>(each) &&
+            !dynamic_pointer_cast<BooleanNode>(each) &&
+            !dynamic_pointer_cast<NullNode>(each))
+        {
+            constant = false;
+            break;
+        }
+    }
+    constantValues = nullptr;
+}
+
+bool ArrayNode::isConstant() const
+{
+    return constant;
+}
+
+const shared_ptr<vector<shared_ptr<Value>>> &ArrayNode::getConstantValues() const
+{
+    return constantValues;
+}
+
+void ArrayNode::setConstantValues(const shared_ptr<vector<shared_ptr<Value>>> &values)
+{
+    constantValues = values;
+}
+
 bool ArrayNode::isLval() const
 {
     return true; // Arrays are lvalues
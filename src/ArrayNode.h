@@ -11,6 +11,8 @@ using std::shared_ptr;
 using std::vector;
 using std::string;
 
+class Value; // forward declaration
+
 class ArrayNode : public ExpressionNode
 {
 public:
@@ -19,10 +21,21 @@ public:
     ArrayNode(const vector<shared_ptr<ExpressionNode>> &elements = {});
 
     const vector<shared_ptr<ExpressionNode>> &getElements() const;
+    void setElement(size_t index, shared_ptr<ExpressionNode> element);
+
+    // true when every element is a number, string, boolean or null literal
+    bool isConstant() const;
+
+    // values of a constant literal, kept by the interpreter after the first
+    // evaluation so arrays built from it can share them
+    const shared_ptr<vector<shared_ptr<Value>>> &getConstantValues() const;
+    void setConstantValues(const shared_ptr<vector<shared_ptr<Value>>> &values);
 
     virtual bool isLval() const override;
 
     virtual void visit(Visitor *visitor) override;
 private:
     vector<shared_ptr<ExpressionNode>> elements;
+    shared_ptr<vector<shared_ptr<Value>>> constantValues;
+    bool constant;
 };
\ No newline at end of file
@@ -1,16 +1,21 @@
 #include <vector>
+#include <cmath>
+#include <string_view>
 
 #include "ArrayValue.h"
 #include "Values.h"
 #include "Error.h"
 #include "Environment.h"
 #include "Utils.h"
+#include "Interpreter.h"
+#include "Sort.h"
 
 using std::shared_ptr;
 using std::vector;
 using std::make_shared;
 using std::string;
 using std::dynamic_pointer_cast;
+using std::static_pointer_cast;
 
 #define error(msg, range) \
     rangeError(msg, range, __FILE__, __LINE__)
@@ -18,8 +23,207 @@ using std::dynamic_pointer_cast;
 #define errorAt(msg, location, range) \
     locationRangeError(msg, location, range, __FILE__, __LINE__)
 
-ArrayValue::ArrayValue(const vector<shared_ptr<Value>> &arr, const Range &range)
-    : Value(Type::array, range), elements(arr)
+// Returns how many arguments to pass to a callback: user functions get
+// only as many of (element, index) as they declare, builtins get the element
+static size_t callbackArity(const shared_ptr<Value> &callback, size_t maxArgs)
+{
+    if (callback->getType() != Value::Type::function)
+    {
+        return 1;
+    }
+    auto params = static_pointer_cast<FunctionValue>(callback)->getParameters();
+    size_t declared = params ? static_cast<size_t>(params->getParamCount()) : 0;
+    return std::min(declared, maxArgs);
+}
+
+static bool isCallable(const shared_ptr<Value> &value)
+{
+    return value->getType() == Value::Type::function || value->getType() == Value::Type::builtin;
+}
+
+// Calls callback with (element, index) for count elements of storage starting
+// at offset, passing the result and the element to visit until visit returns
+// false. storage is taken by value, the reference it holds keeps the elements
+// alive and makes a callback that modifies the array write to a copy instead
+// of the storage being iterated. The argument vector is reused between calls.
+template <typename Visit>
+static void forEachCallback(Interpreter &interpreter, shared_ptr<vector<shared_ptr<Value>>> storage, size_t offset, size_t count,
+    const shared_ptr<Value> &callback, const Range &range, Visit visit)
+{
+    size_t arity = callbackArity(callback, 2);
+    vector<shared_ptr<Value>> callArgs(arity);
+    for (size_t i = 0; i < count; ++i)
+    {
+        shared_ptr<Value> element = (*storage)[offset + i];
+        if (arity > 0)
+        {
+            callArgs[0] = element;
+        }
+        if (arity > 1)
+        {
+            callArgs[1] = make_shared<NumberValue>(static_cast<double>(i), range);
+        }
+
+        if (!visit(interpreter.call(callback, callArgs, range), element))
+        {
+            return;
+        }
+    }
+}
+
+// Sorts elements by keys, where keyed[i] holds the key of elements[i] and i.
+// Only the contiguous (key, position) pairs are sorted, the elements are
+// moved once at the end, so no comparison touches a shared_ptr or a cast.
+// Ties are broken by position when stable is set.
+template <typename Key>
+static void sortByKeys(vector<shared_ptr<Value>> &elements, vector<std::pair<Key, size_t>> &keyed, bool stable)
+{
+    auto first = keyed.begin();
+    auto last = keyed.end();
+    if constexpr (std::is_same_v<Key, double>)
+    {
+        // NaN is not ordered, keep it out of the comparisons and put it last
+        last = std::stable_partition(first, last, [](const std::pair<double, size_t> &a) { return !std::isnan(a.first); });
+    }
+
+    if (stable)
+    {
+        Sort::sort(first, last, [](const std::pair<Key, size_t> &a, const std::pair<Key, size_t> &b) { return a < b; });
+    }
+    else
+    {
+        Sort::sort(first, last, [](const std::pair<Key, size_t> &a, const std::pair<Key, size_t> &b) { return a.first < b.first; });
+    }
+
+    vector<shared_ptr<Value>> sorted;
+    sorted.reserve(elements.size());
+    for (const auto &entry : keyed)
+    {
+        sorted.push_back(std::move(elements[entry.second]));
+    }
+    elements.swap(sorted);
+}
+
+// Sorts elements by keys[i], which must be all numbers or all strings,
+// reports an error and returns false otherwise
+static bool sortByValues(vector<shared_ptr<Value>> &elements, const vector<shared_ptr<Value>> &keys, bool stable, const string &name, const Range &range)
+{
+    Value::Type keyType = keys[0]->getType();
+    for (const auto &key : keys)
+    {
+        if (key->getType() != keyType)
+        {
+            errorAt(name + "() requires all sort keys to be of the same type", range.getStart(), range);
+            return false;
+        }
+    }
+
+    if (keyType == Value::Type::number)
+    {
+        vector<std::pair<double, size_t>> keyed(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            keyed[i] = { static_pointer_cast<NumberValue>(keys[i])->getValue(), i };
+        }
+        sortByKeys(elements, keyed, stable);
+        return true;
+    }
+
+    if (keyType == Value::Type::string_)
+    {
+        vector<std::pair<std::string_view, size_t>> keyed(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            keyed[i] = { static_pointer_cast<StringValue>(keys[i])->view(), i };
+        }
+        sortByKeys(elements, keyed, stable);
+        return true;
+    }
+
+    errorAt(name + "() only works with numbers or strings", range.getStart(), range);
+    return false;
+}
+
+ArrayValue::ArrayValue(const vector<shared_ptr<Value>> &arr, const Range &range):
+    Value(Type::array, range),
+    storage(make_shared<vector<shared_ptr<Value>>>(arr)),
+    offset(0),
+    count(arr.size())
+{
+}
+
+ArrayValue::ArrayValue(const shared_ptr<vector<shared_ptr<Value>>> &storage, size_t offset, size_t count, const Range &range):
+    Value(Type::array, range),
+    storage(storage),
+    offset(offset),
+    count(count)
+{
+}
+
+const vector<shared_ptr<Value>> &ArrayValue::getElements() const
+{
+    // a slice gets its own vector the first time the elements are needed
+    // as a whole, the elements themselves are still shared
+    if (offset != 0 || count != storage->size())
+    {
+        storage = make_shared<vector<shared_ptr<Value>>>(begin(), end());
+        offset = 0;
+    }
+    return *storage;
+}
+
+vector<shared_ptr<Value>> &ArrayValue::mutableElements()
+{
+    if (storage.use_count() > 1 || offset != 0 || count != storage->size())
+    {
+        storage = make_shared<vector<shared_ptr<Value>>>(begin(), end());
+        offset = 0;
+    }
+    return *storage;
+}
+
+void ArrayValue::addElement(const shared_ptr<Value> &element)
+{
+    mutableElements().push_back(element);
+    count++;
+}
+
+void ArrayValue::removeElement(int index)
+{
+    auto &elements = mutableElements();
+    elements.erase(elements.begin() + index);
+    count--;
+}
+
+void ArrayValue::clear()
+{
+    mutableElements().clear();
+    count = 0;
+}
+
+void ArrayValue::setElement(int index, const shared_ptr<Value> &value)
+{
+    mutableElements()[index] = value;
+}
+
+shared_ptr<ArrayValue> ArrayValue::slice(size_t start, size_t length, const Range &range) const
+{
+    start = std::min(start, count);
+    length = std::min(length, count - start);
+    return make_shared<ArrayValue>(storage, offset + start, length, range);
+}
+
+shared_ptr<Value> ArrayValue::getMember(const string &name) const
+{
+    // builtins are registered on first use, like strings
+    if (members.empty())
+    {
+        const_cast<ArrayValue *>(this)->registerBuiltins();
+    }
+    return Value::getMember(name);
+}
+
+void ArrayValue::registerBuiltins()
 {
     addMember("push", make_shared<BuiltinFunctionValue>(
         [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
@@ -34,7 +238,9 @@ ArrayValue::ArrayValue(const vector<shared_ptr<Value>> &arr, const Range &range)
                     return nullptr;
                 }
             }
+            auto &elements = mutableElements();
             elements.insert(elements.end(), args.begin(), args.end());
+            count = elements.size();
             return make_shared<NullValue>(range);
         },
         getRange()
@@ -50,12 +256,12 @@ ArrayValue::ArrayValue(const vector<shared_ptr<Value>> &arr, const Range &range)
                 errorAt("pop() does not take any arguments", args[0]->getRange().getStart(), range);
                 return nullptr;
             }
-            if (elements.empty())
+            if (isEmpty())
             {
                 return make_shared<NullValue>(range); // Return null if the array is empty
             }
-            auto lastElement = elements.back();
-            elements.pop_back();
+            auto lastElement = getElement(getElementCount() - 1);
+            removeElement(getElementCount() - 1);
             return lastElement;
         },
         getRange()
@@ -71,7 +277,7 @@ ArrayValue::ArrayValue(const vector<shared_ptr<Value>> &arr, const Range &range)
                 errorAt("length() does not take any arguments", args[0]->getRange().getStart(), range);
                 return nullptr;
             }
-            return make_shared<NumberValue>(static_cast<double>(elements.size()), range);
+            return make_shared<NumberValue>(static_cast<double>(count), range);
         },
         getRange()
     ), true);
@@ -86,7 +292,7 @@ ArrayValue::ArrayValue(const vector<shared_ptr<Value>> &arr, const Range &range)
                 errorAt("clear() does not take any arguments", args[0]->getRange().getStart(), range);
                 return nullptr;
             }
-            elements.clear();
+            clear();
             return make_shared<NullValue>(range);
         },
         getRange()
@@ -102,7 +308,7 @@ ArrayValue::ArrayValue(const vector<shared_ptr<Value>> &arr, const Range &range)
                 errorAt("empty() does not take any arguments", args[0]->getRange().getStart(), range);
                 return nullptr;
             }
-            return make_shared<BooleanValue>(elements.empty(), range);
+            return make_shared<BooleanValue>(isEmpty(), range);
         },
         getRange()
     ), true);
@@ -231,10 +437,10 @@ ArrayValue::ArrayValue(const vector<shared_ptr<Value>> &arr, const Range &range)
             }
 
             string result;
-            for (size_t i = 0; i < elements.size(); ++i)
+            for (size_t i = 0; i < count; ++i)
             {
-                result += elements[i]->toString();
-                if (i + 1 < elements.size())
+                result += getElement(static_cast<int>(i))->toString();
+                if (i + 1 < count)
                 {
                     result += separatorStr;
                 }
@@ -247,22 +453,56 @@ ArrayValue::ArrayValue(const vector<shared_ptr<Value>> &arr, const Range &range)
     addMember("sort", make_shared<BuiltinFunctionValue>(
         [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
         {
-            UNUSED(interpreter);
             UNUSED(env);
-            if (!args.empty())
+            if (args.size() > 1)
             {
-                errorAt("sort() does not take any arguments", args[0]->getRange().getStart(), range);
+                errorAt("sort() expects at most one argument", args[1]->getRange().getStart(), range);
                 return nullptr;
             }
 
-            if (elements.empty())
+            if (isEmpty())
+            {
+                return make_shared<NullValue>(range);
+            }
+
+            if (args.size() == 1)
             {
+                if (!isCallable(args[0]))
+                {
+                    errorAt("sort() expects a comparison function, but got " + args[0]->typeAsString(), args[0]->getRange().getStart(), range);
+                    return nullptr;
+                }
+
+                // cmp(a, b) returns a negative number or true when a goes before b.
+                // stable_sort tolerates comparators that are not a strict weak
+                // ordering, std::sort could read out of bounds with one
+                const auto &cmp = args[0];
+                vector<shared_ptr<Value>> sorted(begin(), end());
+                vector<shared_ptr<Value>> pair(2);
+                std::stable_sort(sorted.begin(), sorted.end(),
+                          [&](const shared_ptr<Value>& a, const shared_ptr<Value>& b)
+                          {
+                              pair[0] = a;
+                              pair[1] = b;
+                              auto result = interpreter.call(cmp, pair, range);
+                              if (!result)
+                              {
+                                  return false;
+                              }
+                              if (result->getType() == Value::Type::number)
+                              {
+                                  return static_pointer_cast<NumberValue>(result)->getValue() < 0;
+                              }
+                              return result->toBoolean();
+                          });
+
+                mutableElements() = std::move(sorted);
                 return make_shared<NullValue>(range);
             }
 
             // Check that all elements are of the same type
-            Value::Type firstType = elements[0]->getType();
-            for (const auto& element : elements)
+            Value::Type firstType = getElement(0)->getType();
+            for (const auto& element : *this)
             {
                 if (element->getType() != firstType)
                 {
@@ -278,28 +518,274 @@ ArrayValue::ArrayValue(const vector<shared_ptr<Value>> &arr, const Range &range)
                 return nullptr;
             }
 
-            if (firstType == Value::Type::number)
+            // the elements are their own keys, copied since sorting moves the elements
+            vector<shared_ptr<Value>> keys(begin(), end());
+            if (!sortByValues(mutableElements(), keys, false, "sort", range))
             {
-                std::sort(elements.begin(), elements.end(),
-                          [](const shared_ptr<Value>& a, const shared_ptr<Value>& b) 
-                          {
-                              auto numA = dynamic_pointer_cast<NumberValue>(a);
-                              auto numB = dynamic_pointer_cast<NumberValue>(b);
-                              return numA->getValue() < numB->getValue();
-                          });
+                return nullptr;
             }
-            else // firstType == Value::Type::string_
+
+            return nullptr; // Return null to indicate success
+        },
+        getRange()
+    ), true);
+
+    addMember("slice", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (args.empty() || args.size() > 2)
             {
-                std::sort(elements.begin(), elements.end(),
-                          [](const shared_ptr<Value>& a, const shared_ptr<Value>& b) 
-                          {
-                              auto strA = dynamic_pointer_cast<StringValue>(a);
-                              auto strB = dynamic_pointer_cast<StringValue>(b);
-                              return strA->getValue() < strB->getValue();
-                          });
+                errorAt("slice() expects one or two arguments", range.getStart(), range);
+                return nullptr;
             }
 
-            return nullptr; // Return null to indicate success
+            double bounds[2] = { 0, static_cast<double>(count) };
+            for (size_t i = 0; i < args.size(); ++i)
+            {
+                auto index = dynamic_pointer_cast<NumberValue>(args[i]);
+                if (!index)
+                {
+                    errorAt("slice() expects number arguments", args[i]->getRange().getStart(), range);
+                    return nullptr;
+                }
+
+                // negative indices count back from the end of the array
+                double value = index->getValue();
+                if (!std::isfinite(value))
+                {
+                    errorAt("slice() expects finite number arguments", args[i]->getRange().getStart(), range);
+                    return nullptr;
+                }
+                if (value < 0)
+                {
+                    value += static_cast<double>(count);
+                }
+                bounds[i] = std::clamp(value, 0.0, static_cast<double>(count));
+            }
+
+            size_t start = static_cast<size_t>(bounds[0]);
+            size_t end = static_cast<size_t>(bounds[1]);
+            return slice(start, end > start ? end - start : 0, range);
+        },
+        getRange()
+    ), true);
+
+    // sortBy(keyFn, [stable]) -> null, sorts by the number or string keyFn(element, index)
+    // returns, keyFn is called once per element
+    addMember("sortBy", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(env);
+            if (args.empty() || args.size() > 2 || !isCallable(args[0]))
+            {
+                errorAt("sortBy() expects a key function and an optional stable flag", range.getStart(), range);
+                return nullptr;
+            }
+
+            bool stable = args.size() == 2 && args[1]->toBoolean();
+            if (isEmpty())
+            {
+                return make_shared<NullValue>(range);
+            }
+
+            vector<shared_ptr<Value>> keys;
+            keys.reserve(count);
+            forEachCallback(interpreter, storage, offset, count, args[0], range,
+                [&](const shared_ptr<Value> &key, const shared_ptr<Value> &element)
+                {
+                    UNUSED(element);
+                    keys.push_back(key ? key : make_shared<NullValue>(range));
+                    return true;
+                });
+
+            if (keys.size() != count)
+            {
+                errorAt("sortBy() key function must not change the array's length", range.getStart(), range);
+                return nullptr;
+            }
+
+            if (!sortByValues(mutableElements(), keys, stable, "sortBy", range))
+            {
+                return nullptr;
+            }
+            return make_shared<NullValue>(range);
+        },
+        getRange()
+    ), true);
+
+    // map(fn) -> new array of fn(element, index)
+    addMember("map", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(env);
+            if (args.size() != 1 || !isCallable(args[0]))
+            {
+                errorAt("map() expects a function argument", range.getStart(), range);
+                return nullptr;
+            }
+
+            auto result = make_shared<vector<shared_ptr<Value>>>();
+            result->reserve(count);
+            forEachCallback(interpreter, storage, offset, count, args[0], range,
+                [&](const shared_ptr<Value> &mapped, const shared_ptr<Value> &element)
+                {
+                    UNUSED(element);
+                    result->push_back(mapped ? mapped : make_shared<NullValue>(range));
+                    return true;
+                });
+            return make_shared<ArrayValue>(result, 0, result->size(), range);
+        },
+        getRange()
+    ), true);
+
+    // filter(fn) -> new array of the elements for which fn(element, index) is truthy
+    addMember("filter", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(env);
+            if (args.size() != 1 || !isCallable(args[0]))
+            {
+                errorAt("filter() expects a function argument", range.getStart(), range);
+                return nullptr;
+            }
+
+            auto result = make_shared<vector<shared_ptr<Value>>>();
+            forEachCallback(interpreter, storage, offset, count, args[0], range,
+                [&](const shared_ptr<Value> &keep, const shared_ptr<Value> &element)
+                {
+                    if (keep && keep->toBoolean())
+                    {
+                        result->push_back(element);
+                    }
+                    return true;
+                });
+            return make_shared<ArrayValue>(result, 0, result->size(), range);
+        },
+        getRange()
+    ), true);
+
+    // reduce(fn, [initial]) -> fn(accumulator, element, index) folded over the array
+    addMember("reduce", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(env);
+            if (args.empty() || args.size() > 2 || !isCallable(args[0]))
+            {
+                errorAt("reduce() expects a function and an optional initial value", range.getStart(), range);
+                return nullptr;
+            }
+
+            // without an initial value the first element starts the accumulator
+            size_t first = 0;
+            shared_ptr<Value> accumulator;
+            if (args.size() == 2)
+            {
+                accumulator = args[1];
+            }
+            else if (isEmpty())
+            {
+                errorAt("reduce() of an empty array needs an initial value", range.getStart(), range);
+                return nullptr;
+            }
+            else
+            {
+                accumulator = getElement(0);
+                first = 1;
+            }
+
+            auto snapshot = storage;
+            size_t start = offset;
+            size_t n = count;
+            size_t arity = callbackArity(args[0], 3);
+            vector<shared_ptr<Value>> callArgs(arity);
+            for (size_t i = first; i < n; ++i)
+            {
+                if (arity > 0)
+                {
+                    callArgs[0] = accumulator;
+                }
+                if (arity > 1)
+                {
+                    callArgs[1] = (*snapshot)[start + i];
+                }
+                if (arity > 2)
+                {
+                    callArgs[2] = make_shared<NumberValue>(static_cast<double>(i), range);
+                }
+
+                accumulator = interpreter.call(args[0], callArgs, range);
+                if (!accumulator)
+                {
+                    accumulator = make_shared<NullValue>(range);
+                }
+            }
+            return accumulator;
+        },
+        getRange()
+    ), true);
+
+    // forEach(fn) -> null, calls fn(element, index) for every element
+    addMember("forEach", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(env);
+            if (args.size() != 1 || !isCallable(args[0]))
+            {
+                errorAt("forEach() expects a function argument", range.getStart(), range);
+                return nullptr;
+            }
+
+            forEachCallback(interpreter, storage, offset, count, args[0], range,
+                [](const shared_ptr<Value> &, const shared_ptr<Value> &) { return true; });
+            return make_shared<NullValue>(range);
+        },
+        getRange()
+    ), true);
+
+    // any(fn) -> true if fn(element, index) is truthy for some element, stops at the first one
+    addMember("any", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(env);
+            if (args.size() != 1 || !isCallable(args[0]))
+            {
+                errorAt("any() expects a function argument", range.getStart(), range);
+                return nullptr;
+            }
+
+            bool found = false;
+            forEachCallback(interpreter, storage, offset, count, args[0], range,
+                [&](const shared_ptr<Value> &result, const shared_ptr<Value> &)
+                {
+                    found = result && result->toBoolean();
+                    return !found;
+                });
+            return make_shared<BooleanValue>(found, range);
+        },
+        getRange()
+    ), true);
+
+    // all(fn) -> true if fn(element, index) is truthy for every element, stops at the first that is not
+    addMember("all", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(env);
+            if (args.size() != 1 || !isCallable(args[0]))
+            {
+                errorAt("all() expects a function argument", range.getStart(), range);
+                return nullptr;
+            }
+
+            bool every = true;
+            forEachCallback(interpreter, storage, offset, count, args[0], range,
+                [&](const shared_ptr<Value> &result, const shared_ptr<Value> &)
+                {
+                    every = result && result->toBoolean();
+                    return every;
+                });
+            return make_shared<BooleanValue>(every, range);
         },
         getRange()
     ), true);
@@ -307,16 +793,16 @@ ArrayValue::ArrayValue(const vector<shared_ptr<Value>> &arr, const Range &range)
 
 string ArrayValue::toString() const
 {
-    if (elements.empty())
+    if (isEmpty())
     {
         return "[]";
     }
 
     string result = "[";
-    for (size_t i = 0; i < elements.size(); ++i)
+    for (size_t i = 0; i < count; ++i)
     {
-        result += elements[i]->toString();
-        if (i + 1 < elements.size())
+        result += getElement(static_cast<int>(i))->toString();
+        if (i + 1 < count)
         {
             result += ", ";
         }
@@ -327,7 +813,7 @@ string ArrayValue::toString() const
 
 bool ArrayValue::toBoolean() const
 {
-    return !elements.empty();
+    return !isEmpty();
 }
 
 string ArrayValue::typeAsString() const
@@ -337,14 +823,14 @@ string ArrayValue::typeAsString() const
 
 shared_ptr<Value> ArrayValue::eq(const shared_ptr<ArrayValue> &other) const
 {
-    if (elements.size() != (size_t)other->getElementCount())
+    if (count != (size_t)other->getElementCount())
     {
         return make_shared<BooleanValue>(false, Range(getRange().getStart(), other->getRange().getEnd()));
     }
 
-    for (size_t i = 0; i < elements.size(); ++i)
+    for (size_t i = 0; i < count; ++i)
     {
-        if (!elements[i]->eq(other->getElement(i)))
+        if (!getElement(static_cast<int>(i))->eq(other->getElement(i)))
         {
             return make_shared<BooleanValue>(false, Range(getRange().getStart(), other->getRange().getEnd()));
         }
@@ -360,14 +846,14 @@ shared_ptr<Value> ArrayValue::eq(const shared_ptr<NullValue> &other) const
 
 shared_ptr<Value> ArrayValue::ne(const shared_ptr<ArrayValue> &other) const
 {
-    if (elements.size() != (size_t)other->getElementCount())
+    if (count != (size_t)other->getElementCount())
     {
         return make_shared<BooleanValue>(true, Range(getRange().getStart(), other->getRange().getEnd()));
     }
 
-    for (size_t i = 0; i < elements.size(); ++i)
+    for (size_t i = 0; i < count; ++i)
     {
-        if (!elements[i]->ne(other->getElement(i)))
+        if (!getElement(static_cast<int>(i))->ne(other->getElement(i)))
         {
             return make_shared<BooleanValue>(false, Range(getRange().getStart(), other->getRange().getEnd()));
         }
@@ -383,58 +869,58 @@ shared_ptr<Value> ArrayValue::ne(const shared_ptr<NullValue> &other) const
 
 shared_ptr<Value> ArrayValue::add(const shared_ptr<NumberValue> &other) const
 {
-    vector<shared_ptr<Value>> newElements = elements;
+    vector<shared_ptr<Value>> newElements(begin(), end());
     newElements.emplace_back(other);
     return make_shared<ArrayValue>(newElements, Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
 shared_ptr<Value> ArrayValue::add(const shared_ptr<StringValue> &other) const
 {
-    vector<shared_ptr<Value>> newElements = elements;
+    vector<shared_ptr<Value>> newElements(begin(), end());
     newElements.emplace_back(other);
     return make_shared<ArrayValue>(newElements, Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
 shared_ptr<Value> ArrayValue::add(const shared_ptr<BooleanValue> &other) const
 {
-    vector<shared_ptr<Value>> newElements = elements;
+    vector<shared_ptr<Value>> newElements(begin(), end());
     newElements.emplace_back(other);
     return make_shared<ArrayValue>(newElements, Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
 shared_ptr<Value> ArrayValue::add(const shared_ptr<ArrayValue> &other) const
 {
-    vector<shared_ptr<Value>> newElements = elements;
+    vector<shared_ptr<Value>> newElements(begin(), end());
     //newElements.push_back(other); // uncomment this for the += to do nesting arrays ( [1, 2] += [3, 4] would result in [1, 2, [3, 4]] )
     // if you want to flatten the array, use the line below instead ( [1, 2] += [3, 4] would result in [1, 2, 3, 4] )
-    newElements.insert(newElements.end(), other->getElements().begin(), other->getElements().end());
+    newElements.insert(newElements.end(), other->begin(), other->end());
     return make_shared<ArrayValue>(newElements, Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
 shared_ptr<Value> ArrayValue::add(const shared_ptr<FunctionValue> &other) const
 {
-    vector<shared_ptr<Value>> newElements = elements;
+    vector<shared_ptr<Value>> newElements(begin(), end());
     newElements.emplace_back(other);
     return make_shared<ArrayValue>(newElements, Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
 shared_ptr<Value> ArrayValue::add(const shared_ptr<BuiltinFunctionValue> &other) const
 {
-    vector<shared_ptr<Value>> newElements = elements;
+    vector<shared_ptr<Value>> newElements(begin(), end());
     newElements.emplace_back(other);
     return make_shared<ArrayValue>(newElements, Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
 shared_ptr<Value> ArrayValue::add(const shared_ptr<NullValue> &other) const
 {
-    vector<shared_ptr<Value>> newElements = elements;
+    vector<shared_ptr<Value>> newElements(begin(), end());
     newElements.emplace_back(other);
     return make_shared<ArrayValue>(newElements, Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
 shared_ptr<Value> ArrayValue::add(const shared_ptr<ObjectValue> &other) const
 {
-    vector<shared_ptr<Value>> newElements = elements;
+    vector<shared_ptr<Value>> newElements(begin(), end());
     newElements.emplace_back(other);
     return make_shared<ArrayValue>(newElements, Range(getRange().getStart(), other->getRange().getEnd()));
 }
\ No newline at end of file
@@ -13,19 +13,27 @@ class ArrayValue : public Value
 public:
     ArrayValue(const vector<shared_ptr<Value>> &arr, const Range &range = {});
 
-    inline const vector<shared_ptr<Value>> &getElements() const { return elements; }
-    inline shared_ptr<Value> getElement(int index) const { return elements[index]; }
-    inline void addElement(const shared_ptr<Value> &element) { elements.push_back(element); }
-    inline void removeElement(int index) { elements.erase(elements.begin() + index); }
-    inline int getElementCount() const { return static_cast<int>(elements.size()); }
-    inline bool isEmpty() const { return elements.empty(); }
-    inline void clear() { elements.clear(); }
-    inline void setElement(int index, const shared_ptr<Value> &value) { elements[index] = value; }
+    // Shares count elements of storage starting at offset. The storage is
+    // copied before the first write if anything else still refers to it.
+    ArrayValue(const shared_ptr<vector<shared_ptr<Value>>> &storage, size_t offset, size_t count, const Range &range = {});
+
+    void registerBuiltins();
+
+    const vector<shared_ptr<Value>> &getElements() const;
+    inline vector<shared_ptr<Value>>::const_iterator begin() const { return storage->cbegin() + offset; }
+    inline vector<shared_ptr<Value>>::const_iterator end() const { return storage->cbegin() + offset + count; }
+    inline shared_ptr<Value> getElement(int index) const { return (*storage)[offset + index]; }
+    void addElement(const shared_ptr<Value> &element);
+    void removeElement(int index);
+    inline int getElementCount() const { return static_cast<int>(count); }
+    inline bool isEmpty() const { return count == 0; }
+    void clear();
+    void setElement(int index, const shared_ptr<Value> &value);
     inline int find(const shared_ptr<Value> &value) const
     {
-        for (size_t i = 0; i < elements.size(); ++i)
+        for (size_t i = 0; i < count; ++i)
         {
-            if (elements[i]->eq(value)->toBoolean())
+            if (getElement(static_cast<int>(i))->eq(value)->toBoolean())
             {
                 return static_cast<int>(i);
             }
@@ -33,6 +41,11 @@ public:
         return -1;
     }
 
+    // Returns the elements in [start, start + length) sharing this array's storage
+    shared_ptr<ArrayValue> slice(size_t start, size_t length, const Range &range = {}) const;
+
+    virtual shared_ptr<Value> getMember(const string &name) const override;
+
     string toString() const override;
     bool toBoolean() const override;
 
@@ -55,5 +68,12 @@ public:
     virtual shared_ptr<Value> add(const shared_ptr<ObjectValue> &other) const override;
 
 private:
-    vector<shared_ptr<Value>> elements;
+    // Returns the elements for writing, copying them first if the storage
+    // is shared with a slice or a constant literal
+    vector<shared_ptr<Value>> &mutableElements();
+
+private:
+    mutable shared_ptr<vector<shared_ptr<Value>>> storage;
+    mutable size_t offset;
+    size_t count;
 };
\ No newline at end of file
@@ -55,6 +55,11 @@ shared_ptr<ExpressionNode> AssignNode::getExpr() const
     return expr;
 }
 
+void AssignNode::setExpr(shared_ptr<ExpressionNode> expression)
+{
+    expr = expression;
+}
+
 int AssignNode::getOp() const
 {
     // Return the operator token type, e.g., '=', '+=', etc.
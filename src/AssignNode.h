@@ -32,6 +32,7 @@ public:
 
     shared_ptr<ExpressionNode> getAsignee() const;
     shared_ptr<ExpressionNode> getExpr() const;
+    void setExpr(shared_ptr<ExpressionNode> expression);
 
     int getOp() const;
 
@@ -12,7 +12,8 @@
 BinaryExprNode::BinaryExprNode(shared_ptr<ExpressionNode> left, shared_ptr<OpNode> op, shared_ptr<ExpressionNode> right):
     left(left),
     op(op),
-    right(right)
+    right(right),
+    specialization(Specialization::unspecialized)
 {
     if (left && right)
     {
@@ -35,21 +36,31 @@ BinaryExprNode::BinaryExprNode(shared_ptr<ExpressionNode> left, shared_ptr<OpNod
     }
 }
 
-shared_ptr<ExpressionNode> BinaryExprNode::getLeft() const
+const shared_ptr<ExpressionNode> &BinaryExprNode::getLeft() const
 {
     return left;
 }
 
-shared_ptr<OpNode> BinaryExprNode::getOperator() const
+const shared_ptr<OpNode> &BinaryExprNode::getOperator() const
 {
     return op;
 }
 
-shared_ptr<ExpressionNode> BinaryExprNode::getRight() const
+const shared_ptr<ExpressionNode> &BinaryExprNode::getRight() const
 {
     return right;
 }
 
+void BinaryExprNode::setLeft(shared_ptr<ExpressionNode> expression)
+{
+    left = expression;
+}
+
+void BinaryExprNode::setRight(shared_ptr<ExpressionNode> expression)
+{
+    right = expression;
+}
+
 void BinaryExprNode::visit(Visitor *visitor)
 {
     visitor->visit(this);
@@ -23,16 +23,34 @@ class BinaryExprNode : public ExpressionNode
 {
 public:
     using Ptr = shared_ptr<BinaryExprNode>;
+
+    // What the operands of this expression have turned out to be. A node
+    // starts unspecialized, the first time it runs it becomes a number or
+    // string node if its operands were two of those and its operator has a
+    // fast path for them. The interpreter checks that later operands still
+    // match and turns the node generic for good the first time they don't.
+    enum class Specialization
+    {
+        unspecialized,
+        numbers,
+        strings,
+        generic
+    };
 public:
     BinaryExprNode(shared_ptr<ExpressionNode> left, shared_ptr<OpNode> op, shared_ptr<ExpressionNode> right);
-    shared_ptr<ExpressionNode> getLeft() const;
-    shared_ptr<OpNode> getOperator() const;
-    shared_ptr<ExpressionNode> getRight() const;
+    const shared_ptr<ExpressionNode> &getLeft() const;
+    const shared_ptr<OpNode> &getOperator() const;
+    const shared_ptr<ExpressionNode> &getRight() const;
+    void setLeft(shared_ptr<ExpressionNode> expression);
+    void setRight(shared_ptr<ExpressionNode> expression);
+    Specialization getSpecialization() const { return specialization; }
+    void setSpecialization(Specialization kind) { specialization = kind; }
     void visit(Visitor *visitor) override;
 private:
     shared_ptr<ExpressionNode> left;
     shared_ptr<OpNode> op;
     shared_ptr<ExpressionNode> right;
+    Specialization specialization;
 };
 
 using BinaryExprNodePtr = shared_ptr<BinaryExprNode>;
\ No newline at end of file
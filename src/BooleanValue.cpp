@@ -32,6 +32,16 @@ string BooleanValue::typeAsString() const
     return "boolean";
 }
 
+size_t BooleanValue::hash() const
+{
+    return std::hash<bool>()(getValue());
+}
+
+bool BooleanValue::equals(const Value &other) const
+{
+    return other.getType() == Type::boolean && getValue() == static_cast<const BooleanValue &>(other).getValue();
+}
+
 shared_ptr<Value> BooleanValue::eq(const shared_ptr<BooleanValue> &other) const
 {
     return make_shared<BooleanValue>(value == other->getValue(), Range(getRange().getStart(), other->getRange().getEnd()));
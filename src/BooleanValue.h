@@ -15,6 +15,8 @@ public:
     string toString() const override;
     bool toBoolean() const override;
     virtual string typeAsString() const override;
+    virtual size_t hash() const override;
+    virtual bool equals(const Value &other) const override;
 public:
     virtual shared_ptr<Value> eq(const shared_ptr<BooleanValue> &other) const override;
     virtual shared_ptr<Value> eq(const shared_ptr<NumberValue> &other) const override;
@@ -5,6 +5,8 @@
 #include <limits>
 #include <stdexcept>
 #include <ios>
+#include <algorithm>
+#include <cmath>
 
 #include "Builtins.h"
 #include "Environment.h"
@@ -32,17 +34,14 @@ using std::string;
 using std::dynamic_pointer_cast;
 using std::to_string;
 using std::getline;
-using std::stod;
-using std::invalid_argument;
 using std::numeric_limits;
 using std::streamsize;
 
 #define error(msg, range) \
     rangeError(msg, range, __FILE__, __LINE__)
 
-shared_ptr<Value> Builtins::print(Interpreter &interpreter, const vector<shared_ptr<Value>> &args, shared_ptr<Environment> env, const Range &range)
+shared_ptr<Value> Builtins::print(Interpreter &interpreter, Arguments args, const Range &range)
 {
-    UNUSED(env);
     UNUSED(range);
 
     if (args.empty())
@@ -71,13 +70,10 @@ shared_ptr<Value> Builtins::print(Interpreter &interpreter, const vector<shared_
             interpreter.setEnvironment(stringMethod->getEnvironment());
             try
             {
-                stringMethod->getBody()->visit(&interpreter);
-            }
-            catch (const ReturnException &e)
-            {
-                if (e.value)
+                auto value = interpreter.runBody(stringMethod->getBody());
+                if (value)
                 {
-                    cout << e.value->toString();
+                    cout << value->toString();
                 }
             }
             catch (const ErrorException &e)
@@ -105,10 +101,9 @@ shared_ptr<Value> Builtins::print(Interpreter &interpreter, const vector<shared_
     return nullptr; // return nullptr to prevent printing "null" in interactive mode
 }
 
-shared_ptr<Value> Builtins::println(Interpreter &interpreter, const vector<shared_ptr<Value>> &args, shared_ptr<Environment> env, const Range &range)
+shared_ptr<Value> Builtins::println(Interpreter &interpreter, Arguments args, const Range &range)
 {
     UNUSED(interpreter);
-    UNUSED(env);
     UNUSED(range);
 
     for (size_t i = 0; i < args.size(); ++i)
@@ -132,13 +127,10 @@ shared_ptr<Value> Builtins::println(Interpreter &interpreter, const vector<share
             interpreter.setEnvironment(stringMethod->getEnvironment());
             try
             {
-                stringMethod->getBody()->visit(&interpreter);
-            }
-            catch (const ReturnException &e)
-            {
-                if (e.value)
+                auto value = interpreter.runBody(stringMethod->getBody());
+                if (value)
                 {
-                    cout << e.value->toString();
+                    cout << value->toString();
                 }
             }
             catch (const ErrorException &e)
@@ -205,10 +197,9 @@ shared_ptr<Value> Builtins::printf(Interpreter &interpreter, const vector<shared
     return nullptr;
 }
 
-shared_ptr<Value> Builtins::type(Interpreter &interpreter, const vector<shared_ptr<Value>> &args, shared_ptr<Environment> env, const Range &range)
+shared_ptr<Value> Builtins::type(Interpreter &interpreter, Arguments args, const Range &range)
 {
     UNUSED(interpreter);
-    UNUSED(env);
 
     if (args.size() != 1)
     {
@@ -298,10 +289,9 @@ shared_ptr<Value> Builtins::input(Interpreter &interpreter, const vector<shared_
     return make_shared<StringValue>(userInput, range);
 }
 
-shared_ptr<Value> Builtins::len(Interpreter &interpreter, const vector<shared_ptr<Value>> &args, shared_ptr<Environment> env, const Range &range)
+shared_ptr<Value> Builtins::len(Interpreter &interpreter, Arguments args, const Range &range)
 {
     UNUSED(interpreter);
-    UNUSED(env);
 
     if (args.size() != 1)
     {
@@ -337,6 +327,17 @@ shared_ptr<Value> Builtins::len(Interpreter &interpreter, const vector<shared_pt
             }
             return make_shared<NumberValue>(arrayVal->getElementCount(), range);
         }
+        case Value::Type::typed_array:
+        {
+            auto typedVal = dynamic_pointer_cast<TypedArrayValue>(arg);
+            return make_shared<NumberValue>(typedVal->length(), range);
+        }
+        case Value::Type::deque:
+            return make_shared<NumberValue>(dynamic_pointer_cast<DequeValue>(arg)->length(), range);
+        case Value::Type::set:
+            return make_shared<NumberValue>(dynamic_pointer_cast<SetValue>(arg)->length(), range);
+        case Value::Type::priority_queue:
+            return make_shared<NumberValue>(dynamic_pointer_cast<PriorityQueueValue>(arg)->length(), range);
         case Value::Type::null:
             return make_shared<NumberValue>(0, range);
         default:
@@ -346,10 +347,9 @@ shared_ptr<Value> Builtins::len(Interpreter &interpreter, const vector<shared_pt
 }
 
 // attempts to convert the first argument to a number if it fails it returns NullValue, but not nullptr
-shared_ptr<Value> Builtins::toNumber(Interpreter &interpreter, const vector<shared_ptr<Value>> &args, shared_ptr<Environment> env, const Range &range)
+shared_ptr<Value> Builtins::toNumber(Interpreter &interpreter, Arguments args, const Range &range)
 {
     UNUSED(interpreter);
-    UNUSED(env);
 
     if (args.size() != 1)
     {
@@ -368,21 +368,17 @@ shared_ptr<Value> Builtins::toNumber(Interpreter &interpreter, const vector<shar
         return arg; // already a number
     }
 
-    try
-    {
-        double value = stod(arg->toString());
-        return make_shared<NumberValue>(value, range);
-    }
-    catch (const invalid_argument &)
+    auto number = NumberValue::parse(arg->toString(), range);
+    if (!number)
     {
         return make_shared<NullValue>(range); // conversion failed
     }
+    return number;
 }
 
-shared_ptr<Value> Builtins::toString(Interpreter &interpreter, const vector<shared_ptr<Value>> &args, shared_ptr<Environment> env, const Range &range)
+shared_ptr<Value> Builtins::toString(Interpreter &interpreter, Arguments args, const Range &range)
 {
     UNUSED(interpreter);
-    UNUSED(env);
 
     if (args.size() != 1)
     {
@@ -408,17 +404,10 @@ shared_ptr<Value> Builtins::toString(Interpreter &interpreter, const vector<shar
 
         auto oldEnv = interpreter.getEnvironment();
         interpreter.setEnvironment(stringMethod->getEnvironment());
+        shared_ptr<Value> value;
         try
         {
-            stringMethod->getBody()->visit(&interpreter);
-        }
-        catch (const ReturnException &e)
-        {
-            if (e.value)
-            {
-                interpreter.setEnvironment(oldEnv); // restore the environment after visiting the method
-                return make_shared<StringValue>(e.value->toString(), arg->getRange());
-            }
+            value = interpreter.runBody(stringMethod->getBody());
         }
         catch (const ErrorException &e)
         {
@@ -427,6 +416,12 @@ shared_ptr<Value> Builtins::toString(Interpreter &interpreter, const vector<shar
             error(e.what(), e.getRange());
             return nullptr;
         }
+
+        interpreter.setEnvironment(oldEnv); // restore the environment after visiting the method
+        if (value)
+        {
+            return make_shared<StringValue>(value->toString(), arg->getRange());
+        }
     }
 
     return make_shared<StringValue>(arg->toString(), arg->getRange());
@@ -1033,17 +1028,22 @@ shared_ptr<Value> Builtins::runShellCommand(Interpreter &interpreter, const vect
         dup2(pipefd[1], STDERR_FILENO); // redirect stderr to the pipe
         Utils::closeFd(pipefd[1]); // close write end of the pipe after duplicating
 
-        // split command into argv format
-        vector<char*> argv;
+        // split command into argv format, the tokens outlive the exec
+        vector<string> tokens;
         string commandCopy = command;
         size_t pos = 0;
         while ((pos = commandCopy.find(' ')) != string::npos)
         {
-            string token = commandCopy.substr(0, pos);
-            argv.push_back(const_cast<char*>(token.c_str()));
+            tokens.push_back(commandCopy.substr(0, pos));
             commandCopy.erase(0, pos + 1);
         }
-        argv.push_back(const_cast<char*>(commandCopy.c_str())); // last token
+        tokens.push_back(commandCopy); // last token
+
+        vector<char*> argv;
+        for (auto &token : tokens)
+        {
+            argv.push_back(const_cast<char*>(token.c_str()));
+        }
         argv.push_back(nullptr); // null-terminate the argv array
         if (argv.empty() || argv[0] == nullptr)
         {
@@ -1369,9 +1369,8 @@ shared_ptr<Value> Builtins::getenv(Interpreter &interpreter, const vector<shared
     return make_shared<NullValue>(range);
 }
 
-shared_ptr<Value> Builtins::dumpstack(Interpreter &interpreter, const vector<shared_ptr<Value>> &args, shared_ptr<Environment> env, const Range &range)
+shared_ptr<Value> Builtins::dumpstack(Interpreter &interpreter, Arguments args, const Range &range)
 {
-    UNUSED(env);
     UNUSED(range);
 
     string format = "table"; // default format
@@ -1407,3 +1406,383 @@ shared_ptr<Value> Builtins::dumpstack(Interpreter &interpreter, const vector<sha
 
     return nullptr; // this function is for debugging purposes, it dumps the stack trace to the standard output
 }
+
+// the most elements a typed array or matrix can be made with
+static const double MAX_ELEMENTS = 4294967296.0;
+
+// reads a count of elements, false unless it is a whole number from 0 to
+// MAX_ELEMENTS, checked before it is converted so the conversion is defined
+static bool readCount(const shared_ptr<Value> &arg, size_t &count)
+{
+    auto number = dynamic_pointer_cast<NumberValue>(arg);
+    if (!number->isWhole() || number->getValue() < 0 || number->getValue() > MAX_ELEMENTS)
+    {
+        return false;
+    }
+    count = static_cast<size_t>(number->getValue());
+    return true;
+}
+
+// builds a typed array from a length (zero filled), an array of numbers or another typed array
+static shared_ptr<Value> makeTypedArray(TypedArrayValue::ElementType elementType, const string &name, const vector<shared_ptr<Value>> &args, const Range &range)
+{
+    if (args.size() != 1)
+    {
+        error(name + "() expects exactly 1 argument, but got " + to_string(args.size()), range);
+        return nullptr;
+    }
+
+    const auto &arg = args[0];
+    switch (arg->getType())
+    {
+        case Value::Type::number:
+        {
+            size_t length = 0;
+            if (!readCount(arg, length))
+            {
+                error(name + "() length must be a non-negative integer no larger than " + NumberValue::format(MAX_ELEMENTS) + ", but got " + arg->toString(), arg->getRange());
+                return nullptr;
+            }
+            return make_shared<TypedArrayValue>(elementType, length, range);
+        }
+        case Value::Type::array:
+        {
+            auto arrayVal = dynamic_pointer_cast<ArrayValue>(arg);
+            auto result = make_shared<TypedArrayValue>(elementType, arrayVal->getElementCount(), range);
+            for (int i = 0; i < arrayVal->getElementCount(); ++i)
+            {
+                auto element = arrayVal->getElement(i);
+                if (element->getType() != Value::Type::number)
+                {
+                    error(name + "() expects an array of numbers, but element " + to_string(i) + " is " + element->typeAsString(), arg->getRange());
+                    return nullptr;
+                }
+                auto value = dynamic_pointer_cast<NumberValue>(element);
+                if (!result->set(i, *value))
+                {
+                    error(TypedArrayValue::rangeMessage(value->getValue()) + " at element " + to_string(i), arg->getRange());
+                    return nullptr;
+                }
+            }
+            return result;
+        }
+        case Value::Type::typed_array:
+        {
+            auto source = dynamic_pointer_cast<TypedArrayValue>(arg);
+            auto result = make_shared<TypedArrayValue>(elementType, source->length(), range);
+            if (elementType == TypedArrayValue::ElementType::int64 && source->getElementType() == elementType)
+            {
+                result->getInts() = source->getInts();
+                return result;
+            }
+            for (size_t i = 0; i < source->length(); ++i)
+            {
+                if (!result->set(i, source->get(i)))
+                {
+                    error(TypedArrayValue::rangeMessage(source->get(i)) + " at element " + to_string(i), arg->getRange());
+                    return nullptr;
+                }
+            }
+            return result;
+        }
+        default:
+            error(name + "() expects a length or an array, but got " + arg->typeAsString(), arg->getRange());
+            return nullptr;
+    }
+}
+
+shared_ptr<Value> Builtins::float64Array(Interpreter &interpreter, const vector<shared_ptr<Value>> &args, shared_ptr<Environment> env, const Range &range)
+{
+    UNUSED(interpreter);
+    UNUSED(env);
+
+    return makeTypedArray(TypedArrayValue::ElementType::float64, "Float64Array", args, range);
+}
+
+shared_ptr<Value> Builtins::int64Array(Interpreter &interpreter, const vector<shared_ptr<Value>> &args, shared_ptr<Environment> env, const Range &range)
+{
+    UNUSED(interpreter);
+    UNUSED(env);
+
+    return makeTypedArray(TypedArrayValue::ElementType::int64, "Int64Array", args, range);
+}
+
+// reads a matrix dimension, a non-negative whole number
+static bool readDimension(const shared_ptr<Value> &arg, size_t &dimension)
+{
+    if (arg->getType() != Value::Type::number)
+    {
+        error("Matrix() dimensions must be numbers, but got " + arg->typeAsString(), arg->getRange());
+        return false;
+    }
+
+    if (!readCount(arg, dimension))
+    {
+        error("Matrix() dimensions must be non-negative integers no larger than " + NumberValue::format(MAX_ELEMENTS) + ", but got " + arg->toString(), arg->getRange());
+        return false;
+    }
+    return true;
+}
+
+// Matrix(rows, cols, [fill]) or Matrix(rows) where rows is an array of equal length arrays of numbers
+shared_ptr<Value> Builtins::matrix(Interpreter &interpreter, const vector<shared_ptr<Value>> &args, shared_ptr<Environment> env, const Range &range)
+{
+    UNUSED(interpreter);
+    UNUSED(env);
+
+    if (args.size() == 1)
+    {
+        if (args[0]->getType() != Value::Type::array)
+        {
+            error("Matrix() expects dimensions or an array of rows, but got " + args[0]->typeAsString(), args[0]->getRange());
+            return nullptr;
+        }
+
+        auto rowsVal = dynamic_pointer_cast<ArrayValue>(args[0]);
+        size_t rows = rowsVal->getElementCount();
+        size_t cols = 0;
+        shared_ptr<MatrixValue> result;
+        for (size_t i = 0; i < rows; ++i)
+        {
+            auto rowVal = dynamic_pointer_cast<ArrayValue>(rowsVal->getElement(i));
+            if (!rowVal)
+            {
+                error("Matrix() expects an array of rows, but row " + to_string(i) + " is " + rowsVal->getElement(i)->typeAsString(), args[0]->getRange());
+                return nullptr;
+            }
+
+            if (i == 0)
+            {
+                cols = rowVal->getElementCount();
+                result = make_shared<MatrixValue>(rows, cols, range);
+            }
+            else if (static_cast<size_t>(rowVal->getElementCount()) != cols)
+            {
+                error("Matrix() rows must all have the same length, row " + to_string(i) + " has " + to_string(rowVal->getElementCount()) + " elements, expected " + to_string(cols), args[0]->getRange());
+                return nullptr;
+            }
+
+            for (size_t j = 0; j < cols; ++j)
+            {
+                auto element = rowVal->getElement(j);
+                if (element->getType() != Value::Type::number)
+                {
+                    error("Matrix() expects numbers, but element [" + to_string(i) + "][" + to_string(j) + "] is " + element->typeAsString(), args[0]->getRange());
+                    return nullptr;
+                }
+                result->set(i, j, dynamic_pointer_cast<NumberValue>(element)->getValue());
+            }
+        }
+        return result ? result : make_shared<MatrixValue>(0, 0, range);
+    }
+
+    if (args.size() != 2 && args.size() != 3)
+    {
+        error("Matrix() expects 1 to 3 arguments, but got " + to_string(args.size()), range);
+        return nullptr;
+    }
+
+    size_t rows, cols;
+    if (!readDimension(args[0], rows) || !readDimension(args[1], cols))
+    {
+        return nullptr;
+    }
+
+    if (cols != 0 && rows > static_cast<size_t>(MAX_ELEMENTS) / cols)
+    {
+        error("Matrix() can have at most " + NumberValue::format(MAX_ELEMENTS) + " elements, but got " + to_string(rows) + " x " + to_string(cols), range);
+        return nullptr;
+    }
+
+    auto result = make_shared<MatrixValue>(rows, cols, range);
+    if (args.size() == 3)
+    {
+        if (args[2]->getType() != Value::Type::number)
+        {
+            error("Matrix() fill value must be a number, but got " + args[2]->typeAsString(), args[2]->getRange());
+            return nullptr;
+        }
+        double fill = dynamic_pointer_cast<NumberValue>(args[2])->getValue();
+        std::fill(result->getData().begin(), result->getData().end(), fill);
+    }
+    return result;
+}
+
+// reads the optional array a collection starts with, returns false after
+// reporting an error if the argument is not an array
+static bool initialElements(const string &name, const vector<shared_ptr<Value>> &args, vector<shared_ptr<Value>> &elements, const Range &range)
+{
+    if (args.size() > 1)
+    {
+        error(name + "() expects at most 1 argument, but got " + to_string(args.size()), range);
+        return false;
+    }
+
+    if (args.empty())
+    {
+        return true;
+    }
+
+    if (args[0]->getType() != Value::Type::array)
+    {
+        error(name + "() expects an array of initial values, but got " + args[0]->typeAsString(), args[0]->getRange());
+        return false;
+    }
+
+    elements = dynamic_pointer_cast<ArrayValue>(args[0])->getElements();
+    return true;
+}
+
+// Deque([values]) - double ended queue, optionally starting with the values of an array
+shared_ptr<Value> Builtins::deque(Interpreter &interpreter, const vector<shared_ptr<Value>> &args, shared_ptr<Environment> env, const Range &range)
+{
+    UNUSED(interpreter);
+    UNUSED(env);
+
+    vector<shared_ptr<Value>> elements;
+    if (!initialElements("Deque", args, elements, range))
+    {
+        return nullptr;
+    }
+
+    auto result = make_shared<DequeValue>(range);
+    for (const auto &element : elements)
+    {
+        result->pushBack(element);
+    }
+    return result;
+}
+
+// Set([values]) - hash set, optionally starting with the values of an array
+shared_ptr<Value> Builtins::set(Interpreter &interpreter, const vector<shared_ptr<Value>> &args, shared_ptr<Environment> env, const Range &range)
+{
+    UNUSED(interpreter);
+    UNUSED(env);
+
+    vector<shared_ptr<Value>> elements;
+    if (!initialElements("Set", args, elements, range))
+    {
+        return nullptr;
+    }
+
+    auto result = make_shared<SetValue>(range);
+    for (const auto &element : elements)
+    {
+        result->insert(element);
+    }
+    return result;
+}
+
+// PriorityQueue([cmp]) - binary heap, smallest number or string first unless cmp(a, b) says otherwise
+shared_ptr<Value> Builtins::priorityQueue(Interpreter &interpreter, const vector<shared_ptr<Value>> &args, shared_ptr<Environment> env, const Range &range)
+{
+    UNUSED(interpreter);
+    UNUSED(env);
+
+    if (args.size() > 1)
+    {
+        error("PriorityQueue() expects at most 1 argument, but got " + to_string(args.size()), range);
+        return nullptr;
+    }
+
+    if (args.size() == 1 && args[0]->getType() != Value::Type::function && args[0]->getType() != Value::Type::builtin)
+    {
+        error("PriorityQueue() expects a comparison function, but got " + args[0]->typeAsString(), args[0]->getRange());
+        return nullptr;
+    }
+
+    return make_shared<PriorityQueueValue>(args.empty() ? nullptr : args[0], range);
+}
+
+// range(end), range(start, end[, step]) - lazy sequence of numbers from start up to but not including end
+shared_ptr<Value> Builtins::range(Interpreter &interpreter, const vector<shared_ptr<Value>> &args, shared_ptr<Environment> env, const Range &range)
+{
+    UNUSED(interpreter);
+    UNUSED(env);
+
+    if (args.empty() || args.size() > 3)
+    {
+        error("range() expects 1 to 3 arguments, but got " + to_string(args.size()), range);
+        return nullptr;
+    }
+
+    double bounds[3] = { 0, 0, 1 };
+    for (size_t i = 0; i < args.size(); i++)
+    {
+        if (args[i]->getType() != Value::Type::number)
+        {
+            error("range() expects number arguments, but got " + args[i]->typeAsString(), args[i]->getRange());
+            return nullptr;
+        }
+        bounds[i] = dynamic_pointer_cast<NumberValue>(args[i])->getValue();
+    }
+
+    if (args.size() == 1)
+    {
+        std::swap(bounds[0], bounds[1]);
+    }
+
+    if (bounds[2] == 0 || std::isnan(bounds[2]))
+    {
+        error("range() step must not be 0", args[2]->getRange());
+        return nullptr;
+    }
+
+    return make_shared<RangeIterator>(bounds[0], bounds[1], bounds[2], range);
+}
+
+// lines(path) - lazy sequence of the lines of a file
+shared_ptr<Value> Builtins::lines(Interpreter &interpreter, const vector<shared_ptr<Value>> &args, shared_ptr<Environment> env, const Range &range)
+{
+    UNUSED(interpreter);
+    UNUSED(env);
+
+    if (args.size() != 1)
+    {
+        error("lines() expects exactly 1 argument, but got " + to_string(args.size()), range);
+        return nullptr;
+    }
+
+    if (args[0]->getType() != Value::Type::string_)
+    {
+        error("lines() expects a string argument, but got " + args[0]->typeAsString(), args[0]->getRange());
+        return nullptr;
+    }
+
+    string path = dynamic_pointer_cast<StringValue>(args[0])->getValue();
+    auto result = make_shared<LineIterator>(path, range);
+    if (!result->isOpen())
+    {
+        error("lines() failed to open file '" + path + "'", args[0]->getRange());
+        return nullptr;
+    }
+    return result;
+}
+
+// listdirIter(path) - lazy sequence of the names in the directory at the given path
+shared_ptr<Value> Builtins::listdirIter(Interpreter &interpreter, const vector<shared_ptr<Value>> &args, shared_ptr<Environment> env, const Range &range)
+{
+    UNUSED(interpreter);
+    UNUSED(env);
+
+    if (args.size() != 1)
+    {
+        error("listdirIter() expects exactly 1 argument, but got " + to_string(args.size()), range);
+        return nullptr;
+    }
+
+    if (args[0]->getType() != Value::Type::string_)
+    {
+        error("listdirIter() expects a string argument, but got " + args[0]->typeAsString(), args[0]->getRange());
+        return nullptr;
+    }
+
+    string path = dynamic_pointer_cast<StringValue>(args[0])->getValue();
+    auto result = make_shared<DirectoryIterator>(path, range);
+    if (!result->isOpen())
+    {
+        error("listdirIter() failed to open directory '" + path + "'", args[0]->getRange());
+        return nullptr;
+    }
+    return result;
+}
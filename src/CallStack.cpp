@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <deque>
+#include <unordered_map>
+
+#include "CallStack.h"
+
+using std::deque;
+using std::unordered_map;
+
+// names are never removed, a deque keeps references to them valid as it grows
+static deque<string> names;
+static unordered_map<string, uint32_t> ids;
+
+// frames most scripts stay within, deeper recursion grows the array
+static const size_t RESERVED_FRAMES = 1024;
+
+uint32_t CallStack::intern(const string &name)
+{
+    auto found = ids.find(name);
+    if (found != ids.end())
+    {
+        return found->second;
+    }
+
+    uint32_t id = static_cast<uint32_t>(names.size());
+    names.push_back(name);
+    ids.emplace(name, id);
+    return id;
+}
+
+const string &CallStack::name(uint32_t function)
+{
+    return names[function];
+}
+
+CallStack::CallStack():
+    lastSource(0)
+{
+    frames.reserve(RESERVED_FRAMES);
+}
+
+uint32_t CallStack::addSource(const Location &location)
+{
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+        if (sources[i].sameSource(location))
+        {
+            lastSource = static_cast<uint32_t>(i);
+            return lastSource;
+        }
+    }
+
+    sources.push_back(location.at(0));
+    lastSource = static_cast<uint32_t>(sources.size() - 1);
+    return lastSource;
+}
+
+Location CallStack::location(const Frame &frame) const
+{
+    return sources[frame.source].at(frame.pos);
+}
+
+string CallStack::toString(const string &format) const
+{
+    if (pending.range && !pending.pushed)
+    {
+        CallStack shown = *this;
+        shown.materialize();
+        return shown.toString(format);
+    }
+
+    if (frames.empty())
+    {
+        return "Call Stack is empty\n";
+    }
+
+    if (format == "raw")
+    {
+        string result = "Call Stack:\n";
+        for (const auto &frame : frames)
+        {
+            result += "    at " + name(frame.function) + " (" + location(frame).toString() + ")\n";
+        }
+        return result;
+    }
+
+    // Default table format
+    string result;
+
+    // Find the maximum width for function names and ranges for proper alignment
+    size_t maxNameWidth = 8;  // Minimum width for "Function" header
+    size_t maxRangeWidth = 8; // Minimum width for "Location" header
+
+    vector<string> locations;
+    locations.reserve(frames.size());
+    for (const auto &frame : frames)
+    {
+        locations.push_back(location(frame).toString());
+        maxNameWidth = std::max(maxNameWidth, name(frame.function).length());
+        maxRangeWidth = std::max(maxRangeWidth, locations.back().length());
+    }
+
+    // Calculate total table width: 2 spaces padding per column + 3 separators + 2 borders
+    size_t tableWidth = maxNameWidth + maxRangeWidth + 7;
+
+    // Create top border
+    result += "┌";
+    for (size_t i = 0; i < tableWidth - 2; ++i)
+    {
+        result += "─";
+    }
+    result += "┐\n";
+
+    // Center "Call Stack" in the header
+    string header = "Call Stack";
+    size_t headerPadding = (tableWidth - 2 - header.length()) / 2;
+    result += "│";
+    for (size_t i = 0; i < headerPadding; ++i)
+    {
+        result += " ";
+    }
+    result += header;
+    for (size_t i = headerPadding + header.length(); i < tableWidth - 2; ++i)
+    {
+        result += " ";
+    }
+    result += "│\n";
+
+    // Separator between header and column titles
+    result += "├";
+    for (size_t i = 0; i < maxNameWidth + 2; ++i) // +2 for padding
+    {
+        result += "─";
+    }
+    result += "┬";
+    for (size_t i = 0; i < maxRangeWidth + 2; ++i) // +2 for padding
+    {
+        result += "─";
+    }
+    result += "┤\n";
+
+    // Column headers
+    result += "│ Function";
+    for (size_t i = 8; i < maxNameWidth + 1; ++i) // +1 for right padding
+    {
+        result += " ";
+    }
+    result += "│ Location";
+    for (size_t i = 8; i < maxRangeWidth + 1; ++i) // +1 for right padding
+    {
+        result += " ";
+    }
+    result += "│\n";
+
+    // Separator between headers and data
+    result += "├";
+    for (size_t i = 0; i < maxNameWidth + 2; ++i) // +2 for padding
+    {
+        result += "─";
+    }
+    result += "┼";
+    for (size_t i = 0; i < maxRangeWidth + 2; ++i) // +2 for padding
+    {
+        result += "─";
+    }
+    result += "┤\n";
+
+    // Add entries (newest at bottom like a log file)
+    for (size_t entry = 0; entry < frames.size(); ++entry)
+    {
+        const string &functionName = name(frames[entry].function);
+        result += "│ " + functionName;
+        for (size_t i = functionName.length(); i < maxNameWidth + 1; ++i) // +1 for right padding
+        {
+            result += " ";
+        }
+        result += "│ " + locations[entry];
+        for (size_t i = locations[entry].length(); i < maxRangeWidth + 1; ++i) // +1 for right padding
+        {
+            result += " ";
+        }
+        result += "│\n";
+    }
+
+    // Bottom border
+    result += "└";
+    for (size_t i = 0; i < maxNameWidth + 2; ++i) // +2 for padding
+    {
+        result += "─";
+    }
+    result += "┴";
+    for (size_t i = 0; i < maxRangeWidth + 2; ++i) // +2 for padding
+    {
+        result += "─";
+    }
+    result += "┘\n";
+
+    return result;
+}
@@ -1,176 +1,122 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
-#include <ctime>
-#include <algorithm>
 
 #include "Range.h"
 
 using std::string;
 using std::vector;
 
-class CallEntry
-{
-public:
-    CallEntry(const string &functionName, const Range &functionRange) : name(functionName),
-                                                        range(functionRange)
-    {
-        timestamp = time(nullptr);
-    }
-
-    const string &getName() const { return name; }
-    const Range &getRange() const { return range; }
-    time_t getTimestamp() const { return timestamp; }
-
-private:
-    string name;
-    Range range;
-    time_t timestamp;
-};
-
+// The calls the interpreter is in, for dumpstack() and error reports.
+//
+// Pushing is on the path of every call, so a frame is only a few numbers:
+// the function's name is interned once (see intern()) and the location is
+// an offset into a source the stack has already seen. Names and locations
+// are only turned back into text when the stack is shown. The frames are
+// kept in an array that is allocated up front and only grows past it for
+// deep recursion.
 class CallStack
 {
 public:
-    void push(const CallEntry &entry) { entries.push_back(entry); }
-    void push(const string &name, const Range &range)
+    struct Frame
     {
-        entries.emplace_back(name, range);
-    }
-    void pop() { entries.pop_back(); }
-    const CallEntry &top() const { return entries.back(); }
-
-    void clear() { entries.clear(); }
-    bool isEmpty() const { return entries.empty(); }
-    size_t size() const { return entries.size(); }
+        uint32_t function; // see intern()
+        uint32_t source;   // index into the stack's sources
+        size_t pos;
+    };
+
+    // the id of a name, the same for every call with it
+    static uint32_t intern(const string &name);
+    static const string &name(uint32_t function);
+
+    // A builtin called without pushing a frame, see Native.
+    // Its frame is only made once a call is pushed above it, toString()
+    // shows it either way.
+    struct Pending
+    {
+        uint32_t function = 0;
+        const Range *range = nullptr;
+        bool pushed = false;
+    };
 
-    string toString(const string &format = "table") const
+    // records a builtin call as pending for as long as it is in scope
+    class Native
     {
-        if (entries.empty())
+    public:
+        Native(CallStack &stack, uint32_t function, const Range &range) : stack(stack)
         {
-            return "Call Stack is empty\n";
+            // a pending builtin running script code that calls another one
+            stack.materialize();
+            previous = stack.pending;
+            stack.pending = {function, &range, false};
         }
 
-        if (format == "raw")
+        ~Native()
         {
-            string result = "Call Stack:\n";
-            for (const auto &entry : entries)
+            if (stack.pending.pushed)
             {
-                result += "    at " + entry.getName() + " (" + entry.getRange().getStart().toString() + ")\n";
+                stack.frames.pop_back();
             }
-            return result;
+            stack.pending = previous;
         }
 
-        // Default table format
-        string result;
+        Native(const Native &) = delete;
+        Native &operator=(const Native &) = delete;
 
-        // Find the maximum width for function names and ranges for proper alignment
-        size_t maxNameWidth = 8;  // Minimum width for "Function" header
-        size_t maxRangeWidth = 8; // Minimum width for "Location" header
+    private:
+        CallStack &stack;
+        Pending previous;
+    };
 
-        for (const auto &entry : entries)
-        {
-            maxNameWidth = std::max(maxNameWidth, entry.getName().length());
-            maxRangeWidth = std::max(maxRangeWidth, entry.getRange().getStart().toString().length());
-        }
+    CallStack();
 
-        // Calculate total table width: 2 spaces padding per column + 3 separators + 2 borders
-        size_t tableWidth = maxNameWidth + maxRangeWidth + 7;
+    void push(uint32_t function, const Range &range)
+    {
+        materialize();
+        const Location &start = range.getStart();
+        frames.push_back({function, source(start), start.getPos()});
+    }
+    void pop() { frames.pop_back(); }
+    const Frame &top() const { return frames.back(); }
+    const vector<Frame> &getFrames() const { return frames; }
 
-        // Create top border
-        result += "┌";
-        for (size_t i = 0; i < tableWidth - 2; ++i)
-        {
-            result += "─";
-        }
-        result += "┐\n";
+    // where a frame's call is
+    Location location(const Frame &frame) const;
 
-        // Center "Call Stack" in the header
-        string header = "Call Stack";
-        size_t headerPadding = (tableWidth - 2 - header.length()) / 2;
-        result += "│";
-        for (size_t i = 0; i < headerPadding; ++i)
-        {
-            result += " ";
-        }
-        result += header;
-        for (size_t i = headerPadding + header.length(); i < tableWidth - 2; ++i)
-        {
-            result += " ";
-        }
-        result += "│\n";
+    void clear() { frames.clear(); }
+    bool isEmpty() const { return frames.empty(); }
+    size_t size() const { return frames.size(); }
 
-        // Separator between header and column titles
-        result += "├";
-        for (size_t i = 0; i < maxNameWidth + 2; ++i) // +2 for padding
-        {
-            result += "─";
-        }
-        result += "┬";
-        for (size_t i = 0; i < maxRangeWidth + 2; ++i) // +2 for padding
-        {
-            result += "─";
-        }
-        result += "┤\n";
-
-        // Column headers
-        result += "│ Function";
-        for (size_t i = 8; i < maxNameWidth + 1; ++i) // +1 for right padding
-        {
-            result += " ";
-        }
-        result += "│ Location";
-        for (size_t i = 8; i < maxRangeWidth + 1; ++i) // +1 for right padding
-        {
-            result += " ";
-        }
-        result += "│\n";
+    string toString(const string &format = "table") const;
 
-        // Separator between headers and data
-        result += "├";
-        for (size_t i = 0; i < maxNameWidth + 2; ++i) // +2 for padding
-        {
-            result += "─";
-        }
-        result += "┼";
-        for (size_t i = 0; i < maxRangeWidth + 2; ++i) // +2 for padding
-        {
-            result += "─";
-        }
-        result += "┤\n";
-
-        // Add entries (newest at bottom like a log file)
-        for (const auto &entry : entries)
+private:
+    void materialize()
+    {
+        if (pending.range && !pending.pushed)
         {
-            result += "│ " + entry.getName();
-            for (size_t i = entry.getName().length(); i < maxNameWidth + 1; ++i) // +1 for right padding
-            {
-                result += " ";
-            }
-            result += "│ " + entry.getRange().getStart().toString();
-            for (size_t i = entry.getRange().getStart().toString().length(); i < maxRangeWidth + 1; ++i) // +1 for right padding
-            {
-                result += " ";
-            }
-            result += "│\n";
+            pending.pushed = true;
+            push(pending.function, *pending.range);
         }
+    }
 
-        // Bottom border
-        result += "└";
-        for (size_t i = 0; i < maxNameWidth + 2; ++i) // +2 for padding
-        {
-            result += "─";
-        }
-        result += "┴";
-        for (size_t i = 0; i < maxRangeWidth + 2; ++i) // +2 for padding
+    uint32_t source(const Location &location)
+    {
+        // nearly every call is in the same source as the one before it
+        if (lastSource < sources.size() && sources[lastSource].sameSource(location))
         {
-            result += "─";
+            return lastSource;
         }
-        result += "┘\n";
-
-        return result;
+        return addSource(location);
     }
+    uint32_t addSource(const Location &location);
 
 private:
-    vector<CallEntry> entries;
-};
\ No newline at end of file
+    vector<Frame> frames;
+    Pending pending;
+
+    // the sources of the frames, each at its start
+    vector<Location> sources;
+    uint32_t lastSource;
+};
@@ -0,0 +1,339 @@
+#include <vector>
+
+#include "DequeValue.h"
+#include "Values.h"
+#include "Error.h"
+#include "Environment.h"
+#include "Utils.h"
+
+using std::shared_ptr;
+using std::vector;
+using std::make_shared;
+using std::string;
+using std::static_pointer_cast;
+
+#define error(msg, range) \
+    rangeError(msg, range, __FILE__, __LINE__)
+
+#define errorAt(msg, location, range) \
+    locationRangeError(msg, location, range, __FILE__, __LINE__)
+
+static const size_t INITIAL_CAPACITY = 8;
+
+DequeValue::DequeValue(const Range &range):
+    Value(Type::deque, range),
+    buffer(INITIAL_CAPACITY),
+    head(0),
+    count(0)
+{
+}
+
+void DequeValue::grow()
+{
+    vector<shared_ptr<Value>> larger(buffer.size() * 2);
+    for (size_t i = 0; i < count; ++i)
+    {
+        larger[i] = std::move(buffer[(head + i) & (buffer.size() - 1)]);
+    }
+    buffer.swap(larger);
+    head = 0;
+}
+
+void DequeValue::pushBack(const shared_ptr<Value> &value)
+{
+    if (count == buffer.size())
+    {
+        grow();
+    }
+    buffer[(head + count) & (buffer.size() - 1)] = value;
+    count++;
+}
+
+void DequeValue::pushFront(const shared_ptr<Value> &value)
+{
+    if (count == buffer.size())
+    {
+        grow();
+    }
+    head = (head + buffer.size() - 1) & (buffer.size() - 1);
+    buffer[head] = value;
+    count++;
+}
+
+shared_ptr<Value> DequeValue::popBack()
+{
+    if (count == 0)
+    {
+        return nullptr;
+    }
+    count--;
+    return std::move(buffer[(head + count) & (buffer.size() - 1)]);
+}
+
+shared_ptr<Value> DequeValue::popFront()
+{
+    if (count == 0)
+    {
+        return nullptr;
+    }
+    shared_ptr<Value> value = std::move(buffer[head]);
+    head = (head + 1) & (buffer.size() - 1);
+    count--;
+    return value;
+}
+
+void DequeValue::clear()
+{
+    buffer.assign(INITIAL_CAPACITY, nullptr);
+    head = 0;
+    count = 0;
+}
+
+vector<shared_ptr<Value>> DequeValue::toVector() const
+{
+    vector<shared_ptr<Value>> elements;
+    elements.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        elements.push_back(at(i));
+    }
+    return elements;
+}
+
+shared_ptr<Value> DequeValue::getMember(const string &name) const
+{
+    // builtins are registered on first use, like strings and arrays
+    if (members.empty())
+    {
+        const_cast<DequeValue *>(this)->registerBuiltins();
+    }
+    return Value::getMember(name);
+}
+
+void DequeValue::registerBuiltins()
+{
+    // pushBack(values...) -> null
+    addMember("pushBack", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            for (const auto &arg : args)
+            {
+                pushBack(arg);
+            }
+            return make_shared<NullValue>(range);
+        },
+        getRange()
+    ), true);
+
+    // pushFront(values...) -> null, each value goes in front of the previous one
+    addMember("pushFront", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            for (const auto &arg : args)
+            {
+                pushFront(arg);
+            }
+            return make_shared<NullValue>(range);
+        },
+        getRange()
+    ), true);
+
+    // popBack() -> the last value or null when empty
+    addMember("popBack", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("popBack() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            auto value = popBack();
+            return value ? value : make_shared<NullValue>(range);
+        },
+        getRange()
+    ), true);
+
+    // popFront() -> the first value or null when empty
+    addMember("popFront", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("popFront() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            auto value = popFront();
+            return value ? value : make_shared<NullValue>(range);
+        },
+        getRange()
+    ), true);
+
+    // front() -> the first value or null when empty
+    addMember("front", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("front() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            return count ? at(0) : make_shared<NullValue>(range);
+        },
+        getRange()
+    ), true);
+
+    // back() -> the last value or null when empty
+    addMember("back", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("back() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            return count ? at(count - 1) : make_shared<NullValue>(range);
+        },
+        getRange()
+    ), true);
+
+    // get(index) -> the value at index counting from the front
+    addMember("get", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (args.size() != 1)
+            {
+                error("get() expects exactly 1 argument, but got " + std::to_string(args.size()), range);
+                return nullptr;
+            }
+
+            if (args[0]->getType() != Value::Type::number)
+            {
+                errorAt("get() expects a number argument, but got " + args[0]->typeAsString(), args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+
+            double index = static_pointer_cast<NumberValue>(args[0])->getValue();
+            if (index < 0 || index >= static_cast<double>(count) || index != static_cast<double>(static_cast<size_t>(index)))
+            {
+                errorAt("index " + NumberValue::format(index) + " is out of bounds", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            return at(static_cast<size_t>(index));
+        },
+        getRange()
+    ), true);
+
+    // length() -> number
+    addMember("length", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("length() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            return make_shared<NumberValue>(static_cast<double>(count), range);
+        },
+        getRange()
+    ), true);
+
+    // empty() -> boolean
+    addMember("empty", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("empty() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            return make_shared<BooleanValue>(count == 0, range);
+        },
+        getRange()
+    ), true);
+
+    // clear() -> null
+    addMember("clear", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("clear() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            clear();
+            return make_shared<NullValue>(range);
+        },
+        getRange()
+    ), true);
+
+    // toArray() -> array from front to back
+    addMember("toArray", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("toArray() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            return make_shared<ArrayValue>(toVector(), range);
+        },
+        getRange()
+    ), true);
+}
+
+string DequeValue::toString() const
+{
+    string result = "Deque[";
+    for (size_t i = 0; i < count; ++i)
+    {
+        result += at(i)->toString();
+        if (i + 1 < count)
+        {
+            result += ", ";
+        }
+    }
+    result += "]";
+    return result;
+}
+
+bool DequeValue::toBoolean() const
+{
+    return count != 0;
+}
+
+string DequeValue::typeAsString() const
+{
+    return "Deque";
+}
+
+shared_ptr<Value> DequeValue::eq(const shared_ptr<NullValue> &other) const
+{
+    return make_shared<BooleanValue>(false, Range(getRange().getStart(), other->getRange().getEnd()));
+}
+
+shared_ptr<Value> DequeValue::ne(const shared_ptr<NullValue> &other) const
+{
+    return make_shared<BooleanValue>(true, Range(getRange().getStart(), other->getRange().getEnd()));
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Value.h"
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+// A double ended queue stored in a ring buffer, pushing and popping at
+// either end is O(1) and indexing is O(1).
+class DequeValue : public Value
+{
+public:
+    DequeValue(const Range &range = {});
+
+    void registerBuiltins();
+
+    void pushBack(const shared_ptr<Value> &value);
+    void pushFront(const shared_ptr<Value> &value);
+
+    // both return nullptr when the deque is empty
+    shared_ptr<Value> popBack();
+    shared_ptr<Value> popFront();
+
+    inline size_t length() const { return count; }
+    inline const shared_ptr<Value> &at(size_t index) const { return buffer[(head + index) & (buffer.size() - 1)]; }
+    void clear();
+
+    // the elements from front to back
+    vector<shared_ptr<Value>> toVector() const;
+
+    virtual shared_ptr<Value> getMember(const string &name) const override;
+
+    string toString() const override;
+    bool toBoolean() const override;
+
+    virtual string typeAsString() const override;
+
+public:
+    virtual shared_ptr<Value> eq(const shared_ptr<NullValue> &other) const override;
+    virtual shared_ptr<Value> ne(const shared_ptr<NullValue> &other) const override;
+
+private:
+    // doubles the capacity, keeping it a power of two so indexes wrap with a mask
+    void grow();
+
+private:
+    vector<shared_ptr<Value>> buffer;
+    size_t head;
+    size_t count;
+};
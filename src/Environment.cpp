@@ -26,7 +26,8 @@ Environment::~Environment()
         if (pair.second && pair.second->getType() == Value::Type::function)
         {
             auto func = std::dynamic_pointer_cast<FunctionValue>(pair.second);
-            if (func)
+            // a flat closure's environment is its own, it may outlive this one
+            if (func && !func->isFlat())
             {
                 func->clearClosureEnv();
             }
@@ -34,6 +35,7 @@ Environment::~Environment()
     }
     variables.clear();
     constants.clear();
+    cells.clear();
     parent.reset();
 }
 
@@ -45,7 +47,18 @@ shared_ptr<Value> Environment::declare(const string &name, shared_ptr<Value> val
         return nullptr; // Variable already declared
     }
 
-    variables[name] = std::move(value);
+    if (!spare.empty())
+    {
+        auto node = std::move(spare.back());
+        spare.pop_back();
+        node.key() = name;
+        node.mapped() = std::move(value);
+        variables.insert(std::move(node));
+    }
+    else
+    {
+        variables[name] = std::move(value);
+    }
 
     if (constant)
     {
@@ -57,7 +70,7 @@ shared_ptr<Value> Environment::declare(const string &name, shared_ptr<Value> val
 
 shared_ptr<Value> Environment::redeclare(const string &name, shared_ptr<Value> value, bool constant)
 {
-    variables[name] = value;
+    slot(variables.try_emplace(name).first) = value;
 
     if (constant)
     {
@@ -78,8 +91,9 @@ shared_ptr<Value> Environment::remove(const string & name)
     auto it = env->variables.find(name);
     if (it != env->variables.end())
     {
-        shared_ptr<Value> value = it->second;
+        shared_ptr<Value> value = env->slot(it);
         env->variables.erase(it);
+        env->cells.erase(name);
         return value;
     }
 
@@ -99,7 +113,7 @@ Result<Value> Environment::assign(const string &name, shared_ptr<Value> value)
         return { VARIABLE_IS_CONSTANT, nullptr };
     }
 
-    env->variables[name] = value;
+    env->slot(env->variables.find(name)) = value;
 
     return { SUCCESS, value };
 }
@@ -107,7 +121,7 @@ Result<Value> Environment::assign(const string &name, shared_ptr<Value> value)
 shared_ptr<Value> Environment::lookup(const string &name) const
 {
     shared_ptr<Environment> env = resolve(name);
-    return env ? env->variables.at(name) : nullptr;
+    return env ? env->slot(env->variables.find(name)) : nullptr;
 }
 
 shared_ptr<Value> Environment::lookupLocal(const string &name) const
@@ -115,7 +129,7 @@ shared_ptr<Value> Environment::lookupLocal(const string &name) const
     auto it = variables.find(name);
     if (it != variables.end())
     {
-        return it->second;
+        return slot(it);
     }
     return nullptr;
 }
@@ -139,6 +153,11 @@ shared_ptr<Environment> Environment::getParent() const
     return parent;
 }
 
+void Environment::setParent(const shared_ptr<Environment> &newParent)
+{
+    parent = newParent;
+}
+
 const map<string, shared_ptr<Value>> &Environment::getMembers() const
 {
     return variables;
@@ -201,9 +220,18 @@ void Environment::clear()
         }
     }
 
-    // Clear all variables to break potential cycles
-    variables.clear();
+    // Clear all variables to break potential cycles, keeping a few slots
+    while (!variables.empty())
+    {
+        auto node = variables.extract(variables.begin());
+        if (spare.size() < MAX_SPARE_SLOTS)
+        {
+            node.mapped() = nullptr;
+            spare.push_back(std::move(node));
+        }
+    }
     constants.clear();
+    cells.clear();
     // Don't clear parent - let it be cleaned up naturally
 }
 
@@ -233,7 +261,8 @@ void Environment::dump() const
     {
         bool isConstant = hasConstant(pair.first);
         string constIndicator = isConstant ? " [const]" : "";
-        cout << "  " << pair.first << ": " << (pair.second ? pair.second->toString() : "null") << constIndicator << "\n";
+        auto value = slot(variables.find(pair.first));
+        cout << "  " << pair.first << ": " << (value ? value->toString() : "null") << constIndicator << "\n";
     }
 }
 
@@ -266,3 +295,58 @@ bool Environment::hasFunctions() const
     }
     return false;
 }
+
+
+bool Environment::capture(const string &name, const Environment *stop, Environment &into)
+{
+    for (Environment *env = this; env && env != stop; env = env->parent.get())
+    {
+        auto it = env->variables.find(name);
+        if (it == env->variables.end())
+        {
+            continue;
+        }
+
+        auto &cell = env->cells[name];
+        if (!cell)
+        {
+            cell = make_shared<shared_ptr<Value>>(std::move(it->second));
+            it->second = nullptr;
+        }
+
+        into.variables[name] = nullptr;
+        into.cells[name] = cell;
+        if (env->hasConstant(name))
+        {
+            into.constants.insert(name);
+        }
+        return true;
+    }
+    return false;
+}
+
+const shared_ptr<Value> &Environment::slot(map<string, shared_ptr<Value>>::const_iterator it) const
+{
+    if (!it->second && !cells.empty())
+    {
+        auto cell = cells.find(it->first);
+        if (cell != cells.end())
+        {
+            return *cell->second;
+        }
+    }
+    return it->second;
+}
+
+shared_ptr<Value> &Environment::slot(map<string, shared_ptr<Value>>::iterator it)
+{
+    if (!it->second && !cells.empty())
+    {
+        auto cell = cells.find(it->first);
+        if (cell != cells.end())
+        {
+            return *cell->second;
+        }
+    }
+    return it->second;
+}
\ No newline at end of file
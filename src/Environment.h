@@ -4,6 +4,7 @@
 #include <map>
 #include <set>
 #include <memory>
+#include <vector>
 
 #include "Result.h"
 
@@ -11,6 +12,7 @@ using std::string;
 using std::map;
 using std::set;
 using std::shared_ptr;
+using std::vector;
 using std::weak_ptr;
 using std::enable_shared_from_this;
 
@@ -44,13 +46,34 @@ public:
     const map<string, shared_ptr<Value>> &getMembers() const;
     shared_ptr<Environment> getParent() const;
 
+    // points a pooled environment at the scope it is reused in
+    void setParent(const shared_ptr<Environment> &parent);
+
     void clear(); // clear all variables and break cycles
     void dump() const; // for debugging purposes, prints all variables and constants
 
     bool hasVariable(const string &name) const;
     bool hasConstant(const string &name) const;
+
+    // Shares the variable with another environment, for flat closures. The
+    // environments from this one up to stop (not included) are searched, the
+    // variable is moved into a cell both can see and declared in into.
+    // Returns false if it isn't declared in any of them yet.
+    bool capture(const string &name, const Environment *stop, Environment &into);
+private:
+    // the value a variable slot holds, looking through its cell if captured
+    const shared_ptr<Value> &slot(map<string, shared_ptr<Value>>::const_iterator it) const;
+    shared_ptr<Value> &slot(map<string, shared_ptr<Value>>::iterator it);
 private:
     shared_ptr<Environment> parent; // keep as shared_ptr for proper scoping
     map<string, shared_ptr<Value>> variables; // runtime variables
     set<string> constants; // constants
+
+    // variables shared with flat closures, their slot in variables is null
+    map<string, shared_ptr<shared_ptr<Value>>> cells;
+
+    // slots of cleared variables, declare reuses them so a pooled
+    // environment doesn't allocate for the same few names every time
+    static const size_t MAX_SPARE_SLOTS = 8;
+    vector<map<string, shared_ptr<Value>>::node_type> spare;
 };
\ No newline at end of file
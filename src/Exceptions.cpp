@@ -8,11 +8,6 @@ BaseException::BaseException(Range range):
     range(range)
 { }
 
-ReturnException::ReturnException(shared_ptr<Value> val, Range range):
-    BaseException(range),
-    value(move(val))
-{ }
-
 BreakException::BreakException(Range range):
     BaseException(range)
 { }
@@ -26,6 +21,10 @@ ContinueException::ContinueException(Range range):
     BaseException(range)
 { }
 
+GeneratorExitException::GeneratorExitException(Range range):
+    BaseException(range)
+{ }
+
 ErrorException::ErrorException(const string &message, Range range):
     BaseException(range)
 {
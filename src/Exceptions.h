@@ -15,13 +15,6 @@ struct BaseException : public exception
     BaseException(Range range = {});
 };
 
-// exception to handle function returns
-struct ReturnException : public BaseException
-{
-    shared_ptr<Value> value;
-    ReturnException(shared_ptr<Value> val, Range range = {});
-};
-
 struct BreakException : public BaseException
 {
     BreakException(Range range = {});
@@ -39,6 +32,13 @@ struct ContinueException : public BaseException
     ContinueException(Range range = {});
 };
 
+// thrown at the yield a generator is paused at when it is closed, so the
+// body unwinds and releases what it holds
+struct GeneratorExitException : public BaseException
+{
+    GeneratorExitException(Range range = {});
+};
+
 struct ErrorException : public BaseException
 {
     ErrorException(const string &message, Range range = {});
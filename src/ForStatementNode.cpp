@@ -47,6 +47,16 @@ shared_ptr<StatementNode> ForStatementNode::getBody() const
     return body;
 }
 
+void ForStatementNode::setCondition(shared_ptr<StatementNode> condition)
+{
+    this->condition = condition;
+}
+
+void ForStatementNode::setIncrement(shared_ptr<ExpressionNode> increment)
+{
+    this->increment = increment;
+}
+
 void ForStatementNode::visit(Visitor *visitor)
 {
     visitor->visit(this);
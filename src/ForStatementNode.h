@@ -1,13 +1,40 @@
 #pragma once
 
 #include <memory>
+#include <string>
 
 #include "StatementNode.h"
 #include "ExpressionNode.h"
 #include "Visitor.h"
+#include "Jit.h"
 
 using std::shared_ptr;
 
+// What LoopAnalysisVisitor found out about a for loop. A counted loop is one
+// of the form for (let i = a; i < b; i++) whose body never assigns i, with
+// any of < <= > >= and a step of one in the direction of the bound; the
+// interpreter keeps hold of i's number and steps it in place.
+struct CountedLoop
+{
+    enum class Bound
+    {
+        constant,    // a literal, or a variable nothing in the loop can assign
+        arrayLength, // len(array) of a variable the body doesn't assign
+        condition    // anything else, the condition is evaluated as usual
+    };
+
+    bool counted = false;
+    std::string variable;
+    int op = 0;    // '<', '>', Token::LE or Token::GE
+    int step = 0;  // 1 or -1
+
+    Bound bound = Bound::condition;
+    std::string boundName; // the variable a bound reads, empty for a literal
+
+    // the body calls functions, a closure could replace the bound's array
+    bool bodyCalls = false;
+};
+
 // forStmt -> FOR ( exprStmt exprStmt expr ) stmt
 class ForStatementNode : public StatementNode
 {
@@ -23,6 +50,14 @@ public:
     shared_ptr<StatementNode> getCondition() const;
     shared_ptr<ExpressionNode> getIncrement() const;
     shared_ptr<StatementNode> getBody() const;
+    void setCondition(shared_ptr<StatementNode> condition);
+    void setIncrement(shared_ptr<ExpressionNode> increment);
+
+    // iterations counted until the loop is hot and the machine code made then
+    Jit::LoopState &getJitState() { return jitState; }
+
+    const CountedLoop &getCountedLoop() const { return countedLoop; }
+    void setCountedLoop(const CountedLoop &loop) { countedLoop = loop; }
 
     virtual void visit(Visitor *visitor) override;
 private:
@@ -30,4 +65,6 @@ private:
     shared_ptr<StatementNode> condition;
     shared_ptr<ExpressionNode> increment;
     shared_ptr<StatementNode> body;
+    Jit::LoopState jitState;
+    CountedLoop countedLoop;
 };
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "FreeVariableVisitor.h"
+#include "Nodes.h"
+#include "Utils.h"
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+FreeVariableVisitor::FreeVariableVisitor():
+    current(nullptr)
+{
+}
+
+void FreeVariableVisitor::visitAllChildren(Node *node)
+{
+    functions.clear();
+    push(Scope::root, nullptr);
+    node->visit(this);
+    pop();
+
+    for (const auto &scope : functions)
+    {
+        resolve(scope);
+    }
+    functions.clear();
+}
+
+void FreeVariableVisitor::visit(FuncDeclNode *node)
+{
+    current->declared[node->getName()]++;
+    if (current->kind == Scope::function)
+    {
+        current->node->setCapturesFrame();
+    }
+
+    push(Scope::function, node);
+    functions.push_back(current);
+
+    auto params = node->getParams();
+    for (int i = 0; params && i < params->getParamCount(); i++)
+    {
+        const string &name = params->getParam(i)->getName();
+        current->declared[name]++;
+        current->parameters.insert(name);
+    }
+
+    if (node->getBody())
+    {
+        node->getBody()->visit(this);
+    }
+    pop();
+}
+
+void FreeVariableVisitor::visit(ClassNode *node)
+{
+    current->declared[node->getName()]++;
+    if (current->kind == Scope::function)
+    {
+        current->node->setCapturesFrame();
+    }
+
+    push(Scope::classBody, nullptr);
+    if (node->getBody())
+    {
+        node->getBody()->visit(this);
+    }
+    pop();
+}
+
+void FreeVariableVisitor::visit(VarDeclNode *node)
+{
+    current->declared[node->getName()]++;
+    if (node->getExpr())
+    {
+        node->getExpr()->visit(this);
+    }
+}
+
+void FreeVariableVisitor::visit(VarExprNode *node)
+{
+    current->used.insert(node->getName());
+}
+
+void FreeVariableVisitor::visit(DeleteNode *node)
+{
+    current->used.insert(node->getName());
+}
+
+void FreeVariableVisitor::visit(ImportNode *node)
+{
+    UNUSED(node);
+    current->hasImport = true;
+}
+
+void FreeVariableVisitor::visit(ReturnStatementNode *node)
+{
+    if (node->getExpression())
+    {
+        node->getExpression()->visit(this);
+    }
+}
+
+void FreeVariableVisitor::push(Scope::Kind kind, FuncDeclNode *node)
+{
+    auto scope = make_shared<Scope>();
+    scope->kind = kind;
+    scope->node = node;
+    scope->parent = current;
+    scope->hasImport = false;
+    current = scope;
+}
+
+void FreeVariableVisitor::pop()
+{
+    // whatever isn't a parameter may come from further out
+    for (const auto &name : current->parameters)
+    {
+        current->used.erase(name);
+    }
+
+    if (current->parent)
+    {
+        current->parent->used.insert(current->used.begin(), current->used.end());
+    }
+    current = current->parent;
+}
+
+void FreeVariableVisitor::resolve(const shared_ptr<Scope> &scope)
+{
+    // the enclosing functions, up to the top level or a class body
+    vector<Scope *> enclosing;
+    for (Scope *outer = scope->parent.get(); outer && outer->kind == Scope::function; outer = outer->parent.get())
+    {
+        if (outer->hasImport)
+        {
+            return;
+        }
+        enclosing.push_back(outer);
+    }
+
+    if (enclosing.empty())
+    {
+        return;
+    }
+
+    const string &name = scope->node->getName();
+    vector<string> captures;
+    bool selfReferencing = false;
+
+    for (const auto &used : scope->used)
+    {
+        int declarations = 0;
+        for (Scope *outer : enclosing)
+        {
+            auto it = outer->declared.find(used);
+            if (it != outer->declared.end())
+            {
+                declarations += it->second;
+            }
+        }
+
+        if (declarations == 0)
+        {
+            // a global or a builtin, found past the enclosing functions
+            continue;
+        }
+
+        if (declarations > 1)
+        {
+            return;
+        }
+
+        if (used == name)
+        {
+            selfReferencing = true;
+            continue;
+        }
+        captures.push_back(used);
+    }
+
+    scope->node->setCaptures(captures, selfReferencing);
+}
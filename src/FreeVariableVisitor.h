@@ -0,0 +1,66 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Visitor.h"
+
+// Works out which variables of enclosing functions each nested function uses,
+// so the interpreter can give it a flat closure holding just those instead of
+// its whole defining scope, and which functions declare anything that could
+// keep their call's scope alive. Runs on every parsed program and records the
+// result on the FuncDeclNodes.
+//
+// Declarations are counted per function rather than per block. A name used
+// by a nested function is captured if the enclosing functions declare it
+// exactly once; more than once means which one it sees depends on blocks and
+// timing, so that function keeps its whole scope. A captured variable that
+// isn't declared yet when the closure is made also falls back to the whole
+// scope, in the interpreter.
+class FreeVariableVisitor : public Visitor
+{
+public:
+    FreeVariableVisitor();
+
+    virtual void visitAllChildren(Node *node) override;
+public:
+    virtual void visit(FuncDeclNode *node) override;
+    virtual void visit(ClassNode *node) override;
+    virtual void visit(VarDeclNode *node) override;
+    virtual void visit(VarExprNode *node) override;
+    virtual void visit(DeleteNode *node) override;
+    virtual void visit(ImportNode *node) override;
+    virtual void visit(ReturnStatementNode *node) override;
+private:
+    struct Scope
+    {
+        enum Kind { root, function, classBody };
+
+        Kind kind;
+        FuncDeclNode *node;
+        std::shared_ptr<Scope> parent;
+
+        // how many times each name is declared, parameters included
+        std::map<std::string, int> declared;
+        std::set<std::string> parameters;
+
+        // names used here or by nested functions, less the parameters once popped
+        std::set<std::string> used;
+
+        // an import declares names nobody can see until it runs
+        bool hasImport;
+    };
+
+    void push(Scope::Kind kind, FuncDeclNode *node);
+    void pop();
+
+    // decides once every declaration of the enclosing functions is known
+    void resolve(const std::shared_ptr<Scope> &scope);
+
+private:
+    std::shared_ptr<Scope> current;
+    std::vector<std::shared_ptr<Scope>> functions;
+};
@@ -19,7 +19,11 @@ FuncDeclNode::FuncDeclNode(const Token &token,
     shared_ptr<StatementNode> body):
     token(token),
     params(params),
-    body(body)
+    body(body),
+    generator(false),
+    flat(false),
+    selfReferencing(false),
+    frameCaptured(false)
 {
     setRange(token.getRange());
 
@@ -69,6 +73,48 @@ bool FuncDeclNode::isConst() const
     return true;
 }
 
+bool FuncDeclNode::isGenerator() const
+{
+    return generator;
+}
+
+void FuncDeclNode::setGenerator(bool g)
+{
+    generator = g;
+}
+
+bool FuncDeclNode::isFlat() const
+{
+    return flat;
+}
+
+const vector<string> &FuncDeclNode::getCaptures() const
+{
+    return captures;
+}
+
+bool FuncDeclNode::isSelfReferencing() const
+{
+    return selfReferencing;
+}
+
+void FuncDeclNode::setCaptures(const vector<string> &c, bool self)
+{
+    flat = true;
+    captures = c;
+    selfReferencing = self;
+}
+
+bool FuncDeclNode::capturesFrame() const
+{
+    return frameCaptured;
+}
+
+void FuncDeclNode::setCapturesFrame()
+{
+    frameCaptured = true;
+}
+
 void FuncDeclNode::visit(Visitor *visitor)
 {
     visitor->visit(this);
@@ -10,6 +10,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "DeclNode.h"
 #include "Token.h"
@@ -18,6 +19,7 @@
 
 using std::shared_ptr;
 using std::string;
+using std::vector;
 
 class FuncDeclNode : public DeclNode
 {
@@ -38,9 +40,32 @@ public:
 
     virtual bool isConst() const override;
 
+    // true if the body contains a yield, calling it then returns a generator
+    bool isGenerator() const;
+    void setGenerator(bool generator);
+
+    // set by the FreeVariableVisitor for functions nested in other functions:
+    // the enclosing functions' variables the body uses, which a flat closure
+    // captures instead of the whole defining scope, and whether it calls
+    // itself by name
+    bool isFlat() const;
+    const vector<string> &getCaptures() const;
+    bool isSelfReferencing() const;
+    void setCaptures(const vector<string> &captures, bool selfReferencing);
+
+    // true if the body declares functions or classes, which may keep a
+    // call's scope alive after it returns
+    bool capturesFrame() const;
+    void setCapturesFrame();
+
     virtual void visit(Visitor *visitor) override;
 private:
     Token token;
     shared_ptr<ParamListNode> params;
     shared_ptr<StatementNode> body;
+    bool generator;
+    bool flat;
+    vector<string> captures;
+    bool selfReferencing;
+    bool frameCaptured;
 };
\ No newline at end of file
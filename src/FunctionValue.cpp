@@ -12,12 +12,18 @@ FunctionValue::FunctionValue(const string &name,
     shared_ptr<ParamListNode> params,
     shared_ptr<StatementNode> body,
     shared_ptr<Environment> closureEnv,
-    Range range):
+    Range range,
+    bool generator):
     Value(Type::function, range), // set the type to function
     name(name),
     params(params),
     body(body),
-    closureEnv(closureEnv)
+    closureEnv(closureEnv),
+    generator(generator),
+    flat(false),
+    selfReferencing(false),
+    frameCaptured(true),
+    callStackId(UNINTERNED)
 { }
 
 const string &FunctionValue::getName() const
@@ -45,6 +51,12 @@ void FunctionValue::clearClosureEnv()
     closureEnv.reset();
 }
 
+void FunctionValue::makeFlat(bool self)
+{
+    flat = true;
+    selfReferencing = self;
+}
+
 void FunctionValue::rewriteClosureEnv(shared_ptr<Environment> newEnv)
 {
     closureEnv = newEnv;
@@ -92,11 +104,22 @@ shared_ptr<Value> FunctionValue::ne(const shared_ptr<NullValue> &other) const
 
 BuiltinFunctionValue::BuiltinFunctionValue(BuiltinFunction func, Range range):
     Value(Type::builtin, range), // set the type to builtin
-    func(func)
+    func(func),
+    native(nullptr)
+{ }
+
+BuiltinFunctionValue::BuiltinFunctionValue(NativeFunction native, Range range):
+    Value(Type::builtin, range),
+    native(native)
 { }
 
 shared_ptr<Value> BuiltinFunctionValue::call(Interpreter &interpreter, const vector<shared_ptr<Value>> &args, const shared_ptr<Environment> &env, const Range &range) const
 {
+    if (native)
+    {
+        return native(interpreter, args, range);
+    }
+
     if (!func)
     {
         return nullptr;
@@ -113,13 +136,26 @@ shared_ptr<Value> BuiltinFunctionValue::bind(const shared_ptr<Value> &thisPtr)
     }
 
     auto boundFunction = make_shared<BuiltinFunctionValue>(func, getRange());
+    boundFunction->native = native;
     boundFunction->thisPtr = thisPtr;
     return boundFunction;
 }
 
 string BuiltinFunctionValue::toString() const
 {
-    return "<builtin function>";
+    return displayName();
+}
+
+const string &BuiltinFunctionValue::displayName()
+{
+    static const string name = "<builtin function>";
+    return name;
+}
+
+uint32_t BuiltinFunctionValue::callStackId()
+{
+    static const uint32_t id = CallStack::intern(displayName());
+    return id;
 }
 
 string BuiltinFunctionValue::typeAsString() const
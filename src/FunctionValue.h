@@ -18,6 +18,29 @@ using std::function;
 
 typedef function<shared_ptr<Value>(Interpreter &interpreter, const vector<shared_ptr<Value>> &args, const shared_ptr<Environment> &env, const Range &range)> BuiltinFunction;
 
+// The arguments of a native builtin, a view of values the caller holds
+class Arguments
+{
+public:
+    Arguments(const shared_ptr<Value> *values, size_t count) : values(values), count(count) {}
+    Arguments(const vector<shared_ptr<Value>> &values) : values(values.data()), count(values.size()) {}
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const shared_ptr<Value> &operator[](size_t index) const { return values[index]; }
+    const shared_ptr<Value> *begin() const { return values; }
+    const shared_ptr<Value> *end() const { return values + count; }
+
+private:
+    const shared_ptr<Value> *values;
+    size_t count;
+};
+
+// Builtins that don't need the calling environment can be plain functions
+// over their arguments, a call to one doesn't build a vector of arguments
+// or go through a std::function
+typedef shared_ptr<Value> (*NativeFunction)(Interpreter &interpreter, Arguments args, const Range &range);
+
 class FunctionValue : public Value
 {
 public:
@@ -25,13 +48,39 @@ public:
         shared_ptr<ParamListNode> params,
         shared_ptr<StatementNode> body,
         shared_ptr<Environment> closureEnv,
-        Range range = {});
+        Range range = {},
+        bool generator = false);
 
     const string &getName() const;
+
+    // the name as the call stack knows it, interned the first time it's called
+    inline uint32_t getCallStackId() const
+    {
+        if (callStackId == UNINTERNED)
+        {
+            callStackId = CallStack::intern(name);
+        }
+        return callStackId;
+    }
+
     shared_ptr<ParamListNode> getParameters() const;
     shared_ptr<StatementNode> getBody() const;
     shared_ptr<Environment> getEnvironment() const;
 
+    // generator functions return a GeneratorValue instead of running their body
+    inline bool isGenerator() const { return generator; }
+
+    // a flat closure's environment holds only the variables it captured, its
+    // parent is outside the enclosing functions
+    inline bool isFlat() const { return flat; }
+    inline bool isSelfReferencing() const { return selfReferencing; }
+    void makeFlat(bool selfReferencing);
+
+    // false when nothing in the body can keep a call's scope, so calls may
+    // take their scope from the interpreter's pool
+    inline bool capturesFrame() const { return frameCaptured; }
+    inline void setCapturesFrame(bool captured) { frameCaptured = captured; }
+
     void clearClosureEnv(); // clear closure environment to break cycles
     void rewriteClosureEnv(shared_ptr<Environment> newEnv); // rewrite closure environment
     string toString() const override;
@@ -48,21 +97,37 @@ private:
     shared_ptr<ParamListNode> params;
     shared_ptr<StatementNode> body;
     shared_ptr<Environment> closureEnv;
+    bool generator;
+    bool flat;
+    bool selfReferencing;
+    bool frameCaptured;
+
+    static const uint32_t UNINTERNED = UINT32_MAX;
+    mutable uint32_t callStackId;
 };
 
 class BuiltinFunctionValue : public Value
 {
 public:
     BuiltinFunctionValue(BuiltinFunction func, Range range = {});
+    BuiltinFunctionValue(NativeFunction native, Range range = {});
 
     shared_ptr<Value> call(Interpreter &interpreter, const vector<shared_ptr<Value>> &args, const shared_ptr<Environment> &env, const Range &range = {}) const;
     shared_ptr<Value> bind(const shared_ptr<Value> &thisPtr);
 
+    // nullptr unless the builtin is a NativeFunction
+    NativeFunction getNative() const { return native; }
+
     string toString() const override;
 
+    // what toString() gives, the name builtins have on the call stack
+    static const string &displayName();
+    static uint32_t callStackId();
+
     virtual string typeAsString() const override;
 public:
 private:
     BuiltinFunction func;
+    NativeFunction native;
     shared_ptr<Value> thisPtr; // allows function to be bound to an object.
 };
\ No newline at end of file
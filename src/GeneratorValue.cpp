@@ -0,0 +1,271 @@
+#include <vector>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "GeneratorValue.h"
+#include "Values.h"
+#include "Error.h"
+#include "Environment.h"
+#include "Exceptions.h"
+#include "Interpreter.h"
+#include "Utils.h"
+#include "ScriptStack.h"
+
+using std::shared_ptr;
+using std::vector;
+using std::make_shared;
+using std::string;
+
+// generators run script code, so errors stop the script like in the interpreter
+#define error(msg, range)                       \
+    rangeError(msg, range, __FILE__, __LINE__); \
+    interpreter.hadError = true;                \
+    throw ErrorException(msg, range)
+
+
+// stacks of finished generators, kept so a loop that makes many short lived
+// generators doesn't map and unmap one every time
+static const size_t MAX_FREE_STACKS = 8;
+static vector<void *> freeStacks;
+
+static void *allocateStack()
+{
+    if (!freeStacks.empty())
+    {
+        void *stack = freeStacks.back();
+        freeStacks.pop_back();
+        return stack;
+    }
+
+    // pages are only backed once touched, but every suspended generator
+    // holds the whole mapping, see ScriptStack::GENERATOR_SIZE
+    void *stack = mmap(nullptr, ScriptStack::generatorMappedSize(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    if (stack == MAP_FAILED)
+    {
+        return nullptr;
+    }
+
+    // the lowest page is a guard so running off the end crashes instead of
+    // overwriting whatever is mapped below
+    mprotect(stack, ScriptStack::guardSize(), PROT_NONE);
+    return stack;
+}
+
+static void releaseStack(void *stack)
+{
+    if (freeStacks.size() < MAX_FREE_STACKS)
+    {
+        freeStacks.push_back(stack);
+        return;
+    }
+    munmap(stack, ScriptStack::generatorMappedSize());
+}
+
+GeneratorValue::GeneratorValue(Interpreter &interpreter, const shared_ptr<FunctionValue> &function, const shared_ptr<Environment> &scope, const Range &range):
+    IteratorValue(range),
+    interpreter(interpreter),
+    function(function),
+    frameEnv(scope),
+    state(State::created),
+    closing(false),
+    pending(nullptr),
+    failure(nullptr),
+    stack(nullptr)
+{
+    interpreter.generators.insert(this);
+}
+
+GeneratorValue::~GeneratorValue()
+{
+    close();
+    interpreter.generators.erase(this);
+}
+
+void GeneratorValue::close()
+{
+    if (state == State::suspended)
+    {
+        closing = true;
+        try
+        {
+            resume(getRange());
+        }
+        catch (const BaseException &)
+        {
+            // the body failed while unwinding, there is nobody left to tell
+        }
+    }
+
+    if (state != State::running)
+    {
+        state = State::finished;
+        pending = nullptr;
+        frameEnv = nullptr;
+    }
+}
+
+void GeneratorValue::entry(unsigned int high, unsigned int low)
+{
+    uintptr_t address = (static_cast<uintptr_t>(high) << 32) | static_cast<uintptr_t>(low);
+    reinterpret_cast<GeneratorValue *>(address)->run();
+}
+
+void GeneratorValue::run()
+{
+    try
+    {
+        // a return ends the generator, its value is not produced
+        function->getBody()->visit(&interpreter);
+        interpreter.returning = false;
+        interpreter.pendingReturn = nullptr;
+    }
+    catch (const GeneratorExitException &)
+    {
+    }
+    catch (...)
+    {
+        failure = std::current_exception();
+    }
+
+    state = State::finished;
+    pending = nullptr;
+    frameEnv = nullptr;
+
+    // returning switches back to the caller through uc_link
+}
+
+void GeneratorValue::resume(const Range &range)
+{
+    if (state == State::running)
+    {
+        error("generator '" + function->getName() + "' is already running", range);
+    }
+
+    if (state == State::finished)
+    {
+        return;
+    }
+
+    if (ScriptStack::exhausted())
+    {
+        error("maximum recursion depth exceeded (stack size " + ScriptStack::formatSize(ScriptStack::current().size) + ", see --max-stack)", range);
+    }
+
+    if (state == State::created)
+    {
+        stack = allocateStack();
+        if (!stack)
+        {
+            error("failed to allocate a stack for generator '" + function->getName() + "'", range);
+        }
+
+        getcontext(&context);
+        context.uc_stack.ss_sp = stack;
+        context.uc_stack.ss_size = ScriptStack::generatorMappedSize();
+        context.uc_link = &caller;
+
+        uintptr_t address = reinterpret_cast<uintptr_t>(this);
+        makecontext(&context, reinterpret_cast<void (*)()>(&GeneratorValue::entry), 2,
+            static_cast<unsigned int>(address >> 32), static_cast<unsigned int>(address & 0xffffffff));
+    }
+
+    // the body runs as if it were called from here
+    auto callerEnv = interpreter.env;
+    auto callerReturnValue = interpreter.returnValue;
+    auto callerFunctionName = interpreter.currentFunctionName;
+    auto callerGenerator = interpreter.activeGenerator;
+    auto callerFunction = interpreter.currentFunction;
+    auto callerTailCalls = interpreter.tailCalls;
+
+    interpreter.env = frameEnv;
+    interpreter.currentFunctionName = function->getName();
+    interpreter.activeGenerator = this;
+    interpreter.currentFunction = function.get();
+    interpreter.tailCalls = false; // its calls return to the body, not to the caller
+    interpreter.nestingLevel++;
+    interpreter.callStack.push(function->getCallStackId(), function->getRange());
+
+    // the body's calls check how much of the generator's own stack is left
+    auto callerStack = ScriptStack::current();
+    size_t guard = ScriptStack::guardSize();
+    ScriptStack::setCurrent({static_cast<char *>(stack) + guard, ScriptStack::generatorMappedSize() - guard});
+
+    state = State::running;
+    swapcontext(&caller, &context);
+
+    ScriptStack::setCurrent(callerStack);
+
+    interpreter.callStack.pop();
+    interpreter.nestingLevel--;
+    interpreter.currentFunction = callerFunction;
+    interpreter.tailCalls = callerTailCalls;
+    interpreter.activeGenerator = callerGenerator;
+    interpreter.currentFunctionName = callerFunctionName;
+    interpreter.returnValue = callerReturnValue;
+    interpreter.env = callerEnv;
+
+    if (state == State::finished && stack)
+    {
+        releaseStack(stack);
+        stack = nullptr;
+    }
+
+    if (failure)
+    {
+        auto thrown = failure;
+        failure = nullptr;
+        std::rethrow_exception(thrown);
+    }
+}
+
+void GeneratorValue::yield(const shared_ptr<Value> &value, const Range &range)
+{
+    pending = value;
+    frameEnv = interpreter.env;
+    state = State::suspended;
+
+    swapcontext(&context, &caller);
+
+    // resumed
+    frameEnv = nullptr;
+    if (closing)
+    {
+        throw GeneratorExitException(range);
+    }
+}
+
+bool GeneratorValue::done(Interpreter &interpreter)
+{
+    UNUSED(interpreter);
+
+    // whether there is another value is only known by running to the next yield
+    if (!pending && state != State::finished)
+    {
+        resume(getRange());
+    }
+    return !pending;
+}
+
+shared_ptr<Value> GeneratorValue::next(Interpreter &interpreter, const Range &range)
+{
+    UNUSED(interpreter);
+
+    if (!pending)
+    {
+        resume(range);
+    }
+
+    if (!pending)
+    {
+        return make_shared<NullValue>(range);
+    }
+
+    auto value = pending;
+    pending = nullptr;
+    return value;
+}
+
+string GeneratorValue::toString() const
+{
+    return "<generator " + function->getName() + ">";
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <memory>
+#include <exception>
+#include <ucontext.h>
+
+#include "IteratorValue.h"
+
+using std::shared_ptr;
+using std::string;
+
+class Interpreter;
+class Environment;
+class FunctionValue;
+
+// What calling a function that contains yield returns. The body runs on its
+// own stack as a coroutine: asking for a value switches to it until the next
+// yield, which switches back, so nothing after that yield runs until the next
+// value is wanted and pipelines of generators stream in bounded memory.
+class GeneratorValue : public IteratorValue
+{
+public:
+    GeneratorValue(Interpreter &interpreter, const shared_ptr<FunctionValue> &function, const shared_ptr<Environment> &scope, const Range &range = {});
+    ~GeneratorValue();
+
+    virtual bool done(Interpreter &interpreter) override;
+    virtual shared_ptr<Value> next(Interpreter &interpreter, const Range &range = {}) override;
+
+    // called by the interpreter when the body reaches a yield, returns once
+    // the next value is asked for
+    void yield(const shared_ptr<Value> &value, const Range &range = {});
+
+    // unwinds a paused body, after this the generator is done
+    void close();
+
+    string toString() const override;
+
+private:
+    enum class State
+    {
+        created,    // the body has not started
+        suspended,  // the body is paused at a yield
+        running,
+        finished
+    };
+
+    // runs the body until it yields or ends, rethrows what the body threw
+    void resume(const Range &range);
+
+    // where the coroutine starts, makecontext only passes ints so the
+    // generator's address is split in two
+    static void entry(unsigned int high, unsigned int low);
+    void run();
+
+private:
+    Interpreter &interpreter;
+    shared_ptr<FunctionValue> function;
+
+    // the body's environment at the yield it is paused at
+    shared_ptr<Environment> frameEnv;
+
+    State state;
+    bool closing;
+
+    // the value produced by the last resume, waiting for next()
+    shared_ptr<Value> pending;
+
+    // what the body threw, rethrown by resume() on the caller's stack
+    std::exception_ptr failure;
+
+    ucontext_t context;
+    ucontext_t caller;
+    void *stack;
+};
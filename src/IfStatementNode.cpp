@@ -45,6 +45,21 @@ shared_ptr<StatementNode> IfStatementNode::getElseBranch() const
     return elseBranch;
 }
 
+void IfStatementNode::setCondition(shared_ptr<ExpressionNode> condition)
+{
+    this->condition = condition;
+}
+
+void IfStatementNode::setThenBranch(shared_ptr<StatementNode> thenBranch)
+{
+    this->thenBranch = thenBranch;
+}
+
+void IfStatementNode::setElseBranch(shared_ptr<StatementNode> elseBranch)
+{
+    this->elseBranch = elseBranch;
+}
+
 void IfStatementNode::visit(Visitor *visitor)
 {
     visitor->visit(this);
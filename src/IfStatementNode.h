@@ -31,6 +31,10 @@ public:
 
     shared_ptr<StatementNode> getElseBranch() const;
 
+    void setCondition(shared_ptr<ExpressionNode> condition);
+    void setThenBranch(shared_ptr<StatementNode> thenBranch);
+    void setElseBranch(shared_ptr<StatementNode> elseBranch);
+
     virtual void visit(Visitor *visitor) override;
 private:
     shared_ptr<ExpressionNode> condition;
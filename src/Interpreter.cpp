@@ -15,7 +15,11 @@
 #include "Exceptions.h"
 #include "Parser.h"
 #include "SemanticErrorVisitor.h"
+#include "Optimizer.h"
 #include "ArrayBuilder.h"
+#include "ScriptStack.h"
+#include "Jit.h"
+#include "Profiler.h"
 
 using std::cout;
 using std::dynamic_pointer_cast;
@@ -24,6 +28,7 @@ using std::exception;
 using std::fmod;
 using std::make_shared;
 using std::shared_ptr;
+using std::static_pointer_cast;
 using std::string;
 using std::to_string;
 using std::vector;
@@ -67,8 +72,14 @@ Interpreter::Interpreter(bool isInteractive, shared_ptr<Environment> env, const
     importedModules(),
     args(args),
     currentFunctionName(""),
-    recursionDepth(0),
-    nestingLevel(0)
+    currentFunction(nullptr),
+    returning(false),
+    pendingReturn(nullptr),
+    tailCalls(false),
+    tailPosition(false),
+    tailFunction(nullptr),
+    nestingLevel(0),
+    activeGenerator(nullptr)
 {
     if (!env)
     {
@@ -86,12 +97,19 @@ Interpreter::Interpreter(bool isInteractive, shared_ptr<Environment> env, const
     cachedTrue = make_shared<BooleanValue>(true);
     cachedFalse = make_shared<BooleanValue>(false);
     cachedNull = make_shared<NullValue>();
-    cachedZero = make_shared<NumberValue>(0.0);
-    cachedOne = make_shared<NumberValue>(1.0);
+    cachedZero = make_shared<NumberValue>(0);
+    cachedOne = make_shared<NumberValue>(1);
 }
 
 Interpreter::~Interpreter()
 {
+    // paused generators hold on to environments from the middle of their body
+    vector<GeneratorValue *> paused(generators.begin(), generators.end());
+    for (auto generator : paused)
+    {
+        generator->close();
+    }
+
     // Run aggressive cleanup before destroying the interpreter
     aggressiveCleanup();
 
@@ -123,6 +141,9 @@ bool Interpreter::interpret(Node *node)
 
     // Reset the return value for each interpretation
     returnValue.reset();
+    returning = false;
+    tailFunction = nullptr;
+    tailReceiver = nullptr;
 
     // Visit the node to interpret it
     visitAllChildren(node);
@@ -238,13 +259,20 @@ void Interpreter::setupBuiltInFunctions()
 {
     env->declare("type", make_shared<BuiltinFunctionValue>(Builtins::type), true);
     env->declare("exit", make_shared<BuiltinFunctionValue>(Builtins::exit), true);
-    env->declare("len", make_shared<BuiltinFunctionValue>(Builtins::len), true);
+    lenFunction = env->declare("len", make_shared<BuiltinFunctionValue>(Builtins::len), true);
     env->declare("number", make_shared<BuiltinFunctionValue>(Builtins::toNumber), true);
     env->declare("string", make_shared<BuiltinFunctionValue>(Builtins::toString), true);
     env->declare("print", make_shared<BuiltinFunctionValue>(Builtins::print), true);
     env->declare("println", make_shared<BuiltinFunctionValue>(Builtins::println), true);
     env->declare("env", make_shared<BuiltinFunctionValue>(Builtins::dumpenv), true);
     env->declare("dumpstack", make_shared<BuiltinFunctionValue>(Builtins::dumpstack), true);
+    env->declare("Float64Array", make_shared<BuiltinFunctionValue>(Builtins::float64Array), true);
+    env->declare("Int64Array", make_shared<BuiltinFunctionValue>(Builtins::int64Array), true);
+    env->declare("Matrix", make_shared<BuiltinFunctionValue>(Builtins::matrix), true);
+    env->declare("Deque", make_shared<BuiltinFunctionValue>(Builtins::deque), true);
+    env->declare("Set", make_shared<BuiltinFunctionValue>(Builtins::set), true);
+    env->declare("PriorityQueue", make_shared<BuiltinFunctionValue>(Builtins::priorityQueue), true);
+    env->declare("range", make_shared<BuiltinFunctionValue>(Builtins::range), true);
 }
 
 void Interpreter::setupRuntimeValues()
@@ -303,6 +331,8 @@ bool Interpreter::import(const Token &moduleName, const Range &range)
         {
             env->declare("open", make_shared<BuiltinFunctionValue>(Builtins::openFile), true);
             env->declare("listdir", make_shared<BuiltinFunctionValue>(Builtins::listdir), true);
+            env->declare("listdirIter", make_shared<BuiltinFunctionValue>(Builtins::listdirIter), true);
+            env->declare("lines", make_shared<BuiltinFunctionValue>(Builtins::lines), true);
             env->declare("close", make_shared<BuiltinFunctionValue>(Builtins::closeFd), true);
             env->declare("read", make_shared<BuiltinFunctionValue>(Builtins::readFd), true);
             env->declare("write", make_shared<BuiltinFunctionValue>(Builtins::writeFd), true);
@@ -385,6 +415,9 @@ bool Interpreter::import(const Token &moduleName, const Range &range)
             failedToLoadModule(moduleName, range);
         }
 
+        Optimizer optimizer;
+        optimizer.visitAllChildren(moduleNode.value.get());
+
         // to import the module we simply visit it as though it was a node in the current ast.
         visitAllChildren(moduleNode.value.get());
 
@@ -429,12 +462,7 @@ void Interpreter::visit(StatementsNode *node)
     {
         if (auto funcDecl = dynamic_pointer_cast<FuncDeclNode>(statement))
         {
-            auto function = make_shared<FunctionValue>(
-                funcDecl->getName(),
-                funcDecl->getParams(),
-                funcDecl->getBody(),
-                env);
-            env->declare(funcDecl->getName(), function, funcDecl->isConst());
+            env->declare(funcDecl->getName(), makeFunction(funcDecl.get(), Range()), funcDecl->isConst());
         }
     }
 
@@ -447,6 +475,14 @@ void Interpreter::visit(StatementsNode *node)
         if (hadError)
             break;
         statement->visit(this);
+
+        // what the statement ran is done, the stack is the one it ran with
+        if (Profiler::ticks.load(std::memory_order_relaxed))
+        {
+            Profiler::sample(callStack, statement->getRange().getStart());
+        }
+        if (returning)
+            break;
     }
 
     // In interactive mode, print only the last non-undefined (nullptr) result
@@ -463,18 +499,21 @@ void Interpreter::visit(StatementsNode *node)
 void Interpreter::visit(NumberNode *node)
 {
     // Use cached values for common numbers for better performance
-    double value = node->getValue();
-    if (value == 0.0)
+    if (!node->isInteger())
+    {
+        returnValue = make_shared<NumberValue>(node->getValue());
+    }
+    else if (node->getIntValue() == 0)
     {
         returnValue = cachedZero;
     }
-    else if (value == 1.0)
+    else if (node->getIntValue() == 1)
     {
         returnValue = cachedOne;
     }
     else
     {
-        returnValue = make_shared<NumberValue>(value);
+        returnValue = make_shared<NumberValue>(node->getIntValue());
     }
     returnValue->setRange(node->getRange());
 }
@@ -492,9 +531,9 @@ void Interpreter::visit(StringNode *node)
 
 void Interpreter::visit(BinaryExprNode *node)
 {
-    auto left = node->getLeft();
-    auto opNode = node->getOperator();
-    auto right = node->getRight();
+    const auto &left = node->getLeft();
+    const auto &opNode = node->getOperator();
+    const auto &right = node->getRight();
 
     left->visit(this);
     if (hadError)
@@ -532,8 +571,48 @@ void Interpreter::visit(BinaryExprNode *node)
         error("right operand of binary expression is null", right->getRange());
     }
 
+    // a specialized node takes its fast path while the operands still are
+    // what it was specialized for, and becomes generic once they aren't
+    int op = opNode->getType();
+    switch (node->getSpecialization())
+    {
+    case BinaryExprNode::Specialization::numbers:
+        if (leftValue->getType() == Value::Type::number && rightValue->getType() == Value::Type::number)
+        {
+            returnValue = numberOperation(op, leftValue, rightValue);
+            return;
+        }
+        node->setSpecialization(BinaryExprNode::Specialization::generic);
+        break;
+    case BinaryExprNode::Specialization::strings:
+        if (leftValue->getType() == Value::Type::string_ && rightValue->getType() == Value::Type::string_)
+        {
+            returnValue = stringOperation(op, leftValue, rightValue);
+            return;
+        }
+        node->setSpecialization(BinaryExprNode::Specialization::generic);
+        break;
+    case BinaryExprNode::Specialization::unspecialized:
+        if (op != Token::AND && op != Token::OR && leftValue->getType() == Value::Type::number && rightValue->getType() == Value::Type::number)
+        {
+            node->setSpecialization(BinaryExprNode::Specialization::numbers);
+            returnValue = numberOperation(op, leftValue, rightValue);
+            return;
+        }
+        if ((op == '+' || op == Token::EQ || op == Token::NE) && leftValue->getType() == Value::Type::string_ && rightValue->getType() == Value::Type::string_)
+        {
+            node->setSpecialization(BinaryExprNode::Specialization::strings);
+            returnValue = stringOperation(op, leftValue, rightValue);
+            return;
+        }
+        node->setSpecialization(BinaryExprNode::Specialization::generic);
+        break;
+    case BinaryExprNode::Specialization::generic:
+        break;
+    }
+
     returnValue = nullptr;
-    switch (opNode->getType())
+    switch (op)
     {
     case '+':
         returnValue = leftValue->add(rightValue);
@@ -574,6 +653,21 @@ void Interpreter::visit(BinaryExprNode *node)
     case Token::OR:
         returnValue = leftValue->logicalOr(rightValue);
         break;
+    case '&':
+        returnValue = leftValue->bitAnd(rightValue);
+        break;
+    case '|':
+        returnValue = leftValue->bitOr(rightValue);
+        break;
+    case '^':
+        returnValue = leftValue->bitXor(rightValue);
+        break;
+    case Token::SHL:
+        returnValue = leftValue->shiftLeft(rightValue);
+        break;
+    case Token::SHR:
+        returnValue = leftValue->shiftRight(rightValue);
+        break;
     default:
         errorAt("unsupported binary operation: " + opNode->getToken().getValue(), opNode->getRange().getStart(), node->getRange());
     }
@@ -594,8 +688,221 @@ void Interpreter::visit(BinaryExprNode *node)
     errorAt("unsupported operation between " + leftValue->typeAsString() + " and " + rightValue->typeAsString(), opNode->getRange().getStart(), node->getRange());
 }
 
+shared_ptr<Value> Interpreter::numberOperation(int op, const shared_ptr<Value> &leftValue, const shared_ptr<Value> &rightValue)
+{
+    auto &left = static_cast<const NumberValue &>(*leftValue);
+    auto &right = static_cast<const NumberValue &>(*rightValue);
+    Range range(left.getRange().getStart(), right.getRange().getEnd());
+
+    // integers are exact, the double path below matches NumberValue for the
+    // operators it handles, the rest go to NumberValue directly
+    if (left.isInt() && right.isInt())
+    {
+        int64_t a = left.getInt();
+        int64_t b = right.getInt();
+        int64_t result;
+        switch (op)
+        {
+        case '+':
+            if (!__builtin_add_overflow(a, b, &result))
+            {
+                return make_shared<NumberValue>(result, range);
+            }
+            break;
+        case '-':
+            if (!__builtin_sub_overflow(a, b, &result))
+            {
+                return make_shared<NumberValue>(result, range);
+            }
+            break;
+        case '*':
+            if (!__builtin_mul_overflow(a, b, &result))
+            {
+                return make_shared<NumberValue>(result, range);
+            }
+            break;
+        case '<':
+            return a < b ? cachedTrue : cachedFalse;
+        case '>':
+            return a > b ? cachedTrue : cachedFalse;
+        case Token::LE:
+            return a <= b ? cachedTrue : cachedFalse;
+        case Token::GE:
+            return a >= b ? cachedTrue : cachedFalse;
+        case Token::EQ:
+            return a == b ? cachedTrue : cachedFalse;
+        case Token::NE:
+            return a != b ? cachedTrue : cachedFalse;
+        default:
+            break;
+        }
+    }
+
+    double a = left.getValue();
+    double b = right.getValue();
+    switch (op)
+    {
+    case '+':
+        return make_shared<NumberValue>(a + b, range);
+    case '-':
+        return make_shared<NumberValue>(a - b, range);
+    case '*':
+        return make_shared<NumberValue>(a * b, range);
+    case '<':
+        return a < b ? cachedTrue : cachedFalse;
+    case '>':
+        return a > b ? cachedTrue : cachedFalse;
+    case Token::LE:
+        return a <= b ? cachedTrue : cachedFalse;
+    case Token::GE:
+        return a >= b ? cachedTrue : cachedFalse;
+    case Token::NE:
+        return a != b ? cachedTrue : cachedFalse;
+    default:
+        break;
+    }
+
+    auto other = static_pointer_cast<NumberValue>(rightValue);
+    switch (op)
+    {
+    case '/':
+        return left.div(other);
+    case '%':
+        return left.mod(other);
+    case Token::EQ:
+        return left.eq(other);
+    case '&':
+        return left.bitAnd(other);
+    case '|':
+        return left.bitOr(other);
+    case '^':
+        return left.bitXor(other);
+    case Token::SHL:
+        return left.shiftLeft(other);
+    case Token::SHR:
+        return left.shiftRight(other);
+    default:
+        errorAt("unsupported binary operation between numbers", range.getStart(), range);
+    }
+}
+
+shared_ptr<Value> Interpreter::stringOperation(int op, const shared_ptr<Value> &leftValue, const shared_ptr<Value> &rightValue)
+{
+    auto &left = static_cast<const StringValue &>(*leftValue);
+    auto &right = static_cast<const StringValue &>(*rightValue);
+    switch (op)
+    {
+    case Token::EQ:
+        return left.view() == right.view() ? cachedTrue : cachedFalse;
+    case Token::NE:
+        return left.view() != right.view() ? cachedTrue : cachedFalse;
+    default:
+        return left.add(static_pointer_cast<StringValue>(rightValue));
+    }
+}
+
+shared_ptr<Value> Interpreter::stepNumericLocal(VarExprNode *variable, int delta, bool prefix)
+{
+    const string &name = variable->getName();
+    auto owner = env->resolve(name);
+    auto current = owner ? owner->lookupLocal(name) : nullptr;
+    if (!current || current->getType() != Value::Type::number || current.use_count() != 2)
+    {
+        return nullptr;
+    }
+
+    auto number = static_cast<NumberValue *>(current.get());
+    int64_t result;
+    if (!number->isInt() || __builtin_add_overflow(number->getInt(), static_cast<int64_t>(delta), &result))
+    {
+        return nullptr;
+    }
+
+    int64_t original = number->getInt();
+    number->setValue(result);
+    if (prefix)
+    {
+        current->setRange(variable->getRange());
+        return current;
+    }
+    return make_shared<NumberValue>(original, variable->getRange());
+}
+
+shared_ptr<Value> Interpreter::updateNumericLocal(VarExprNode *variable, int op, const shared_ptr<Value> &operand)
+{
+    if (operand->getType() != Value::Type::number)
+    {
+        return nullptr;
+    }
+
+    const string &name = variable->getName();
+    auto owner = env->resolve(name);
+    auto current = owner ? owner->lookupLocal(name) : nullptr;
+    if (!current || current->getType() != Value::Type::number || current.use_count() != 2)
+    {
+        return nullptr;
+    }
+
+    // the same results NumberValue's operators give, integers that overflow
+    // become doubles
+    auto number = static_cast<NumberValue *>(current.get());
+    auto other = static_cast<const NumberValue *>(operand.get());
+    bool integers = number->isInt() && other->isInt();
+    int64_t result;
+    switch (op)
+    {
+    case Token::PLUS_EQUAL:
+        if (integers && !__builtin_add_overflow(number->getInt(), other->getInt(), &result))
+        {
+            number->setValue(result);
+        }
+        else
+        {
+            number->setValue(number->getValue() + other->getValue());
+        }
+        break;
+    case Token::MINUS_EQUAL:
+        if (integers && !__builtin_sub_overflow(number->getInt(), other->getInt(), &result))
+        {
+            number->setValue(result);
+        }
+        else
+        {
+            number->setValue(number->getValue() - other->getValue());
+        }
+        break;
+    case Token::MUL_EQUAL:
+        if (integers && !__builtin_mul_overflow(number->getInt(), other->getInt(), &result))
+        {
+            number->setValue(result);
+        }
+        else
+        {
+            number->setValue(number->getValue() * other->getValue());
+        }
+        break;
+    default:
+        return nullptr;
+    }
+    return current;
+}
+
 void Interpreter::visit(UnaryExprNode *node)
 {
+    int op = node->getOperator()->getType();
+    if (op == Token::INC || op == Token::DEC)
+    {
+        auto variable = dynamic_cast<VarExprNode *>(node->getExpression().get());
+        if (variable && variable->isNumericLocal())
+        {
+            returnValue = stepNumericLocal(variable, op == Token::INC ? 1 : -1, node->isPrefix());
+            if (returnValue)
+            {
+                return;
+            }
+        }
+    }
+
     returnValue = evalUnaryExpression(node->getExpression(), node->getOperator(), node->isPrefix());
 }
 
@@ -634,6 +941,9 @@ shared_ptr<Value> Interpreter::evalUnaryExpression(shared_ptr<ExpressionNode> ex
     case '-':
         returnValue = value->unaryMinus();
         break;
+    case '~':
+        returnValue = value->bitNot();
+        break;
     case '?':
         if (returnValue)
         {
@@ -681,7 +991,7 @@ shared_ptr<Value> Interpreter::evalIncrementDecrement(shared_ptr<ExpressionNode>
         if (currentVal->getType() == Value::Type::number)
         {
             auto numberValue = dynamic_pointer_cast<NumberValue>(currentVal);
-            newVal = make_shared<NumberValue>(numberValue->getValue() + 1);
+            newVal = numberValue->plus(1);
         }
         else
         {
@@ -694,7 +1004,7 @@ shared_ptr<Value> Interpreter::evalIncrementDecrement(shared_ptr<ExpressionNode>
         if (currentVal->getType() == Value::Type::number)
         {
             auto numberValue = dynamic_pointer_cast<NumberValue>(currentVal);
-            newVal = make_shared<NumberValue>(numberValue->getValue() - 1);
+            newVal = numberValue->plus(-1);
         }
         else
         {
@@ -732,10 +1042,15 @@ shared_ptr<Value> Interpreter::evalIncrementDecrement(shared_ptr<ExpressionNode>
         {
             if (auto numberIdx = dynamic_pointer_cast<NumberValue>(indexValue))
             {
-                int idx = (int)numberIdx->getValue();
-                if (idx >= 0 && idx < (int)arrayObj->getElements().size())
+                int64_t idx = numberIdx->indexInto(arrayObj->getElements().size());
+                if (!numberIdx->isWhole())
+                {
+                    error("array index must be a whole number: " + numberIdx->toString(), expression->getRange());
+                    return nullptr;
+                }
+                else if (idx >= 0)
                 {
-                    arrayObj->setElement(idx, newVal);
+                    arrayObj->setElement(static_cast<int>(idx), newVal);
                 }
                 else
                 {
@@ -749,6 +1064,27 @@ shared_ptr<Value> Interpreter::evalIncrementDecrement(shared_ptr<ExpressionNode>
                 return nullptr;
             }
         }
+        else if (auto typedArray = dynamic_pointer_cast<TypedArrayValue>(arrayValue))
+        {
+            auto numberIdx = dynamic_pointer_cast<NumberValue>(indexValue);
+            if (!numberIdx || !numberIdx->isWhole())
+            {
+                error("typed array index must be a whole number", expression->getRange());
+                return nullptr;
+            }
+            int64_t idx = numberIdx->indexInto(typedArray->length());
+            if (idx < 0)
+            {
+                error("Array index out of bounds", expression->getRange());
+                return nullptr;
+            }
+            auto number = static_pointer_cast<NumberValue>(newVal);
+            if (!typedArray->set(static_cast<size_t>(idx), *number))
+            {
+                error(TypedArrayValue::rangeMessage(number->getValue()), expression->getRange());
+                return nullptr;
+            }
+        }
         else
         {
             error("Cannot index non-array value", expression->getRange());
@@ -805,93 +1141,183 @@ bool Interpreter::validateFunctionArguments(shared_ptr<FunctionValue> function,
     return true;
 }
 
-shared_ptr<Value> Interpreter::callUserFunction(shared_ptr<FunctionValue> function, const vector<shared_ptr<Value>>& args, const Range& nodeRange)
+shared_ptr<Value> Interpreter::runBody(const shared_ptr<StatementNode> &body)
 {
-    // Check recursion depth to prevent stack overflow
-    if (recursionDepth >= MAX_RECURSION_DEPTH)
+    // the caller isn't a callUserFunction that could make a tail call
+    bool oldTailCalls = tailCalls;
+    tailCalls = false;
+    try
     {
-        error("maximum recursion depth exceeded (" + to_string(MAX_RECURSION_DEPTH) + ")", nodeRange);
-        return nullptr;
+        body->visit(this);
     }
-
-    if (!validateFunctionArguments(function, args, nodeRange))
+    catch (const BaseException &e)
     {
-        return nullptr;
+        tailCalls = oldTailCalls;
+        throw;
     }
+    tailCalls = oldTailCalls;
 
-    if (!function->getBody())
+    if (!returning)
     {
-        error("function '" + function->getName() + "' has no body", nodeRange);
         return nullptr;
     }
+    returning = false;
+    return std::move(pendingReturn);
+}
 
+shared_ptr<Environment> Interpreter::callScope(const shared_ptr<FunctionValue> &function, const vector<shared_ptr<Value>> &args, const shared_ptr<Environment> &callerEnv)
+{
     // Set up function call environment
     shared_ptr<Environment> closureEnv = function->getEnvironment();
     if (!closureEnv) {
         // If the function's closure environment is null, use the current environment as fallback
         // This can happen if the closure environment was cleared due to cleanup
-        closureEnv = env;
+        closureEnv = callerEnv;
     }
-    shared_ptr<Environment> scope = make_shared<Environment>(closureEnv);
+
+    // a scope nothing in the body can capture comes from the pool, and goes
+    // back to it unless something kept it after all
+    shared_ptr<Environment> scope = function->capturesFrame() ? make_shared<Environment>(closureEnv) : acquireEnvironment(closureEnv);
     for (size_t i = 0; i < args.size(); ++i)
     {
         scope->declare(function->getParameters()->getParam(i)->getName(), args[i]);
     }
 
-    auto previousEnv = env;
-    env = scope;
+    // a flat closure didn't capture itself, its name is found here instead
+    if (function->isSelfReferencing())
+    {
+        scope->declare(function->getName(), function);
+    }
 
     // Track this function call scope for cleanup
-    tempEnvironments.push_back(scope);
+    if (function->capturesFrame() && !function->isGenerator())
+    {
+        tempEnvironments.push_back(scope);
+    }
+    return scope;
+}
+
+shared_ptr<Value> Interpreter::callUserFunction(shared_ptr<FunctionValue> function, const vector<shared_ptr<Value>>& args, const Range& nodeRange)
+{
+    // Stop before the call could overflow the stack
+    if (ScriptStack::exhausted())
+    {
+        error("maximum recursion depth exceeded (stack size " + ScriptStack::formatSize(ScriptStack::current().size) + ", see --max-stack)", nodeRange);
+        return nullptr;
+    }
+
+    if (!validateFunctionArguments(function, args, nodeRange))
+    {
+        return nullptr;
+    }
+
+    if (!function->getBody())
+    {
+        error("function '" + function->getName() + "' has no body", nodeRange);
+        return nullptr;
+    }
+
+    shared_ptr<Environment> scope = callScope(function, args, env);
+
+    // a generator's body runs when its values are asked for
+    if (function->isGenerator())
+    {
+        return make_shared<GeneratorValue>(*this, function, scope, nodeRange);
+    }
 
-    // Increment recursion depth and update function name
-    recursionDepth++;
+    auto previousEnv = env;
+    env = scope;
+
+    // Update function name
     string oldFunctionName = currentFunctionName;
     currentFunctionName = function->getName();
+    FunctionValue *oldFunction = currentFunction;
+    currentFunction = function.get();
+    bool oldTailCalls = tailCalls;
+    tailCalls = true;
+
+    // the arguments and receiver of a tail call this call was replaced by
+    vector<shared_ptr<Value>> tailCallArgs;
+    shared_ptr<Value> tailCallReceiver;
 
     shared_ptr<Value> result = nullptr;
     try
     {
-        callStack.push(currentFunctionName, function->getRange());
+        callStack.push(function->getCallStackId(), function->getRange());
         nestingLevel++; // Increment nesting level when entering function body
-        function->getBody()->visit(this);
+        while (true)
+        {
+            function->getBody()->visit(this);
+
+            result = nullptr; // Normal function completion without return
+            if (returning)
+            {
+                returning = false;
+                result = std::move(pendingReturn);
+            }
+
+            if (!tailFunction)
+            {
+                break;
+            }
+
+            // a tail call runs in this call's place, the finished scope is
+            // released first so a tail recursive loop reuses the same one
+            auto callee = std::move(tailFunction);
+            tailCallArgs = std::move(tailArgs);
+            tailCallReceiver = std::move(tailReceiver);
+            validateFunctionArguments(callee, tailCallArgs, tailRange);
+            if (!callee->getBody())
+            {
+                error("function '" + callee->getName() + "' has no body", tailRange);
+            }
+
+            env = previousEnv;
+            if (!function->capturesFrame())
+            {
+                releaseEnvironment(scope);
+            }
+
+            function = std::move(callee);
+            scope = callScope(function, tailCallArgs, previousEnv);
+            env = scope;
+            currentFunctionName = function->getName();
+            currentFunction = function.get();
+            callStack.pop();
+            callStack.push(function->getCallStackId(), function->getRange());
+        }
         nestingLevel--; // Decrement nesting level when leaving function body
-        result = nullptr; // Normal function completion without return
-    }
-    catch (const ReturnException &e)
-    {
-        nestingLevel--; // Restore nesting level on return
-        result = e.value;
     }
     catch (const BaseException &e)
     {
         // Restore state before re-throwing
         nestingLevel--; // Restore nesting level on exception
-        recursionDepth--;
         currentFunctionName = oldFunctionName;
+        currentFunction = oldFunction;
+        tailCalls = oldTailCalls;
+        tailFunction = nullptr;
+        tailReceiver = nullptr;
         env = previousEnv;
         callStack.pop();
+        if (!function->capturesFrame())
+        {
+            releaseEnvironment(scope);
+        }
         throw;
     }
 
     callStack.pop();
 
     // Restore state
-    recursionDepth--;
     currentFunctionName = oldFunctionName;
+    currentFunction = oldFunction;
+    tailCalls = oldTailCalls;
 
-    // Handle closure cleanup for returned functions
-    if (result && result->getType() == Value::Type::function)
+    env = previousEnv;
+    if (!function->capturesFrame())
     {
-        auto returnedFunc = dynamic_pointer_cast<FunctionValue>(result);
-        if (returnedFunc && returnedFunc->getEnvironment() == scope)
-        {
-            // Break circular reference
-            returnedFunc->clearClosureEnv();
-        }
+        releaseEnvironment(scope);
     }
-
-    env = previousEnv;
     return result;
 }
 
@@ -966,17 +1392,15 @@ shared_ptr<Value> Interpreter::callClassConstructor(shared_ptr<ClassValue> class
             }
 
             auto constructorPrevEnv = env;
+            auto constructorPrevFunction = currentFunction;
             env = scope;
+            currentFunction = constructor.get();
 
             try
             {
-                callStack.push(constructor->getName(), constructor->getRange());
-                constructor->getBody()->visit(this);
-            }
-            catch (const ReturnException &e)
-            {
-                callStack.pop();
-                if (e.value && e.value->getType() != Value::Type::null)
+                callStack.push(constructor->getCallStackId(), constructor->getRange());
+                auto value = runBody(constructor->getBody());
+                if (value && value->getType() != Value::Type::null)
                 {
                     error("constructor of class '" + classValue->getName() + "' returned a value, which is not allowed", nodeRange);
                 }
@@ -985,11 +1409,13 @@ shared_ptr<Value> Interpreter::callClassConstructor(shared_ptr<ClassValue> class
             {
                 callStack.pop();
                 env = constructorPrevEnv;
+                currentFunction = constructorPrevFunction;
                 throw;
             }
             callStack.pop();
 
             env = constructorPrevEnv;
+            currentFunction = constructorPrevFunction;
         }
 
         // Create and return the class instance
@@ -1051,7 +1477,7 @@ shared_ptr<Value> Interpreter::evalVariableUnaryExpression(shared_ptr<VarExprNod
             return nullptr;
         }
         auto numberValue = dynamic_pointer_cast<NumberValue>(value);
-        auto tmp = make_shared<NumberValue>(numberValue->getValue() + 1);
+        auto tmp = numberValue->plus(1);
         env->assign(expression->getName(), tmp);
 
         if (prefix)
@@ -1073,7 +1499,7 @@ shared_ptr<Value> Interpreter::evalVariableUnaryExpression(shared_ptr<VarExprNod
             return nullptr;
         }
         auto numberValue = dynamic_pointer_cast<NumberValue>(value);
-        auto tmp = make_shared<NumberValue>(numberValue->getValue() - 1);
+        auto tmp = numberValue->plus(-1);
         env->assign(expression->getName(), tmp);
 
         if (prefix)
@@ -1094,9 +1520,30 @@ shared_ptr<Value> Interpreter::evalVariableUnaryExpression(shared_ptr<VarExprNod
 
 void Interpreter::visit(CallNode *node)
 {
-    // Evaluate the callee first to fail fast if it's not callable
+    bool tail = tailPosition;
+    tailPosition = false;
+
+    // Evaluate the callee first to fail fast if it's not callable. For
+    // obj.method() the method is called with obj held here rather than
+    // bound to it, which would make a new builtin for every call.
     auto calleeNode = node->getCallee();
-    calleeNode->visit(this);
+    auto memberAccess = dynamic_cast<MemberAccessNode *>(calleeNode.get());
+    shared_ptr<Value> receiver;
+    if (memberAccess)
+    {
+        memberAccess->getExpression()->visit(this);
+        if (!returnValue)
+        {
+            error("member access left-hand side evaluated to null", memberAccess->getExpression()->getRange());
+            return;
+        }
+        receiver = returnValue;
+        returnValue = evalMemberAccess(memberAccess, receiver, false);
+    }
+    else
+    {
+        calleeNode->visit(this);
+    }
     if (hadError || !returnValue)
     {
         returnValue = nullptr;
@@ -1115,6 +1562,11 @@ void Interpreter::visit(CallNode *node)
         return;
     }
 
+    if (callee->getType() == Value::Type::builtin && callNative(static_cast<const BuiltinFunctionValue &>(*callee), node))
+    {
+        return;
+    }
+
     // Now evaluate arguments (only after confirming callee is callable)
     vector<shared_ptr<Value>> args;
     if (node->getArgs())
@@ -1140,6 +1592,18 @@ void Interpreter::visit(CallNode *node)
             return;
         }
 
+        // the calling function's callUserFunction makes the call once this
+        // one's body has returned
+        if (tail && !hadError && !function->isGenerator())
+        {
+            tailFunction = std::move(function);
+            tailArgs = std::move(args);
+            tailReceiver = std::move(receiver);
+            tailRange = node->getRange();
+            returnValue = nullptr;
+            return;
+        }
+
         returnValue = callUserFunction(function, args, node->getRange());
     }
     else if (callee->getType() == Value::Type::builtin)
@@ -1154,12 +1618,12 @@ void Interpreter::visit(CallNode *node)
 
         // For member access (e.g., obj.method()), use the identifier range to point to the method name
         Range callRange = calleeNode->getRange();
-        if (auto memberAccess = dynamic_cast<MemberAccessNode *>(calleeNode.get()))
+        if (memberAccess)
         {
             callRange = memberAccess->getIdentifier().getRange();
         }
 
-        callStack.push(callee->toString(), callRange);
+        callStack.push(BuiltinFunctionValue::callStackId(), callRange);
         returnValue = builtin->call(*this, args, env, callRange);
         callStack.pop();
     }
@@ -1182,20 +1646,87 @@ void Interpreter::visit(CallNode *node)
     }
 }
 
-void Interpreter::visit(ReturnStatementNode *node)
+bool Interpreter::callNative(const BuiltinFunctionValue &builtin, CallNode *node)
 {
-    auto expr = node->getExpression();
-    if (!expr)
+    static const size_t MAX_ARGS = 4;
+
+    NativeFunction native = builtin.getNative();
+    auto argList = node->getArgs();
+    if (!native || (argList && argList->getArgs().size() > MAX_ARGS))
     {
-        throw ReturnException(nullptr, node->getRange());
+        return false;
     }
 
-    expr->visit(this);
-    if (!returnValue)
+    shared_ptr<Value> args[MAX_ARGS];
+    size_t count = 0;
+    if (argList)
     {
-        throw ReturnException(make_shared<NullValue>(), node->getRange());
+        for (auto &arg : argList->getArgs())
+        {
+            if (hadError)
+                break;
+            arg->visit(this);
+            args[count++] = std::move(returnValue);
+        }
+    }
+
+    // For member access (e.g., obj.method()), use the identifier range to point to the method name
+    Range callRange = node->getCallee()->getRange();
+    if (auto memberAccess = dynamic_cast<MemberAccessNode *>(node->getCallee().get()))
+    {
+        callRange = memberAccess->getIdentifier().getRange();
+    }
+
+    CallStack::Native pending(callStack, BuiltinFunctionValue::callStackId(), callRange);
+    returnValue = native(*this, Arguments(args, count), callRange);
+    return true;
+}
+
+shared_ptr<Value> Interpreter::call(const shared_ptr<Value> &callee, const vector<shared_ptr<Value>> &args, const Range &range)
+{
+    switch (callee->getType())
+    {
+        case Value::Type::function:
+            return callUserFunction(static_pointer_cast<FunctionValue>(callee), args, range);
+        case Value::Type::builtin:
+        {
+            callStack.push(BuiltinFunctionValue::callStackId(), range);
+            auto result = static_pointer_cast<BuiltinFunctionValue>(callee)->call(*this, args, env, range);
+            callStack.pop();
+            return result;
+        }
+        case Value::Type::class_:
+            return callClassConstructor(static_pointer_cast<ClassValue>(callee), args, range);
+        default:
+            error("cannot call non-function value: " + callee->typeAsString(), range);
+            return nullptr;
+    }
+}
+
+void Interpreter::visit(ReturnStatementNode *node)
+{
+    auto expr = node->getExpression();
+    if (!expr)
+    {
+        pendingReturn = nullptr;
+        returning = true;
+        return;
+    }
+
+    // a call returned as it is can run in place of this call
+    tailPosition = tailCalls && dynamic_cast<CallNode *>(expr.get());
+    expr->visit(this);
+    tailPosition = false;
+
+    if (tailFunction)
+    {
+        pendingReturn = nullptr;
+    }
+    else
+    {
+        pendingReturn = returnValue ? returnValue : make_shared<NullValue>();
     }
-    throw ReturnException(returnValue, node->getRange());
+    returning = true;
 }
 
 void Interpreter::visit(VarDeclNode *node)
@@ -1290,6 +1821,15 @@ void Interpreter::visit(AssignNode *node)
     }
 
     auto asignee = dynamic_pointer_cast<VarExprNode>(node->getAsignee());
+    if (asignee && asignee->isNumericLocal() && node->getOp() != '=')
+    {
+        if (auto updated = updateNumericLocal(asignee.get(), node->getOp(), value))
+        {
+            returnValue = updated;
+            return;
+        }
+    }
+
     if (asignee)
     {
         switch (node->getOp())
@@ -1301,13 +1841,29 @@ void Interpreter::visit(AssignNode *node)
             }
             case Token::PLUS_EQUAL:
             {
-                auto existingValue = env->lookup(asignee->getName());
+                auto owner = env->resolve(asignee->getName());
+                auto existingValue = owner ? owner->lookupLocal(asignee->getName()) : nullptr;
                 if (!existingValue)
                 {
                     notDefined(asignee);
                     returnValue = nullptr;
                     return;
                 }
+
+                // Append in place when the string is only referenced by this
+                // variable (the environment and the local copy above)
+                if (existingValue->getType() == Value::Type::string_ &&
+                    existingValue.use_count() == 2 &&
+                    !owner->hasConstant(asignee->getName()) &&
+                    (value->getType() == Value::Type::string_ ||
+                     value->getType() == Value::Type::number ||
+                     value->getType() == Value::Type::boolean))
+                {
+                    static_pointer_cast<StringValue>(existingValue)->append(value->toString());
+                    returnValue = existingValue;
+                    return;
+                }
+
                 value = existingValue->add(value);
                 break;
             }
@@ -1460,6 +2016,77 @@ void Interpreter::visit(AssignNode *node)
             return;
         }
 
+        if (returnValue->getType() == Value::Type::typed_array)
+        {
+            auto typedArray = static_pointer_cast<TypedArrayValue>(returnValue);
+
+            access->getIndex()->visit(this);
+            if (!returnValue || returnValue->getType() != Value::Type::number)
+            {
+                error("array access index must be a number", access->getIndex()->getRange());
+                returnValue = nullptr;
+                return;
+            }
+
+            auto indexValue = static_pointer_cast<NumberValue>(returnValue);
+            if (!indexValue->isWhole())
+            {
+                error("array index must be a whole number: " + indexValue->toString(), access->getIndex()->getRange());
+                returnValue = nullptr;
+                return;
+            }
+            int64_t index = indexValue->indexInto(typedArray->length());
+            if (index < 0)
+            {
+                error("array index out of bounds: " + indexValue->toString() + " for array of length: " + to_string(typedArray->length()), access->getIndex()->getRange());
+                returnValue = nullptr;
+                return;
+            }
+
+            shared_ptr<Value> element = typedArray->getElement(static_cast<size_t>(index), access->getRange());
+            switch (node->getOp())
+            {
+            case '=':
+                break;
+            case Token::PLUS_EQUAL:
+                value = element->add(value);
+                break;
+            case Token::MINUS_EQUAL:
+                value = element->sub(value);
+                break;
+            case Token::MUL_EQUAL:
+                value = element->mul(value);
+                break;
+            case Token::DIV_EQUAL:
+                value = element->div(value);
+                break;
+            case Token::MOD_EQUAL:
+                value = element->mod(value);
+                break;
+            default:
+                error("invalid assignment operator", node->getRange());
+                returnValue = nullptr;
+                return;
+            }
+
+            if (!value || value->getType() != Value::Type::number)
+            {
+                error("typed array elements must be numbers", node->getExpr()->getRange());
+                returnValue = nullptr;
+                return;
+            }
+
+            auto number = static_pointer_cast<NumberValue>(value);
+            if (!typedArray->set(static_cast<size_t>(index), *number))
+            {
+                error(TypedArrayValue::rangeMessage(number->getValue()), node->getExpr()->getRange());
+                returnValue = nullptr;
+                return;
+            }
+            returnValue = value;
+            return;
+        }
+
         if (returnValue->getType() != Value::Type::array)
         {
             error("left-hand side of array access is not an array", access->getArray()->getRange());
@@ -1490,12 +2117,17 @@ void Interpreter::visit(AssignNode *node)
             return;
         }
 
-        auto indexValue = dynamic_pointer_cast<NumberValue>(returnValue);
-        int index = indexValue ? static_cast<int>(indexValue->getValue()) : 0;
-
-        if (index < 0 || index >= arrayValue->getElementCount())
+        auto indexValue = static_pointer_cast<NumberValue>(returnValue);
+        if (!indexValue->isWhole())
+        {
+            error("array index must be a whole number: " + indexValue->toString(), access->getIndex()->getRange());
+            returnValue = nullptr;
+            return;
+        }
+        int index = static_cast<int>(indexValue->indexInto(arrayValue->getElementCount()));
+        if (index < 0)
         {
-            error("array index out of bounds: " + to_string(index) + " for array of length: " + to_string(arrayValue->getElementCount()), access->getIndex()->getRange());
+            error("array index out of bounds: " + indexValue->toString() + " for array of length: " + to_string(arrayValue->getElementCount()), access->getIndex()->getRange());
             returnValue = nullptr;
             return;
         }
@@ -1601,51 +2233,55 @@ void Interpreter::visit(BlockNode *node)
         return;
     }
 
-    shared_ptr<Environment> prevEnv = env;                            // Save previous environment
-    shared_ptr<Environment> blockEnv = make_shared<Environment>(env); // Create block environment
-    env = blockEnv;                                                   // push a new environment for the block
-
-    // Track this as a temporary environment for later cleanup
-    tempEnvironments.push_back(blockEnv);
+    shared_ptr<Environment> prevEnv = env;                      // Save previous environment
+    shared_ptr<Environment> blockEnv = acquireEnvironment(env); // Create block environment
+    env = blockEnv;                                             // push a new environment for the block
 
     try
     {
         node->getStatements()->visit(this);
     }
-    catch (const ReturnException &e)
-    {
-        env = prevEnv;
-        throw;
-    }
     catch (const BreakException &e)
     {
         env = prevEnv;
+        releaseEnvironment(blockEnv);
         throw;
     }
     catch (const ContinueException &e)
     {
         env = prevEnv;
+        releaseEnvironment(blockEnv);
         throw;
     }
     catch (const ExitException &e)
     {
         env = prevEnv;
+        releaseEnvironment(blockEnv);
         throw;
     }
     catch (const ErrorException &e)
     {
         env = prevEnv;
+        releaseEnvironment(blockEnv);
         throw;
     }
 
     env = prevEnv; // pop the environment after visiting the block
 
+    // a return leaves the block as it is, a closure being returned may need it
+    if (returning)
+    {
+        releaseEnvironment(blockEnv);
+        return;
+    }
+
     // Clean up temporary environments created during this block
     cleanupTempEnvironments();
 
     // Explicitly clear the block environment to trigger immediate cleanup
     // This is important for blocks with hoisted functions that create reference cycles
     blockEnv->clear();
+    releaseEnvironment(blockEnv);
 
     returnValue = nullptr;
 }
@@ -1681,19 +2317,95 @@ void Interpreter::visit(IfStatementNode *node)
     returnValue = nullptr;
 }
 
+shared_ptr<FunctionValue> Interpreter::makeFunction(FuncDeclNode *node, const Range &range)
+{
+    if (node->isFlat() && currentFunction && currentFunction->getEnvironment())
+    {
+        // the enclosing function's scopes end where its own closure begins
+        auto enclosing = currentFunction->getEnvironment();
+        auto outer = currentFunction->isFlat() ? enclosing->getParent() : enclosing;
+
+        bool enclosed = false;
+        for (auto scope = env.get(); scope; scope = scope->getParent().get())
+        {
+            if (scope == outer.get())
+            {
+                enclosed = true;
+                break;
+            }
+        }
+
+        if (enclosed)
+        {
+            auto captured = make_shared<Environment>(outer);
+            bool complete = true;
+            for (const auto &name : node->getCaptures())
+            {
+                if (!env->capture(name, outer.get(), *captured))
+                {
+                    // not declared yet, the whole scope is needed to see it later
+                    complete = false;
+                    break;
+                }
+            }
+
+            if (complete)
+            {
+                auto function = make_shared<FunctionValue>(node->getName(), node->getParams(), node->getBody(), captured, range, node->isGenerator());
+                function->makeFlat(node->isSelfReferencing());
+                function->setCapturesFrame(node->capturesFrame() || node->isGenerator());
+                return function;
+            }
+        }
+    }
+
+    auto function = make_shared<FunctionValue>(node->getName(), node->getParams(), node->getBody(), env, range, node->isGenerator());
+    function->setCapturesFrame(node->capturesFrame() || node->isGenerator());
+    return function;
+}
+
 void Interpreter::visit(FuncDeclNode *node)
 {
-    auto function = make_shared<FunctionValue>(node->getName(), node->getParams(), node->getBody(), env, node->getRange());
-    env->redeclare(node->getName(), function, node->isConst());
+    env->redeclare(node->getName(), makeFunction(node, node->getRange()), node->isConst());
+    returnValue = nullptr;
+}
+
+void Interpreter::visit(YieldNode *node)
+{
+    if (!activeGenerator)
+    {
+        error("'yield' used outside of a generator", node->getRange());
+    }
+
+    shared_ptr<Value> value = cachedNull;
+    if (node->getExpression())
+    {
+        node->getExpression()->visit(this);
+        if (!returnValue)
+        {
+            error("yield expression evaluated to nothing", node->getExpression()->getRange());
+        }
+        value = returnValue;
+    }
+
+    // returns when the generator is asked for its next value
+    returnValue = nullptr;
+    activeGenerator->yield(value, node->getRange());
     returnValue = nullptr;
 }
 
 void Interpreter::visit(WhileNode *node)
 {
     shared_ptr<Environment> originalEnv = env;
+    bool compiledCode = Jit::threshold != 0;
 
     while (true)
     {
+        if (compiledCode && runCompiledLoop(node->getJitState(), node->getCondition().get(), node->getBody().get(), nullptr, compiledCode))
+        {
+            break;
+        }
+
         // Evaluate condition in the original environment
         node->getCondition()->visit(this);
         if (!returnValue)
@@ -1715,7 +2427,7 @@ void Interpreter::visit(WhileNode *node)
 
         // Create a new environment for this iteration
         {
-            shared_ptr<Environment> iterationEnv = make_shared<Environment>(originalEnv);
+            shared_ptr<Environment> iterationEnv = acquireEnvironment(originalEnv);
             env = iterationEnv;
 
             // Increment nesting level to prevent printing intermediate results in loops
@@ -1738,14 +2450,9 @@ void Interpreter::visit(WhileNode *node)
                 {
                     nestingLevel--; // Restore nesting level
                     env = originalEnv;
+                    releaseEnvironment(iterationEnv);
                     continue;
                 }
-                catch (const ReturnException &e)
-                {
-                    nestingLevel--; // Restore nesting level
-                    env = originalEnv;
-                    throw;
-                }
                 catch (const ErrorException &e)
                 {
                     nestingLevel--; // Restore nesting level
@@ -1757,6 +2464,14 @@ void Interpreter::visit(WhileNode *node)
             // Restore nesting level after normal execution
             nestingLevel--;
 
+            // a return in the body ends the loop
+            if (returning)
+            {
+                env = originalEnv;
+                releaseEnvironment(iterationEnv);
+                break;
+            }
+
             // Clear any references that might be holding onto values
             returnValue = nullptr;
 
@@ -1766,139 +2481,390 @@ void Interpreter::visit(WhileNode *node)
             // Explicitly clear the iteration environment to trigger immediate cleanup
             iterationEnv->clear();
 
-            // Restore original environment - iterationEnv goes out of scope here
+            // Restore original environment and pool the iteration's
             env = originalEnv;
-        } // iterationEnv is destroyed here, allowing immediate cleanup
+            releaseEnvironment(iterationEnv);
+        }
     }
 
     returnValue = nullptr; // reset return value after the loop
 }
 
-void Interpreter::visit(ForEachNode *node)
+bool Interpreter::runCompiledLoop(Jit::LoopState &state, StatementNode *condition, StatementNode *body, ExpressionNode *increment, bool &compiledCode)
 {
-    shared_ptr<Environment> originalEnv = env;
+    if (!state.compiled)
+    {
+        if (state.attempted)
+        {
+            compiledCode = false;
+            return false;
+        }
+        if (++state.iterations < Jit::threshold)
+        {
+            return false;
+        }
 
-    // Evaluate the iterable expression in the original environment
-    node->getIterable()->visit(this);
+        state.attempted = true;
+        state.compiled = Jit::compile(condition, body, increment);
+        if (!state.compiled)
+        {
+            compiledCode = false;
+            return false;
+        }
+    }
 
-    if (node->isArrayLike())
+    if (state.compiled->run(env) == Jit::Loop::Result::finished)
     {
-        if (!returnValue || (returnValue->getType() != Value::Type::array && returnValue->getType() != Value::Type::string_))
+        return true;
+    }
+
+    // the interpreter runs this iteration and the rest of this run of the
+    // loop, its variables have stopped being integers
+    compiledCode = false;
+    return false;
+}
+
+bool Interpreter::runCountedLoop(ForStatementNode *node, const shared_ptr<Environment> &forEnv)
+{
+    const CountedLoop &loop = node->getCountedLoop();
+    auto current = dynamic_pointer_cast<NumberValue>(forEnv->lookupLocal(loop.variable));
+    if (!current || !current->isInt())
+    {
+        return false;
+    }
+
+    // a constant bound is read once, an array's length every time round
+    CountedLoop::Bound bound = loop.bound;
+    int64_t limit = 0;
+    shared_ptr<ArrayValue> array;
+    if (bound == CountedLoop::Bound::constant)
+    {
+        static_cast<BinaryExprNode *>(node->getCondition().get())->getRight()->visit(this);
+        auto number = dynamic_pointer_cast<NumberValue>(returnValue);
+        if (!number || !number->isInt())
         {
-            error("for-each loop iterable must be an array or string", node->getIterable()->getRange());
-            return;
+            return false;
+        }
+        limit = number->getInt();
+    }
+    else if (bound == CountedLoop::Bound::arrayLength)
+    {
+        array = dynamic_pointer_cast<ArrayValue>(forEnv->lookup(loop.boundName));
+        if (!array || forEnv->lookup("len") != lenFunction)
+        {
+            bound = CountedLoop::Bound::condition;
         }
+    }
 
-        if (returnValue->getType() == Value::Type::array)
+    StatementNode *body = node->getBody().get();
+    Jit::LoopState &jitState = node->getJitState();
+    bool compiledCode = Jit::threshold != 0;
+    while (true)
+    {
+        if (compiledCode)
         {
-            auto arrayValue = dynamic_pointer_cast<ArrayValue>(returnValue);
-            if (!arrayValue)
+            if (runCompiledLoop(jitState, node->getCondition().get(), body, node->getIncrement().get(), compiledCode))
             {
-                error("for-each loop iterable could not be cast to ArrayValue", node->getIterable()->getRange());
-                return;
+                return true;
             }
 
-            for (int i = 0; i < arrayValue->getElementCount(); ++i)
+            // machine code that handed the loop back stored a new number
+            if (jitState.compiled)
             {
-                // Create a new environment for this iteration
+                current = dynamic_pointer_cast<NumberValue>(forEnv->lookupLocal(loop.variable));
+                if (!current || !current->isInt())
                 {
-                    shared_ptr<Environment> iterationEnv = make_shared<Environment>(originalEnv);
-                    env = iterationEnv;
-
-                    env->redeclare(node->getKeyDecl()->getName(), arrayValue->getElement(i), node->getKeyDecl()->isConst());
-
-                    try
-                    {
-                        if (node->getBody())
-                        {
-                            node->getBody()->visit(this);
-                        }
-                    }
-                    catch (const BreakException &)
-                    {
-                        env = originalEnv;
-                        break;
-                    }
-                    catch (const ContinueException &)
-                    {
-                        env = originalEnv;
-                        continue;
-                    }
-                    catch (const ReturnException &e)
-                    {
-                        env = originalEnv;
-                        throw;
-                    }
-                    catch (const ErrorException &e)
-                    {
-                        env = originalEnv;
-                        throw;
-                    }
-
-                    // Clear any references that might be holding onto values
-                    returnValue = nullptr;
-
-                    // Environment is automatically cleaned up when iterationEnv goes out of scope
-                    env = originalEnv;
-                } // iterationEnv is destroyed here, allowing immediate cleanup
+                    return false;
+                }
             }
         }
-        else if (returnValue->getType() == Value::Type::string_)
+
+        if (bound == CountedLoop::Bound::condition)
         {
-            auto stringValue = dynamic_pointer_cast<StringValue>(returnValue);
-            if (!stringValue)
+            node->getCondition()->visit(this);
+            if (!returnValue || (returnValue->getType() != Value::Type::boolean &&
+                returnValue->getType() != Value::Type::number))
             {
-                error("for-each loop iterable could not be cast to StringValue", node->getIterable()->getRange());
-                return;
+                error("for loop condition must be a boolean expression", node->getCondition()->getRange());
+                return true;
             }
-
-            for (int i = 0; i < static_cast<int>(stringValue->length()); ++i)
+            if (!returnValue->toBoolean())
+            {
+                return true;
+            }
+        }
+        else
+        {
+            if (bound == CountedLoop::Bound::arrayLength)
             {
-                // Create a new environment for this iteration
+                // a function the body calls could have replaced the array or len
+                if (loop.bodyCalls)
                 {
-                    shared_ptr<Environment> iterationEnv = make_shared<Environment>(originalEnv);
-                    env = iterationEnv;
-
-                    // Create a StringValue for the character at position i
-                    auto charValue = make_shared<StringValue>(stringValue->getCharAt(i));
-                    env->redeclare(node->getKeyDecl()->getName(), charValue, node->getKeyDecl()->isConst());
-
-                    try
-                    {
-                        if (node->getBody())
-                        {
-                            node->getBody()->visit(this);
-                        }
-                    }
-                    catch (const BreakException &)
+                    array = dynamic_pointer_cast<ArrayValue>(forEnv->lookup(loop.boundName));
+                    if (!array || forEnv->lookup("len") != lenFunction)
                     {
-                        env = originalEnv;
-                        break;
+                        return false;
                     }
-                    catch (const ContinueException &)
+                }
+                limit = static_cast<int64_t>(array->getElements().size());
+            }
+
+            int64_t value = current->getInt();
+            bool more;
+            switch (loop.op)
+            {
+            case '<':
+                more = value < limit;
+                break;
+            case Token::LE:
+                more = value <= limit;
+                break;
+            case '>':
+                more = value > limit;
+                break;
+            default:
+                more = value >= limit;
+                break;
+            }
+            if (!more)
+            {
+                return true;
+            }
+        }
+
+        // the body is a block, which makes its own scope
+        if (body)
+        {
+            nestingLevel++;
+            try
+            {
+                body->visit(this);
+            }
+            catch (const BreakException &)
+            {
+                nestingLevel--;
+                return true;
+            }
+            catch (const ContinueException &)
+            {
+                // on to the step
+            }
+            catch (const ErrorException &)
+            {
+                nestingLevel--;
+                throw;
+            }
+            nestingLevel--;
+            env = forEnv;
+        }
+
+        if (returning)
+        {
+            return true;
+        }
+        returnValue = nullptr;
+        cleanupTempEnvironments();
+
+        // step in place unless something besides the variable holds the number
+        int64_t next;
+        if (__builtin_add_overflow(current->getInt(), static_cast<int64_t>(loop.step), &next))
+        {
+            forEnv->assign(loop.variable, current->plus(loop.step, node->getIncrement()->getRange()));
+            return false;
+        }
+        if (current.use_count() == 2)
+        {
+            current->setValue(next);
+        }
+        else
+        {
+            current = make_shared<NumberValue>(next, node->getIncrement()->getRange());
+            forEnv->assign(loop.variable, current);
+        }
+    }
+}
+
+void Interpreter::visit(ForEachNode *node)
+{
+    shared_ptr<Environment> originalEnv = env;
+
+    // Evaluate the iterable expression in the original environment
+    node->getIterable()->visit(this);
+
+    if (node->isArrayLike())
+    {
+        if (!returnValue)
+        {
+            error("for-each loop iterable must be an array or string", node->getIterable()->getRange());
+            return;
+        }
+
+        if (returnValue->getType() == Value::Type::array)
+        {
+            auto arrayValue = dynamic_pointer_cast<ArrayValue>(returnValue);
+            if (!arrayValue)
+            {
+                error("for-each loop iterable could not be cast to ArrayValue", node->getIterable()->getRange());
+                return;
+            }
+
+            for (int i = 0; i < arrayValue->getElementCount(); ++i)
+            {
+                if (!forEachIteration(node, originalEnv, arrayValue->getElement(i)))
+                {
+                    break;
+                }
+            }
+        }
+        else if (returnValue->getType() == Value::Type::string_)
+        {
+            auto stringValue = dynamic_pointer_cast<StringValue>(returnValue);
+            if (!stringValue)
+            {
+                error("for-each loop iterable could not be cast to StringValue", node->getIterable()->getRange());
+                return;
+            }
+
+            for (int i = 0; i < static_cast<int>(stringValue->length()); ++i)
+            {
+                // Create a StringValue for the character at position i
+                if (!forEachIteration(node, originalEnv, make_shared<StringValue>(stringValue->getCharAt(i))))
+                {
+                    break;
+                }
+            }
+        }
+        else if (returnValue->getType() == Value::Type::typed_array)
+        {
+            auto typedArray = static_pointer_cast<TypedArrayValue>(returnValue);
+            for (size_t i = 0; i < typedArray->length(); ++i)
+            {
+                if (!forEachIteration(node, originalEnv, typedArray->getElement(i)))
+                {
+                    break;
+                }
+            }
+        }
+        else if (returnValue->getType() == Value::Type::deque ||
+                 returnValue->getType() == Value::Type::set ||
+                 returnValue->getType() == Value::Type::priority_queue)
+        {
+            // collections are iterated over a copy of their elements so the
+            // body can modify them, a priority queue in the order it pops
+            vector<shared_ptr<Value>> elements;
+            if (returnValue->getType() == Value::Type::deque)
+            {
+                elements = static_pointer_cast<DequeValue>(returnValue)->toVector();
+            }
+            else if (returnValue->getType() == Value::Type::set)
+            {
+                elements = static_pointer_cast<SetValue>(returnValue)->toVector();
+            }
+            else
+            {
+                elements = static_pointer_cast<PriorityQueueValue>(returnValue)->toVector(*this, node->getIterable()->getRange());
+            }
+
+            for (const auto &element : elements)
+            {
+                if (!forEachIteration(node, originalEnv, element))
+                {
+                    break;
+                }
+            }
+        }
+        else if (returnValue->getType() == Value::Type::iterator)
+        {
+            // hold the iterator, the body may reassign the variable it came from
+            auto iterator = static_pointer_cast<IteratorValue>(returnValue);
+            const Range &range = node->getIterable()->getRange();
+
+            if (auto numbers = dynamic_pointer_cast<RangeIterator>(iterator))
+            {
+                // counting loops reuse one number for the loop variable unless
+                // the body kept a reference to the previous one
+                shared_ptr<NumberValue> current;
+                while (!numbers->finished())
+                {
+                    double value = numbers->advance();
+                    if (!current || current.use_count() != 1)
                     {
-                        env = originalEnv;
-                        continue;
+                        current = make_shared<NumberValue>(0, range);
                     }
-                    catch (const ReturnException &e)
+
+                    if (value == std::floor(value))
                     {
-                        env = originalEnv;
-                        throw;
+                        current->setValue(static_cast<int64_t>(value));
                     }
-                    catch (const ErrorException &e)
+                    else
                     {
-                        env = originalEnv;
-                        throw;
+                        current->setValue(value);
                     }
 
-                    // Clear any references that might be holding onto values
-                    returnValue = nullptr;
+                    if (!forEachIteration(node, originalEnv, current))
+                    {
+                        break;
+                    }
+                }
+            }
+            else
+            {
+                while (!iterator->done(*this))
+                {
+                    auto element = iterator->next(*this, range);
+                    if (!element)
+                    {
+                        error("for-each loop iterator failed to produce a value", range);
+                        return;
+                    }
 
-                    // Environment is automatically cleaned up when iterationEnv goes out of scope
-                    env = originalEnv;
-                } // iterationEnv is destroyed here, allowing immediate cleanup
+                    if (!forEachIteration(node, originalEnv, element))
+                    {
+                        break;
+                    }
+                }
             }
         }
+        else if (returnValue->getType() == Value::Type::object &&
+                 returnValue->getMember("next") && returnValue->getMember("done"))
+        {
+            // objects iterate themselves through their next() and done() methods
+            auto object = returnValue;
+            auto next = object->getMember("next");
+            auto done = object->getMember("done");
+            const Range &range = node->getIterable()->getRange();
+
+            while (true)
+            {
+                auto finished = call(done, {}, range);
+                if (!finished)
+                {
+                    error("for-each loop iterator done() must return a value", range);
+                    return;
+                }
+                if (finished->toBoolean())
+                {
+                    break;
+                }
+
+                auto element = call(next, {}, range);
+                if (!element)
+                {
+                    error("for-each loop iterator next() must return a value", range);
+                    return;
+                }
+
+                if (!forEachIteration(node, originalEnv, element))
+                {
+                    break;
+                }
+            }
+        }
+        else
+        {
+            error("for-each loop iterable must be an array or string", node->getIterable()->getRange());
+            return;
+        }
     }
     else if (node->isMapLike())
     {
@@ -1924,7 +2890,7 @@ void Interpreter::visit(ForEachNode *node)
 
             // Create a new environment for this iteration
             {
-                shared_ptr<Environment> iterationEnv = make_shared<Environment>(originalEnv);
+                shared_ptr<Environment> iterationEnv = acquireEnvironment(originalEnv);
                 env = iterationEnv;
 
                 env->redeclare(node->getKeyDecl()->getName(), make_shared<StringValue>(pair.first, Range{}), node->getKeyDecl()->isConst());
@@ -1946,17 +2912,21 @@ void Interpreter::visit(ForEachNode *node)
                 catch (const ContinueException &)
                 {
                     env = originalEnv;
+                    releaseEnvironment(iterationEnv);
                     continue;
                 }
-                catch (const ReturnException &e)
+                catch (const ErrorException &e)
                 {
                     env = originalEnv;
                     throw;
                 }
-                catch (const ErrorException &e)
+
+                // a return in the body ends the loop
+                if (returning)
                 {
                     env = originalEnv;
-                    throw;
+                    releaseEnvironment(iterationEnv);
+                    break;
                 }
 
                 // Clear any references that might be holding onto values
@@ -1969,7 +2939,8 @@ void Interpreter::visit(ForEachNode *node)
                 iterationEnv->clear();
 
                 env = originalEnv;
-            } // iterationEnv is destroyed here, allowing immediate cleanup
+                releaseEnvironment(iterationEnv);
+            }
         }
     }
     else
@@ -1981,6 +2952,52 @@ void Interpreter::visit(ForEachNode *node)
     returnValue = nullptr;
 }
 
+bool Interpreter::forEachIteration(ForEachNode *node, const shared_ptr<Environment> &originalEnv, const shared_ptr<Value> &element)
+{
+    // Create a new environment for this iteration
+    shared_ptr<Environment> iterationEnv = acquireEnvironment(originalEnv);
+    env = iterationEnv;
+
+    env->redeclare(node->getKeyDecl()->getName(), element, node->getKeyDecl()->isConst());
+
+    try
+    {
+        if (node->getBody())
+        {
+            node->getBody()->visit(this);
+        }
+    }
+    catch (const BreakException &)
+    {
+        env = originalEnv;
+        return false;
+    }
+    catch (const ContinueException &)
+    {
+        env = originalEnv;
+        releaseEnvironment(iterationEnv);
+        return true;
+    }
+    catch (const ErrorException &e)
+    {
+        env = originalEnv;
+        throw;
+    }
+
+    env = originalEnv;
+    releaseEnvironment(iterationEnv);
+
+    // a return in the body ends the loop
+    if (returning)
+    {
+        return false;
+    }
+
+    // Clear any references that might be holding onto values
+    returnValue = nullptr;
+    return true;
+}
+
 void Interpreter::visit(ForStatementNode *node)
 {
     shared_ptr<Environment> originalEnv = env;
@@ -1997,8 +3014,24 @@ void Interpreter::visit(ForStatementNode *node)
             node->getInit()->visit(this);
         }
 
+        if (node->getCountedLoop().counted && runCountedLoop(node, forEnv))
+        {
+            env = originalEnv;
+            if (!returning)
+            {
+                returnValue = nullptr;
+            }
+            return;
+        }
+
+        bool compiledCode = Jit::threshold != 0;
         while (true)
         {
+            if (compiledCode && runCompiledLoop(node->getJitState(), node->getCondition().get(), node->getBody().get(), node->getIncrement().get(), compiledCode))
+            {
+                break;
+            }
+
             // Evaluate condition in the for environment
             if (node->getCondition())
             {
@@ -2017,7 +3050,7 @@ void Interpreter::visit(ForStatementNode *node)
 
             // Create a new environment for this iteration's body
             {
-                shared_ptr<Environment> iterationEnv = make_shared<Environment>(forEnv);
+                shared_ptr<Environment> iterationEnv = acquireEnvironment(forEnv);
                 env = iterationEnv;
 
                 // don't visit an empty body
@@ -2039,18 +3072,13 @@ void Interpreter::visit(ForStatementNode *node)
                         nestingLevel--; // Restore nesting level
                         // Restore for environment and execute increment
                         env = forEnv;
+                        releaseEnvironment(iterationEnv);
                         if (node->getIncrement())
                         {
                             node->getIncrement()->visit(this);
                         }
                         continue;
                     }
-                    catch (const ReturnException &e)
-                    {
-                        nestingLevel--; // Restore nesting level
-                        env = originalEnv;
-                        throw;
-                    }
                     catch (const ErrorException &e)
                     {
                         nestingLevel--; // Restore nesting level
@@ -2060,6 +3088,14 @@ void Interpreter::visit(ForStatementNode *node)
                     nestingLevel--; // Restore nesting level after normal execution
                 }
 
+                // a return in the body ends the loop
+                if (returning)
+                {
+                    env = originalEnv;
+                    releaseEnvironment(iterationEnv);
+                    return;
+                }
+
                 // Clear any references that might be holding onto values
                 returnValue = nullptr;
 
@@ -2069,9 +3105,10 @@ void Interpreter::visit(ForStatementNode *node)
                 // Explicitly clear the iteration environment to trigger immediate cleanup
                 iterationEnv->clear();
 
-                // Restore for environment - iterationEnv goes out of scope here
+                // Restore for environment and pool the iteration's
                 env = forEnv;
-            } // iterationEnv is destroyed here, allowing immediate cleanup
+                releaseEnvironment(iterationEnv);
+            }
             if (node->getIncrement())
             {
                 node->getIncrement()->visit(this);
@@ -2086,11 +3123,6 @@ void Interpreter::visit(ForStatementNode *node)
     {
         // handle continue statement
     }
-    catch (const ReturnException &e)
-    {
-        env = originalEnv;
-        throw;
-    }
     catch (const ErrorException &e)
     {
         env = originalEnv;
@@ -2130,6 +3162,15 @@ void Interpreter::visit(ImportNode *node)
 
 void Interpreter::visit(ArrayNode *node)
 {
+    // Literals made only of constants are built once. Every evaluation shares
+    // those values and the array copies them on its first write.
+    auto constantValues = node->getConstantValues();
+    if (constantValues)
+    {
+        returnValue = make_shared<ArrayValue>(constantValues, 0, constantValues->size(), node->getRange());
+        return;
+    }
+
     vector<shared_ptr<Value>> elements;
     for (const auto &element : node->getElements())
     {
@@ -2143,6 +3184,14 @@ void Interpreter::visit(ArrayNode *node)
         elements.push_back(returnValue);
     }
 
+    if (node->isConstant() && !hadError)
+    {
+        constantValues = make_shared<vector<shared_ptr<Value>>>(std::move(elements));
+        node->setConstantValues(constantValues);
+        returnValue = make_shared<ArrayValue>(constantValues, 0, constantValues->size(), node->getRange());
+        return;
+    }
+
     returnValue = make_shared<ArrayValue>(elements, node->getRange());
 }
 
@@ -2210,12 +3259,17 @@ void Interpreter::visit(ArrayAccessNode *node)
             return;
         }
 
-        auto indexValue = dynamic_pointer_cast<NumberValue>(returnValue);
-        int index = indexValue ? static_cast<int>(indexValue->getValue()) : 0;
-
-        if (index < 0 || index >= static_cast<int>(arrayValue->getElementCount()))
+        auto indexValue = static_pointer_cast<NumberValue>(returnValue);
+        if (!indexValue->isWhole())
         {
-            error("array index out of bounds: " + to_string(index) + " for array of length: " + to_string(arrayValue->getElementCount()), node->getIndex()->getRange());
+            error("array index must be a whole number: " + indexValue->toString(), node->getIndex()->getRange());
+            returnValue = nullptr;
+            return;
+        }
+        int index = static_cast<int>(indexValue->indexInto(arrayValue->getElementCount()));
+        if (index < 0)
+        {
+            error("array index out of bounds: " + indexValue->toString() + " for array of length: " + to_string(arrayValue->getElementCount()), node->getIndex()->getRange());
             returnValue = nullptr;
             return;
         }
@@ -2224,6 +3278,43 @@ void Interpreter::visit(ArrayAccessNode *node)
         return;
     }
 
+    if (returnValue->getType() == Value::Type::typed_array)
+    {
+        auto typedArray = static_pointer_cast<TypedArrayValue>(returnValue);
+
+        node->getIndex()->visit(this);
+        if (!returnValue)
+        {
+            error("array access index evaluated to null", node->getIndex()->getRange());
+            return;
+        }
+
+        if (returnValue->getType() != Value::Type::number)
+        {
+            error("array access index must be a number", node->getIndex()->getRange());
+            returnValue = nullptr;
+            return;
+        }
+
+        auto indexValue = static_pointer_cast<NumberValue>(returnValue);
+        if (!indexValue->isWhole())
+        {
+            error("array index must be a whole number: " + indexValue->toString(), node->getIndex()->getRange());
+            returnValue = nullptr;
+            return;
+        }
+        int64_t index = indexValue->indexInto(typedArray->length());
+        if (index < 0)
+        {
+            error("array index out of bounds: " + indexValue->toString() + " for array of length: " + to_string(typedArray->length()), node->getIndex()->getRange());
+            returnValue = nullptr;
+            return;
+        }
+
+        returnValue = typedArray->getElement(static_cast<size_t>(index), node->getRange());
+        return;
+    }
+
     if (returnValue->getType() == Value::Type::string_)
     {
         auto stringValue = dynamic_pointer_cast<StringValue>(returnValue);
@@ -2248,17 +3339,22 @@ void Interpreter::visit(ArrayAccessNode *node)
             return;
         }
 
-        auto indexValue = dynamic_pointer_cast<NumberValue>(returnValue);
-        int index = indexValue ? static_cast<int>(indexValue->getValue()) : 0;
-
-        if (index < 0 || index >= static_cast<int>(stringValue->length()))
+        auto indexValue = static_pointer_cast<NumberValue>(returnValue);
+        if (!indexValue->isWhole())
+        {
+            error("string index must be a whole number: " + indexValue->toString(), node->getIndex()->getRange());
+            returnValue = nullptr;
+            return;
+        }
+        int64_t index = indexValue->indexInto(stringValue->length());
+        if (index < 0)
         {
-            error("string index out of bounds: " + to_string(index), node->getIndex()->getRange());
+            error("string index out of bounds: " + indexValue->toString(), node->getIndex()->getRange());
             returnValue = nullptr;
             return;
         }
 
-        returnValue = make_shared<StringValue>(stringValue->getCharAt(index));
+        returnValue = make_shared<StringValue>(stringValue->getCharAt(static_cast<int>(index)));
         return;
     }
     else
@@ -2278,27 +3374,32 @@ void Interpreter::visit(MemberAccessNode *node)
     }
 
     auto lhs = returnValue;
+    returnValue = evalMemberAccess(node, lhs, true);
+}
 
-    if (returnValue->getType() != Value::Type::class_)
+shared_ptr<Value> Interpreter::evalMemberAccess(MemberAccessNode *node, const shared_ptr<Value> &lhs, bool bind)
+{
+    if (lhs->getType() != Value::Type::class_)
     {
-        auto member = returnValue->getMember(node->getIdentifier().getValue());
+        auto member = lhs->getMember(node->getIdentifier().getValue());
         if (member && member->getType() == Value::Type::builtin)
         {
+            if (!bind)
+            {
+                return member;
+            }
+
             // if the member is a builtin function, we need to bind it to the left-hand side so it can access the object it belongs to.
             auto builtin = dynamic_pointer_cast<BuiltinFunctionValue>(member);
             if (!builtin)
             {
-                returnValue = nullptr;
-                return;
+                return nullptr;
             }
 
-            returnValue = builtin->bind(lhs);
-            return;
+            return builtin->bind(lhs);
         }
 
-        returnValue = member;
-
-        if (!returnValue)
+        if (!member)
         {
             if (lhs->getType() == Value::Type::object)
             {
@@ -2309,51 +3410,49 @@ void Interpreter::visit(MemberAccessNode *node)
             {
                 errorAtToken(lhs->typeAsString() + " has no member '" + node->getIdentifier().getValue() + "'", node->getIdentifier(), node->getRange());
             }
-            return;
+            return nullptr;
         }
+        return member;
     }
-    else if (returnValue->getType() == Value::Type::class_)
+
+    auto classValue = dynamic_pointer_cast<ClassValue>(lhs);
+    if (!classValue)
     {
-        auto classValue = dynamic_pointer_cast<ClassValue>(lhs);
-        if (!classValue)
-        {
-            returnValue = nullptr;
-            error("left-hand side of member access could not be cast to ClassValue", node->getExpression()->getRange());
-            return;
-        }
+        error("left-hand side of member access could not be cast to ClassValue", node->getExpression()->getRange());
+        return nullptr;
+    }
 
-        shared_ptr<BlockNode> classBody = dynamic_pointer_cast<BlockNode>(classValue->getBody());
-        if (!classBody)
-        {
-            error("class '" + classValue->getName() + "' has no body", node->getRange());
-            returnValue = nullptr;
-            return;
-        }
+    shared_ptr<BlockNode> classBody = dynamic_pointer_cast<BlockNode>(classValue->getBody());
+    if (!classBody)
+    {
+        error("class '" + classValue->getName() + "' has no body", node->getRange());
+        return nullptr;
+    }
 
-        env = make_shared<Environment>(env); // Inherit from current environment to access imports
+    env = make_shared<Environment>(env); // Inherit from current environment to access imports
 
-        try
-        {
-            // we don't want to push extra scope for class body, so we just visit the statements directly
-            if (classBody->getStatements())
-            {
-                classBody->getStatements()->visit(this);
-            }
-        }
-        catch (const ErrorException &e)
+    try
+    {
+        // we don't want to push extra scope for class body, so we just visit the statements directly
+        if (classBody->getStatements())
         {
-            env = env->getParent();
-            throw e;
+            classBody->getStatements()->visit(this);
         }
-
-        // lookup the member in the class environment
-        returnValue = env->lookupLocal(node->getIdentifier().getValue());
+    }
+    catch (const ErrorException &e)
+    {
         env = env->getParent();
-        if (!returnValue)
-        {
-            errorAtToken("class '" + classValue->getName() + "' has no member '" + node->getIdentifier().getValue() + "'", node->getIdentifier(), node->getRange());
-        }
+        throw e;
+    }
+
+    // lookup the member in the class environment
+    auto member = env->lookupLocal(node->getIdentifier().getValue());
+    env = env->getParent();
+    if (!member)
+    {
+        errorAtToken("class '" + classValue->getName() + "' has no member '" + node->getIdentifier().getValue() + "'", node->getIdentifier(), node->getRange());
     }
+    return member;
 }
 
 void Interpreter::visit(ContinueNode *node)
@@ -2391,6 +3490,38 @@ void Interpreter::visit(ClassNode *node)
     returnValue = nullptr; // No return value for class declaration
 }
 
+shared_ptr<Environment> Interpreter::acquireEnvironment(const shared_ptr<Environment> &parent)
+{
+    if (environmentPool.empty())
+    {
+        return make_shared<Environment>(parent);
+    }
+
+    auto environment = std::move(environmentPool.back());
+    environmentPool.pop_back();
+    environment->setParent(parent);
+    return environment;
+}
+
+void Interpreter::releaseEnvironment(shared_ptr<Environment> &environment)
+{
+    // a closure or object still refers to it, it stays where it is and is
+    // cleaned up with the other temporary environments
+    if (environment.use_count() != 1)
+    {
+        tempEnvironments.push_back(environment);
+        return;
+    }
+
+    environment->clear();
+    environment->setParent(nullptr);
+    if (environmentPool.size() < MAX_POOLED_ENVIRONMENTS)
+    {
+        environmentPool.push_back(std::move(environment));
+    }
+    environment = nullptr;
+}
+
 // Performance optimization: Cached variable lookup
 std::shared_ptr<Value> Interpreter::cachedLookup(const std::string& name) const
 {
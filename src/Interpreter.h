@@ -6,6 +6,7 @@
 #include <set>
 #include <functional>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "Visitor.h"
 #include "Environment.h"
@@ -24,8 +25,13 @@ using std::vector;
 
 constexpr const char *INTERPRETER_VERSION = "0.5";
 
+class GeneratorValue;
+
 class Interpreter : public Visitor
 {
+    // generators swap the interpreter's state when they switch to and from their body
+    friend class GeneratorValue;
+
 public:
     Interpreter(bool isInteractive, shared_ptr<Environment> env = nullptr, const vector<string> &args = {});
     ~Interpreter(); // Add destructor for cleanup
@@ -37,6 +43,14 @@ public:
 
     const CallStack &getCallStack() const { return callStack; }
 
+    // Calls a function, builtin or class with already evaluated arguments,
+    // used by builtins that take a callback such as array.map()
+    shared_ptr<Value> call(const shared_ptr<Value> &callee, const vector<shared_ptr<Value>> &args, const Range &range = {});
+
+    // Runs a function body in the current environment, the value of its
+    // return statement or null, used by callers outside callUserFunction
+    shared_ptr<Value> runBody(const shared_ptr<StatementNode> &body);
+
     virtual void visitAllChildren(Node *node) override;
 
 public:
@@ -68,17 +82,64 @@ public:
     virtual void visit(VarDeclNode *node) override;
     virtual void visit(VarExprNode *node) override;
     virtual void visit(WhileNode *node) override;
+    virtual void visit(YieldNode *node) override;
 
 private:
     shared_ptr<Value> evalUnaryExpression(shared_ptr<ExpressionNode> expression, shared_ptr<OpNode> opNode, bool prefix = false);
     shared_ptr<Value> evalVariableUnaryExpression(shared_ptr<VarExprNode> expression, shared_ptr<OpNode> opNode, bool prefix = false);
     shared_ptr<Value> evalIncrementDecrement(shared_ptr<ExpressionNode> expression, shared_ptr<OpNode> opNode, bool prefix = false);
 
+    // The member a member access names on lhs, already evaluated. Builtin
+    // methods are bound to lhs unless bind is false, a call then holds lhs
+    // itself for as long as the method runs.
+    shared_ptr<Value> evalMemberAccess(MemberAccessNode *node, const shared_ptr<Value> &lhs, bool bind);
+
+    // The fast paths of binary expressions specialized for two numbers or two
+    // strings, the operands are known to be of that type
+    shared_ptr<Value> numberOperation(int op, const shared_ptr<Value> &leftValue, const shared_ptr<Value> &rightValue);
+    shared_ptr<Value> stringOperation(int op, const shared_ptr<Value> &leftValue, const shared_ptr<Value> &rightValue);
+
+    // ++, --, +=, -= and *= on a local the TypeInferenceVisitor proved only
+    // holds numbers change the number in place when the local's environment
+    // is the only other holder of it. nullptr when it can't, for an integer
+    // step that overflows or a number that is shared, the generic path then
+    // makes a new one.
+    shared_ptr<Value> stepNumericLocal(VarExprNode *variable, int delta, bool prefix);
+    shared_ptr<Value> updateNumericLocal(VarExprNode *variable, int op, const shared_ptr<Value> &operand);
+
     // Call node helper methods
     bool validateFunctionArguments(shared_ptr<FunctionValue> function, const vector<shared_ptr<Value>> &args, const Range &nodeRange, const string &functionType = "function");
     shared_ptr<Value> callUserFunction(shared_ptr<FunctionValue> function, const vector<shared_ptr<Value>> &args, const Range &nodeRange);
+
+    // Calls a builtin that is a NativeFunction with the call's arguments in
+    // an array on this stack, false if it isn't one or the call has more
+    // arguments than the array holds
+    bool callNative(const BuiltinFunctionValue &builtin, CallNode *node);
+
+    // the scope a call of function runs in, its parameters bound to args
+    shared_ptr<Environment> callScope(const shared_ptr<FunctionValue> &function, const vector<shared_ptr<Value>> &args, const shared_ptr<Environment> &callerEnv);
+
+    // the function value for a declaration, a flat closure when the
+    // FreeVariableVisitor found what it captures
+    shared_ptr<FunctionValue> makeFunction(FuncDeclNode *node, const Range &range);
     shared_ptr<Value> callClassConstructor(shared_ptr<ClassValue> classValue, const vector<shared_ptr<Value>> &args, const Range &nodeRange);
 
+    // Hands a while or for loop to its machine code once it is hot, true if
+    // that ran the loop to its end. compiledCode is cleared when the rest of
+    // this run of the loop has to stay in the interpreter.
+    bool runCompiledLoop(Jit::LoopState &state, StatementNode *condition, StatementNode *body, ExpressionNode *increment, bool &compiledCode);
+
+    // Runs a for loop the LoopAnalysisVisitor found to be counted, from its
+    // first condition check, with the loop variable declared in forEnv.
+    // Returns false when the loop variable or its bound turn out not to be
+    // what the loop can count with, the generic loop then carries on from
+    // the next condition check.
+    bool runCountedLoop(ForStatementNode *node, const shared_ptr<Environment> &forEnv);
+
+    // Runs the body of an array-like for-each loop once with the loop variable
+    // bound to element, returns false if the body breaks out of the loop
+    bool forEachIteration(ForEachNode *node, const shared_ptr<Environment> &originalEnv, const shared_ptr<Value> &element);
+
     shared_ptr<Value> declare(const string &name, const string &value, bool constant = false);
     shared_ptr<Value> declare(const string &name, const char *value, bool constant = false);
     shared_ptr<Value> declare(const string &name, const bool &value, bool constant = false);
@@ -102,13 +163,35 @@ private:
     vector<string> args;         // command line arguments passed to the interpreter
     string currentFunctionName;
 
-    // Recursion depth tracking to prevent stack overflow
-    int recursionDepth;
-    static const int MAX_RECURSION_DEPTH = 1000;
+    // The user function whose body is running, flat closures made in it
+    // capture from its scopes
+    FunctionValue *currentFunction;
+
+    // A return statement ran, the statements, blocks and loops around it
+    // stop until the call it returns from picks up pendingReturn
+    bool returning;
+    shared_ptr<Value> pendingReturn;
+
+    // Tail calls: in a user function body tailCalls is set, a call that is
+    // the whole expression of a return leaves its callee and arguments here
+    // and the calling callUserFunction runs it in place of the finished call.
+    // For obj.method() tailReceiver holds obj until the method has run.
+    bool tailCalls;
+    bool tailPosition;
+    shared_ptr<FunctionValue> tailFunction;
+    vector<shared_ptr<Value>> tailArgs;
+    shared_ptr<Value> tailReceiver;
+    Range tailRange;
 
     // Track nesting level for interactive mode printing
     int nestingLevel;
 
+    // The generator whose body is running, yield hands its value to it
+    GeneratorValue *activeGenerator;
+
+    // Generators that are alive, paused ones are closed before the interpreter goes away
+    std::unordered_set<GeneratorValue *> generators;
+
     // Variable lookup cache for performance optimization
     mutable std::unordered_map<std::string, std::pair<std::shared_ptr<Environment>, std::shared_ptr<Value>>> varCache;
     mutable size_t cacheVersion = 0;  // Invalidate cache when environment changes
@@ -120,12 +203,27 @@ private:
     std::shared_ptr<Value> cachedZero;
     std::shared_ptr<Value> cachedOne;
 
+    // the builtin len, counted loops read the length of an array themselves
+    // when their bound calls it
+    std::shared_ptr<Value> lenFunction;
+
     // Track temporary environments for cleanup during chained calls
     std::vector<std::shared_ptr<Environment>> tempEnvironments;
 
     // Call stack for debugging and error reporting
     CallStack callStack;
 
+    // Environments of finished calls, blocks and loop iterations that nothing
+    // kept, handed out again so most scopes don't allocate
+    static const size_t MAX_POOLED_ENVIRONMENTS = 64;
+    std::vector<std::shared_ptr<Environment>> environmentPool;
+
+    shared_ptr<Environment> acquireEnvironment(const shared_ptr<Environment> &parent);
+
+    // done with a scope: back to the pool, or kept for later cleanup when
+    // something still refers to it
+    void releaseEnvironment(shared_ptr<Environment> &environment);
+
     // Helper to clean up any temporary environments
     void cleanupTempEnvironments();
     void finalCleanup();
@@ -0,0 +1,251 @@
+#include <vector>
+
+#include "IteratorValue.h"
+#include "Values.h"
+#include "Error.h"
+#include "Environment.h"
+#include "Utils.h"
+
+using std::shared_ptr;
+using std::vector;
+using std::make_shared;
+using std::string;
+using std::static_pointer_cast;
+
+#define error(msg, range) \
+    rangeError(msg, range, __FILE__, __LINE__)
+
+#define errorAt(msg, location, range) \
+    locationRangeError(msg, location, range, __FILE__, __LINE__)
+
+//***********************************************
+// IteratorValue
+//***********************************************
+
+IteratorValue::IteratorValue(const Range &range):
+    Value(Type::iterator, range)
+{
+}
+
+shared_ptr<Value> IteratorValue::getMember(const string &name) const
+{
+    // builtins are registered on first use, like strings and arrays
+    if (members.empty())
+    {
+        const_cast<IteratorValue *>(this)->registerBuiltins();
+    }
+    return Value::getMember(name);
+}
+
+void IteratorValue::registerBuiltins()
+{
+    // done() -> true once there are no more values
+    addMember("done", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("done() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            return make_shared<BooleanValue>(done(interpreter), range);
+        },
+        getRange()
+    ), true);
+
+    // next() -> the next value, or null once done
+    addMember("next", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("next() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            if (done(interpreter))
+            {
+                return make_shared<NullValue>(range);
+            }
+            return next(interpreter, range);
+        },
+        getRange()
+    ), true);
+
+    // toArray() -> array of the remaining values
+    addMember("toArray", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("toArray() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+
+            vector<shared_ptr<Value>> elements;
+            while (!done(interpreter))
+            {
+                auto value = next(interpreter, range);
+                if (!value)
+                {
+                    return nullptr;
+                }
+                elements.push_back(value);
+            }
+            return make_shared<ArrayValue>(elements, range);
+        },
+        getRange()
+    ), true);
+}
+
+string IteratorValue::toString() const
+{
+    return "<iterator>";
+}
+
+bool IteratorValue::toBoolean() const
+{
+    return true;
+}
+
+string IteratorValue::typeAsString() const
+{
+    return "iterator";
+}
+
+shared_ptr<Value> IteratorValue::eq(const shared_ptr<NullValue> &other) const
+{
+    return make_shared<BooleanValue>(false, Range(getRange().getStart(), other->getRange().getEnd()));
+}
+
+shared_ptr<Value> IteratorValue::ne(const shared_ptr<NullValue> &other) const
+{
+    return make_shared<BooleanValue>(true, Range(getRange().getStart(), other->getRange().getEnd()));
+}
+
+//***********************************************
+// RangeIterator
+//***********************************************
+
+RangeIterator::RangeIterator(double start, double end, double step, const Range &range):
+    IteratorValue(range),
+    current(start),
+    end(end),
+    step(step)
+{
+}
+
+bool RangeIterator::done(Interpreter &interpreter)
+{
+    UNUSED(interpreter);
+    return finished();
+}
+
+shared_ptr<Value> RangeIterator::next(Interpreter &interpreter, const Range &range)
+{
+    UNUSED(interpreter);
+    return make_shared<NumberValue>(advance(), range);
+}
+
+//***********************************************
+// SplitIterator
+//***********************************************
+
+SplitIterator::SplitIterator(const shared_ptr<StringValue> &source, const string &delimiter, const Range &range):
+    IteratorValue(range),
+    source(source),
+    delimiter(delimiter),
+    position(0),
+    finished(false)
+{
+}
+
+bool SplitIterator::done(Interpreter &interpreter)
+{
+    UNUSED(interpreter);
+    return finished;
+}
+
+shared_ptr<Value> SplitIterator::next(Interpreter &interpreter, const Range &range)
+{
+    UNUSED(interpreter);
+
+    // same parts as split(), one at a time, sharing the source's buffer
+    size_t found = source->view().find(delimiter, position);
+    if (found == string::npos)
+    {
+        finished = true;
+        return source->substring(position, source->length() - position, range);
+    }
+
+    auto part = source->substring(position, found - position, range);
+    position = found + delimiter.length();
+    return part;
+}
+
+//***********************************************
+// LineIterator
+//***********************************************
+
+LineIterator::LineIterator(const string &path, const Range &range):
+    IteratorValue(range),
+    file(path),
+    hasLine(false)
+{
+    readAhead();
+}
+
+void LineIterator::readAhead()
+{
+    hasLine = static_cast<bool>(std::getline(file, line));
+    if (hasLine && !line.empty() && line.back() == '\r')
+    {
+        line.pop_back();
+    }
+}
+
+bool LineIterator::done(Interpreter &interpreter)
+{
+    UNUSED(interpreter);
+    return !hasLine;
+}
+
+shared_ptr<Value> LineIterator::next(Interpreter &interpreter, const Range &range)
+{
+    UNUSED(interpreter);
+    auto value = make_shared<StringValue>(line, range);
+    readAhead();
+    return value;
+}
+
+//***********************************************
+// DirectoryIterator
+//***********************************************
+
+DirectoryIterator::DirectoryIterator(const string &path, const Range &range):
+    IteratorValue(range),
+    failed(false)
+{
+    std::error_code code;
+    entries = std::filesystem::directory_iterator(path, code);
+    failed = static_cast<bool>(code);
+}
+
+bool DirectoryIterator::done(Interpreter &interpreter)
+{
+    UNUSED(interpreter);
+    return failed || entries == std::filesystem::directory_iterator();
+}
+
+shared_ptr<Value> DirectoryIterator::next(Interpreter &interpreter, const Range &range)
+{
+    UNUSED(interpreter);
+    auto value = make_shared<StringValue>(entries->path().filename().string(), range);
+
+    std::error_code code;
+    entries.increment(code);
+    failed = static_cast<bool>(code);
+    return value;
+}
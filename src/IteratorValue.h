@@ -0,0 +1,116 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+
+#include "Value.h"
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+class Interpreter;
+class NumberValue;
+
+// A lazy sequence of values. Scripts use it through next() and done(), and
+// foreach drives it directly. Both take the interpreter since producing the
+// next value may mean running script code.
+class IteratorValue : public Value
+{
+public:
+    IteratorValue(const Range &range = {});
+
+    void registerBuiltins();
+
+    // true once there are no more values, must be checked before next()
+    virtual bool done(Interpreter &interpreter) = 0;
+
+    // the next value, nullptr after reporting an error
+    virtual shared_ptr<Value> next(Interpreter &interpreter, const Range &range = {}) = 0;
+
+    virtual shared_ptr<Value> getMember(const string &name) const override;
+
+    string toString() const override;
+    bool toBoolean() const override;
+
+    virtual string typeAsString() const override;
+
+public:
+    virtual shared_ptr<Value> eq(const shared_ptr<NullValue> &other) const override;
+    virtual shared_ptr<Value> ne(const shared_ptr<NullValue> &other) const override;
+};
+
+// range(start, end, step), the numbers from start up to but not including end
+class RangeIterator : public IteratorValue
+{
+public:
+    RangeIterator(double start, double end, double step, const Range &range = {});
+
+    virtual bool done(Interpreter &interpreter) override;
+    virtual shared_ptr<Value> next(Interpreter &interpreter, const Range &range = {}) override;
+
+    // advances without creating a value, foreach uses this to reuse one
+    // NumberValue for the loop variable when the body doesn't keep it
+    inline double advance() { double value = current; current += step; return value; }
+    inline bool finished() const { return step > 0 ? current >= end : current <= end; }
+
+private:
+    double current;
+    double end;
+    double step;
+};
+
+// string.splitIter(delimiter), the parts of a string between delimiters
+class SplitIterator : public IteratorValue
+{
+public:
+    SplitIterator(const shared_ptr<StringValue> &source, const string &delimiter, const Range &range = {});
+
+    virtual bool done(Interpreter &interpreter) override;
+    virtual shared_ptr<Value> next(Interpreter &interpreter, const Range &range = {}) override;
+
+private:
+    shared_ptr<StringValue> source;
+    string delimiter;
+    size_t position;
+    bool finished;
+};
+
+// lines(path), the lines of a file without their line breaks, read as needed
+class LineIterator : public IteratorValue
+{
+public:
+    LineIterator(const string &path, const Range &range = {});
+
+    inline bool isOpen() const { return file.is_open(); }
+
+    virtual bool done(Interpreter &interpreter) override;
+    virtual shared_ptr<Value> next(Interpreter &interpreter, const Range &range = {}) override;
+
+private:
+    // reads the line the next call to next() returns
+    void readAhead();
+
+private:
+    std::ifstream file;
+    string line;
+    bool hasLine;
+};
+
+// listdirIter(path), the names of the entries of a directory, read as needed
+class DirectoryIterator : public IteratorValue
+{
+public:
+    DirectoryIterator(const string &path, const Range &range = {});
+
+    inline bool isOpen() const { return !failed; }
+
+    virtual bool done(Interpreter &interpreter) override;
+    virtual shared_ptr<Value> next(Interpreter &interpreter, const Range &range = {}) override;
+
+private:
+    std::filesystem::directory_iterator entries;
+    bool failed;
+};
@@ -0,0 +1,630 @@
+#include <cstring>
+#include <map>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "Jit.h"
+#include "Nodes.h"
+#include "Values.h"
+#include "Environment.h"
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+namespace Jit
+{
+    size_t threshold = 1000;
+
+#if defined(__x86_64__) && defined(__linux__)
+
+    // Emits the machine code of one loop, a function taking the loop's
+    // variables in rdi and room for a copy of them in rsi. Expressions leave
+    // their value in rax, using rcx and rdx as scratch and the native stack
+    // for the left operand of a binary operator.
+    class Compiler
+    {
+    public:
+        vector<uint8_t> code;
+        vector<string> names;
+        vector<bool> assigned;
+
+        // the assigned variables of an earlier pass, copied at the start of
+        // every iteration
+        vector<bool> snapshot;
+
+        bool loop(StatementNode *condition, StatementNode *body, ExpressionNode *increment)
+        {
+            // a bail can come from the middle of an expression with operands
+            // still pushed, r8 remembers where the stack was
+            emit({0x49, 0x89, 0xE0}); // mov r8, rsp
+
+            size_t top = code.size();
+            for (size_t i = 0; i < snapshot.size(); ++i)
+            {
+                if (snapshot[i])
+                {
+                    load(0x87, i);  // mov rax, [rdi + slot]
+                    store(0x86, i); // mov [rsi + slot], rax
+                }
+            }
+
+            vector<size_t> exits;
+            if (condition)
+            {
+                auto expression = dynamic_cast<ExpressionNode *>(condition);
+                if (!expression || this->expression(expression) == Kind::none)
+                {
+                    return false;
+                }
+                emit({0x48, 0x85, 0xC0}); // test rax, rax
+                exits.push_back(jump(0x84)); // je done
+            }
+
+            if (body && !statement(body))
+            {
+                return false;
+            }
+
+            for (size_t at : continues)
+            {
+                patch(at, code.size());
+            }
+            if (increment && !statement(increment))
+            {
+                return false;
+            }
+            patch(jump(0), top); // jmp top
+
+            // done: the loop ended by its condition or a break
+            for (size_t at : exits)
+            {
+                patch(at, code.size());
+            }
+            for (size_t at : breaks)
+            {
+                patch(at, code.size());
+            }
+            emit({0x31, 0xC0}); // xor eax, eax
+            emit({0xC3});       // ret
+
+            // bail: put the variables back the way the iteration found them
+            for (size_t at : bails)
+            {
+                patch(at, code.size());
+            }
+            emit({0x4C, 0x89, 0xC4}); // mov rsp, r8
+            for (size_t i = 0; i < snapshot.size(); ++i)
+            {
+                if (snapshot[i])
+                {
+                    load(0x86, i);  // mov rax, [rsi + slot]
+                    store(0x87, i); // mov [rdi + slot], rax
+                }
+            }
+            emit({0xB8, 0x01, 0x00, 0x00, 0x00}); // mov eax, 1
+            emit({0xC3});                         // ret
+            return true;
+        }
+
+    private:
+        enum class Kind
+        {
+            none,    // not something the compiler handles
+            integer,
+            boolean  // 0 or 1, only usable as a condition
+        };
+
+        vector<size_t> bails;
+        vector<size_t> breaks;
+        vector<size_t> continues;
+
+        void emit(std::initializer_list<uint8_t> bytes)
+        {
+            code.insert(code.end(), bytes);
+        }
+
+        void emit32(uint32_t value)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                code.push_back(static_cast<uint8_t>(value >> (8 * i)));
+            }
+        }
+
+        // mov between rax and [rdi/rsi + slot], modrm picks the base register
+        void load(uint8_t modrm, size_t slot)
+        {
+            emit({0x48, 0x8B, modrm});
+            emit32(static_cast<uint32_t>(slot * 8));
+        }
+
+        void store(uint8_t modrm, size_t slot)
+        {
+            emit({0x48, 0x89, modrm});
+            emit32(static_cast<uint32_t>(slot * 8));
+        }
+
+        // a jump with a 32 bit offset to fill in later, condition is the
+        // second byte of a 0x0F jcc or 0 for jmp
+        size_t jump(uint8_t condition)
+        {
+            if (condition)
+            {
+                emit({0x0F, condition});
+            }
+            else
+            {
+                emit({0xE9});
+            }
+            emit32(0);
+            return code.size() - 4;
+        }
+
+        void patch(size_t at, size_t target)
+        {
+            int32_t offset = static_cast<int32_t>(static_cast<int64_t>(target) - static_cast<int64_t>(at + 4));
+            std::memcpy(&code[at], &offset, 4);
+        }
+
+        void bailIf(uint8_t condition)
+        {
+            bails.push_back(jump(condition));
+        }
+
+        size_t slot(const string &name, bool assigns)
+        {
+            for (size_t i = 0; i < names.size(); ++i)
+            {
+                if (names[i] == name)
+                {
+                    assigned[i] = assigned[i] || assigns;
+                    return i;
+                }
+            }
+            names.push_back(name);
+            assigned.push_back(assigns);
+            return names.size() - 1;
+        }
+
+        Kind expression(ExpressionNode *node)
+        {
+            if (auto number = dynamic_cast<NumberNode *>(node))
+            {
+                if (!number->isInteger())
+                {
+                    return Kind::none;
+                }
+                emit({0x48, 0xB8}); // mov rax, imm64
+                uint64_t value = static_cast<uint64_t>(number->getIntValue());
+                emit32(static_cast<uint32_t>(value));
+                emit32(static_cast<uint32_t>(value >> 32));
+                return Kind::integer;
+            }
+
+            if (auto variable = dynamic_cast<VarExprNode *>(node))
+            {
+                load(0x87, slot(variable->getName(), false));
+                return Kind::integer;
+            }
+
+            if (auto unary = dynamic_cast<UnaryExprNode *>(node))
+            {
+                int op = unary->getOperator()->getType();
+                if (!unary->isPrefix() || (op != '-' && op != '!' && op != '~'))
+                {
+                    return Kind::none;
+                }
+
+                Kind operand = expression(unary->getExpression().get());
+                if (operand == Kind::none || (op != '!' && operand != Kind::integer))
+                {
+                    return Kind::none;
+                }
+
+                switch (op)
+                {
+                case '-':
+                    emit({0x48, 0xF7, 0xD8}); // neg rax
+                    bailIf(0x80);             // jo bail
+                    return Kind::integer;
+                case '~':
+                    emit({0x48, 0xF7, 0xD0}); // not rax
+                    return Kind::integer;
+                default:
+                    emit({0x48, 0x85, 0xC0}); // test rax, rax
+                    emit({0x0F, 0x94, 0xC0}); // sete al
+                    emit({0x0F, 0xB6, 0xC0}); // movzx eax, al
+                    return Kind::boolean;
+                }
+            }
+
+            auto binary = dynamic_cast<BinaryExprNode *>(node);
+            if (!binary)
+            {
+                return Kind::none;
+            }
+
+            int op = binary->getOperator()->getType();
+            if (op == Token::AND || op == Token::OR)
+            {
+                return logical(binary, op == Token::AND);
+            }
+
+            if (expression(binary->getLeft().get()) != Kind::integer)
+            {
+                return Kind::none;
+            }
+            emit({0x50}); // push rax
+            if (expression(binary->getRight().get()) != Kind::integer)
+            {
+                return Kind::none;
+            }
+            emit({0x48, 0x89, 0xC1}); // mov rcx, rax
+            emit({0x58});             // pop rax
+
+            switch (op)
+            {
+            case '+':
+                emit({0x48, 0x01, 0xC8}); // add rax, rcx
+                bailIf(0x80);
+                return Kind::integer;
+            case '-':
+                emit({0x48, 0x29, 0xC8}); // sub rax, rcx
+                bailIf(0x80);
+                return Kind::integer;
+            case '*':
+                emit({0x48, 0x0F, 0xAF, 0xC1}); // imul rax, rcx
+                bailIf(0x80);
+                return Kind::integer;
+            case '/':
+                return divide(false);
+            case '%':
+                return divide(true);
+            case '&':
+                emit({0x48, 0x21, 0xC8}); // and rax, rcx
+                return Kind::integer;
+            case '|':
+                emit({0x48, 0x09, 0xC8}); // or rax, rcx
+                return Kind::integer;
+            case '^':
+                emit({0x48, 0x31, 0xC8}); // xor rax, rcx
+                return Kind::integer;
+            case Token::SHL:
+            case Token::SHR:
+                emit({0x48, 0x83, 0xF9, 0x3F}); // cmp rcx, 63
+                bailIf(0x87);                   // ja bail, negative counts too
+                emit({0x48, 0xD3, static_cast<uint8_t>(op == Token::SHL ? 0xE0 : 0xF8)}); // shl/sar rax, cl
+                return Kind::integer;
+            case '<':
+                return compare(0x9C);
+            case Token::LE:
+                return compare(0x9E);
+            case '>':
+                return compare(0x9F);
+            case Token::GE:
+                return compare(0x9D);
+            case Token::EQ:
+                return compare(0x94);
+            case Token::NE:
+                return compare(0x95);
+            default:
+                return Kind::none;
+            }
+        }
+
+        Kind compare(uint8_t setcc)
+        {
+            emit({0x48, 0x39, 0xC8});       // cmp rax, rcx
+            emit({0x0F, setcc, 0xC0});      // setcc al
+            emit({0x0F, 0xB6, 0xC0});       // movzx eax, al
+            return Kind::boolean;
+        }
+
+        // integers divide to an integer only when the division is exact,
+        // anything else is left to the interpreter
+        Kind divide(bool remainder)
+        {
+            emit({0x48, 0x85, 0xC9}); // test rcx, rcx
+            bailIf(0x84);             // je bail, division by zero
+
+            // x / -1 and x % -1 without idiv, which traps for INT64_MIN
+            emit({0x48, 0x83, 0xF9, 0xFF}); // cmp rcx, -1
+            size_t notMinusOne = jump(0x85); // jne divide
+            if (remainder)
+            {
+                emit({0x31, 0xC0}); // xor eax, eax
+            }
+            else
+            {
+                emit({0x48, 0xF7, 0xD8}); // neg rax
+                bailIf(0x80);
+            }
+            size_t done = jump(0);
+
+            patch(notMinusOne, code.size());
+            emit({0x48, 0x99});       // cqo
+            emit({0x48, 0xF7, 0xF9}); // idiv rcx
+            if (remainder)
+            {
+                emit({0x48, 0x89, 0xD0}); // mov rax, rdx
+            }
+            else
+            {
+                emit({0x48, 0x85, 0xD2}); // test rdx, rdx
+                bailIf(0x85);             // jne bail, not exact
+            }
+            patch(done, code.size());
+            return Kind::integer;
+        }
+
+        // && and || of two booleans, both short circuit. The interpreter
+        // reports an error for an integer operand, so those aren't compiled.
+        Kind logical(BinaryExprNode *node, bool isAnd)
+        {
+            uint8_t skip = isAnd ? 0x84 : 0x85; // je or jne to the short cut
+            if (expression(node->getLeft().get()) != Kind::boolean)
+            {
+                return Kind::none;
+            }
+            emit({0x48, 0x85, 0xC0}); // test rax, rax
+            size_t first = jump(skip);
+            if (expression(node->getRight().get()) != Kind::boolean)
+            {
+                return Kind::none;
+            }
+            emit({0x48, 0x85, 0xC0});
+            size_t second = jump(skip);
+
+            emit({0xB8, static_cast<uint8_t>(isAnd ? 1 : 0), 0x00, 0x00, 0x00}); // mov eax, 1 or 0
+            size_t done = jump(0);
+            patch(first, code.size());
+            patch(second, code.size());
+            emit({0xB8, static_cast<uint8_t>(isAnd ? 0 : 1), 0x00, 0x00, 0x00});
+            patch(done, code.size());
+            return Kind::boolean;
+        }
+
+        bool statement(StatementNode *node)
+        {
+            if (auto block = dynamic_cast<BlockNode *>(node))
+            {
+                if (!block->getStatements())
+                {
+                    return true;
+                }
+                for (auto &child : block->getStatements()->getStatements())
+                {
+                    if (child && !statement(child.get()))
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            if (auto branch = dynamic_cast<IfStatementNode *>(node))
+            {
+                if (expression(branch->getCondition().get()) == Kind::none)
+                {
+                    return false;
+                }
+                emit({0x48, 0x85, 0xC0}); // test rax, rax
+                size_t otherwise = jump(0x84);
+                if (!statement(branch->getThenBranch().get()))
+                {
+                    return false;
+                }
+                if (!branch->getElseBranch())
+                {
+                    patch(otherwise, code.size());
+                    return true;
+                }
+                size_t done = jump(0);
+                patch(otherwise, code.size());
+                if (!statement(branch->getElseBranch().get()))
+                {
+                    return false;
+                }
+                patch(done, code.size());
+                return true;
+            }
+
+            if (dynamic_cast<BreakNode *>(node))
+            {
+                breaks.push_back(jump(0));
+                return true;
+            }
+
+            if (dynamic_cast<ContinueNode *>(node))
+            {
+                continues.push_back(jump(0));
+                return true;
+            }
+
+            if (auto unary = dynamic_cast<UnaryExprNode *>(node))
+            {
+                int op = unary->getOperator()->getType();
+                auto variable = dynamic_cast<VarExprNode *>(unary->getExpression().get());
+                if ((op != Token::INC && op != Token::DEC) || !variable)
+                {
+                    return false;
+                }
+                size_t index = slot(variable->getName(), true);
+                load(0x87, index);
+                emit({0x48, 0x83, static_cast<uint8_t>(op == Token::INC ? 0xC0 : 0xE8), 0x01}); // add/sub rax, 1
+                bailIf(0x80);
+                store(0x87, index);
+                return true;
+            }
+
+            auto assign = dynamic_cast<AssignNode *>(node);
+            auto variable = assign ? dynamic_cast<VarExprNode *>(assign->getAsignee().get()) : nullptr;
+            if (!variable)
+            {
+                return false;
+            }
+
+            int op = assign->getOp();
+            static const std::map<int, int> compound = {
+                {Token::PLUS_EQUAL, '+'},
+                {Token::MINUS_EQUAL, '-'},
+                {Token::MUL_EQUAL, '*'},
+                {Token::DIV_EQUAL, '/'},
+                {Token::MOD_EQUAL, '%'},
+            };
+            if (op != '=' && !compound.count(op))
+            {
+                return false;
+            }
+
+            if (op != '=')
+            {
+                load(0x87, slot(variable->getName(), false));
+                emit({0x50}); // push rax
+            }
+            if (expression(assign->getExpr().get()) != Kind::integer)
+            {
+                return false;
+            }
+            if (op != '=')
+            {
+                emit({0x48, 0x89, 0xC1}); // mov rcx, rax
+                emit({0x58});             // pop rax
+                switch (compound.at(op))
+                {
+                case '+':
+                    emit({0x48, 0x01, 0xC8});
+                    bailIf(0x80);
+                    break;
+                case '-':
+                    emit({0x48, 0x29, 0xC8});
+                    bailIf(0x80);
+                    break;
+                case '*':
+                    emit({0x48, 0x0F, 0xAF, 0xC1});
+                    bailIf(0x80);
+                    break;
+                default:
+                    divide(compound.at(op) == '%');
+                    break;
+                }
+            }
+            store(0x87, slot(variable->getName(), true));
+            return true;
+        }
+    };
+
+    shared_ptr<Loop> compile(StatementNode *condition, StatementNode *body, ExpressionNode *increment)
+    {
+        // the first pass finds the variables, the second copies the assigned
+        // ones when an iteration starts
+        Compiler first;
+        if (!first.loop(condition, body, increment))
+        {
+            return nullptr;
+        }
+
+        Compiler second;
+        second.snapshot = first.assigned;
+        second.loop(condition, body, increment);
+
+        auto loop = make_shared<Loop>(second.names, second.assigned, second.code);
+        return loop->isValid() ? loop : nullptr;
+    }
+
+    Loop::Loop(vector<string> names, vector<bool> assigned, const vector<uint8_t> &machineCode):
+        names(std::move(names)),
+        assigned(std::move(assigned)),
+        code(nullptr),
+        size(0)
+    {
+        size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t length = (machineCode.size() + page - 1) / page * page;
+        void *memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+        {
+            return;
+        }
+
+        // written first, then made executable and no longer writable
+        std::memcpy(memory, machineCode.data(), machineCode.size());
+        if (mprotect(memory, length, PROT_READ | PROT_EXEC) != 0)
+        {
+            munmap(memory, length);
+            return;
+        }
+        code = memory;
+        size = length;
+    }
+
+    Loop::~Loop()
+    {
+        if (code)
+        {
+            munmap(code, size);
+        }
+    }
+
+    Loop::Result Loop::run(const shared_ptr<Environment> &env) const
+    {
+        vector<int64_t> slots(names.size());
+        vector<int64_t> shadow(names.size());
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            auto value = env->lookup(names[i]);
+            if (!value || value->getType() != Value::Type::number || !static_cast<NumberValue &>(*value).isInt())
+            {
+                return Result::guardFailed;
+            }
+            if (assigned[i])
+            {
+                auto owner = env->resolve(names[i]);
+                if (!owner || owner->hasConstant(names[i]))
+                {
+                    return Result::guardFailed;
+                }
+            }
+            slots[i] = static_cast<NumberValue &>(*value).getInt();
+        }
+
+        auto entry = reinterpret_cast<int (*)(int64_t *, int64_t *)>(code);
+        int status = entry(slots.data(), shadow.data());
+
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            if (assigned[i])
+            {
+                env->assign(names[i], make_shared<NumberValue>(slots[i]));
+            }
+        }
+        return status == 0 ? Result::finished : Result::bailed;
+    }
+
+#else
+
+    shared_ptr<Loop> compile(StatementNode *, StatementNode *, ExpressionNode *)
+    {
+        return nullptr;
+    }
+
+    Loop::Loop(vector<string> names, vector<bool> assigned, const vector<uint8_t> &):
+        names(std::move(names)),
+        assigned(std::move(assigned)),
+        code(nullptr),
+        size(0)
+    {
+    }
+
+    Loop::~Loop()
+    {
+    }
+
+    Loop::Result Loop::run(const shared_ptr<Environment> &) const
+    {
+        return Result::guardFailed;
+    }
+
+#endif
+}
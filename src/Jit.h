@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Environment;
+class ExpressionNode;
+class StatementNode;
+
+// Hot loops that only do integer arithmetic on variables declared outside
+// them are compiled to x86-64 machine code. A while or for loop counts the
+// iterations the interpreter runs, once it reaches threshold the loop is
+// compiled, and from then on each time the loop starts an iteration it
+// hands the rest of the loop to the machine code.
+//
+// The machine code works on copies of the loop's variables, it checks on
+// the way in that they all hold integers. When a result would stop being
+// an integer (overflow, an inexact division, a division by zero) or a
+// shift count is out of range, it undoes the iteration it is in and hands
+// the loop back to the interpreter at the start of that iteration, which
+// then produces the double or the error the way it always does.
+namespace Jit
+{
+    using std::size_t;
+
+    // iterations before a loop is compiled, 0 disables compiling, set with
+    // --jit-threshold
+    extern size_t threshold;
+
+    class Loop
+    {
+    public:
+        enum class Result
+        {
+            finished,    // the loop ended, by its condition or a break
+            bailed,      // an iteration needs the interpreter, start it there
+            guardFailed  // a variable isn't an integer, nothing ran
+        };
+
+        Loop(std::vector<std::string> names, std::vector<bool> assigned, const std::vector<uint8_t> &code);
+        ~Loop();
+
+        Loop(const Loop &) = delete;
+        Loop &operator=(const Loop &) = delete;
+
+        // runs the loop with the variables env resolves its names to, the
+        // assigned ones are written back to env when it stops
+        Result run(const std::shared_ptr<Environment> &env) const;
+
+        bool isValid() const { return code != nullptr; }
+
+    private:
+        std::vector<std::string> names;
+        std::vector<bool> assigned;
+        void *code;
+        size_t size;
+    };
+
+    // What the interpreter keeps per loop node
+    struct LoopState
+    {
+        size_t iterations = 0;
+        bool attempted = false;
+        std::shared_ptr<Loop> compiled;
+    };
+
+    // Compiles a loop, condition and increment may be null. nullptr if the
+    // loop uses anything other than integer variables, integer literals,
+    // arithmetic, comparisons, if, break and continue, or if machine code
+    // can't be made on this platform.
+    std::shared_ptr<Loop> compile(StatementNode *condition, StatementNode *body, ExpressionNode *increment);
+}
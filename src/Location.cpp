@@ -105,6 +105,16 @@ void Location::move(int offset)
     pos += offset;
 }
 
+Location Location::at(size_t pos) const
+{
+    return Location(pos, input, filename);
+}
+
+bool Location::sameSource(const Location &other) const
+{
+    return input == other.input && filename == other.filename;
+}
+
 bool Location::operator==(const Location &other) const
 {
     return pos == other.pos;
@@ -27,6 +27,10 @@ public:
 
     void move(int offset);
 
+    // the location at pos in the same source
+    Location at(size_t pos) const;
+    bool sameSource(const Location& other) const;
+
     bool operator==(const Location& other) const;
     bool operator!=(const Location& other) const;
     bool operator<(const Location& other) const;
@@ -0,0 +1,198 @@
+#include "LoopAnalysisVisitor.h"
+#include "Nodes.h"
+#include "Token.h"
+#include "Utils.h"
+
+using std::string;
+
+LoopAnalysisVisitor::LoopAnalysisVisitor():
+    calls(false),
+    findLoops(true)
+{
+}
+
+void LoopAnalysisVisitor::visitAllChildren(Node *node)
+{
+    assigned.clear();
+    calls = false;
+    node->visit(this);
+}
+
+void LoopAnalysisVisitor::visit(ForStatementNode *node)
+{
+    if (findLoops)
+    {
+        analyze(node);
+    }
+    Visitor::visit(node);
+}
+
+void LoopAnalysisVisitor::visit(AssignNode *node)
+{
+    if (auto variable = dynamic_cast<VarExprNode *>(node->getAsignee().get()))
+    {
+        assigned.insert(variable->getName());
+    }
+    Visitor::visit(node);
+}
+
+void LoopAnalysisVisitor::visit(UnaryExprNode *node)
+{
+    int op = node->getOperator()->getType();
+    auto variable = dynamic_cast<VarExprNode *>(node->getExpression().get());
+    if ((op == Token::INC || op == Token::DEC) && variable)
+    {
+        assigned.insert(variable->getName());
+    }
+    Visitor::visit(node);
+}
+
+void LoopAnalysisVisitor::visit(DeleteNode *node)
+{
+    assigned.insert(node->getName());
+}
+
+void LoopAnalysisVisitor::visit(CallNode *node)
+{
+    calls = true;
+    Visitor::visit(node);
+}
+
+void LoopAnalysisVisitor::visit(ForEachNode *node)
+{
+    calls = true;
+    Visitor::visit(node);
+}
+
+void LoopAnalysisVisitor::visit(YieldNode *node)
+{
+    calls = true;
+    Visitor::visit(node);
+}
+
+void LoopAnalysisVisitor::visit(ImportNode *node)
+{
+    UNUSED(node);
+    calls = true;
+}
+
+void LoopAnalysisVisitor::visit(VarDeclNode *node)
+{
+    if (node->getExpr())
+    {
+        node->getExpr()->visit(this);
+    }
+}
+
+void LoopAnalysisVisitor::visit(ReturnStatementNode *node)
+{
+    if (node->getExpression())
+    {
+        node->getExpression()->visit(this);
+    }
+}
+
+void LoopAnalysisVisitor::analyze(ForStatementNode *node)
+{
+    // the optimizer runs this again on loops it may have changed
+    CountedLoop loop;
+    node->setCountedLoop(loop);
+
+    // let i = a, a variable the loop may step
+    auto init = dynamic_cast<VarDeclNode *>(node->getInit().get());
+    if (!init || init->isConst() || !init->getExpr())
+    {
+        return;
+    }
+    const string &name = init->getName();
+
+    // i < b, the bound on the right
+    auto condition = dynamic_cast<BinaryExprNode *>(node->getCondition().get());
+    auto left = condition ? dynamic_cast<VarExprNode *>(condition->getLeft().get()) : nullptr;
+    if (!left || left->getName() != name)
+    {
+        return;
+    }
+    int op = condition->getOperator()->getType();
+
+    // i++, ++i, i--, --i, i += 1 or i -= 1
+    int step = 0;
+    ExpressionNode *increment = node->getIncrement().get();
+    if (auto unary = dynamic_cast<UnaryExprNode *>(increment))
+    {
+        auto variable = dynamic_cast<VarExprNode *>(unary->getExpression().get());
+        int type = unary->getOperator()->getType();
+        if (variable && variable->getName() == name)
+        {
+            step = type == Token::INC ? 1 : type == Token::DEC ? -1 : 0;
+        }
+    }
+    else if (auto assign = dynamic_cast<AssignNode *>(increment))
+    {
+        auto variable = dynamic_cast<VarExprNode *>(assign->getAsignee().get());
+        auto amount = dynamic_cast<NumberNode *>(assign->getExpr().get());
+        if (variable && variable->getName() == name && amount && amount->isInteger() && amount->getIntValue() == 1)
+        {
+            step = assign->getOp() == Token::PLUS_EQUAL ? 1 : assign->getOp() == Token::MINUS_EQUAL ? -1 : 0;
+        }
+    }
+
+    bool upwards = op == '<' || op == Token::LE;
+    bool downwards = op == '>' || op == Token::GE;
+    if (!(upwards && step == 1) && !(downwards && step == -1))
+    {
+        return;
+    }
+
+    // the block makes the body's scope, so the loop doesn't need one per iteration
+    if (node->getBody() && !dynamic_cast<BlockNode *>(node->getBody().get()))
+    {
+        return;
+    }
+
+    // loops nested in the body are found by the visitor that found this one
+    LoopAnalysisVisitor body;
+    body.findLoops = false;
+    if (node->getBody())
+    {
+        body.visitAllChildren(node->getBody().get());
+    }
+    if (body.assigned.count(name))
+    {
+        return;
+    }
+
+    loop.counted = true;
+    loop.variable = name;
+    loop.op = op;
+    loop.step = step;
+    loop.bodyCalls = body.calls;
+
+    ExpressionNode *bound = condition->getRight().get();
+    auto call = dynamic_cast<CallNode *>(bound);
+    auto callee = call ? dynamic_cast<VarExprNode *>(call->getCallee().get()) : nullptr;
+    if (dynamic_cast<NumberNode *>(bound))
+    {
+        loop.bound = CountedLoop::Bound::constant;
+    }
+    else if (auto variable = dynamic_cast<VarExprNode *>(bound))
+    {
+        // a closure the body calls could assign it
+        if (variable->getName() != name && !body.assigned.count(variable->getName()) && !body.calls)
+        {
+            loop.bound = CountedLoop::Bound::constant;
+            loop.boundName = variable->getName();
+        }
+    }
+    else if (callee && callee->getName() == "len" && call->getArgs() && call->getArgs()->getArgCount() == 1)
+    {
+        auto array = dynamic_cast<VarExprNode *>(call->getArgs()->getArg(0).get());
+        if (array && array->getName() != name && !body.assigned.count(array->getName()))
+        {
+            loop.bound = CountedLoop::Bound::arrayLength;
+            loop.boundName = array->getName();
+        }
+    }
+
+    node->setCountedLoop(loop);
+}
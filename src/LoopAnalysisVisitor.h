@@ -0,0 +1,45 @@
+#pragma once
+
+#include <set>
+#include <string>
+
+#include "Visitor.h"
+
+// Finds the for loops the interpreter can run as counted loops (see
+// CountedLoop) and records what it found on their nodes. Runs on every parsed
+// program after the FreeVariableVisitor.
+//
+// A loop body is looked at for the variables it assigns, deletes or steps
+// and for anything that can run code the body doesn't show: calls, imports,
+// for-each loops that may call an iterator's next() and yields that hand
+// control to whoever resumes the generator. Nested functions count as part
+// of the body.
+class LoopAnalysisVisitor : public Visitor
+{
+public:
+    LoopAnalysisVisitor();
+
+    virtual void visitAllChildren(Node *node) override;
+public:
+    virtual void visit(ForStatementNode *node) override;
+    virtual void visit(AssignNode *node) override;
+    virtual void visit(UnaryExprNode *node) override;
+    virtual void visit(DeleteNode *node) override;
+    virtual void visit(CallNode *node) override;
+    virtual void visit(ForEachNode *node) override;
+    virtual void visit(YieldNode *node) override;
+    virtual void visit(ImportNode *node) override;
+    virtual void visit(VarDeclNode *node) override;
+    virtual void visit(ReturnStatementNode *node) override;
+private:
+    void analyze(ForStatementNode *node);
+
+private:
+    // names the nodes visited so far assign, delete or step
+    std::set<std::string> assigned;
+    bool calls;
+
+    // false while looking at a loop's body, only the outermost visitor
+    // records loops
+    bool findLoops;
+};
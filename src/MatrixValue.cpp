@@ -0,0 +1,584 @@
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <cmath>
+
+#include "MatrixValue.h"
+#include "Values.h"
+#include "Error.h"
+#include "Environment.h"
+#include "Utils.h"
+
+using std::shared_ptr;
+using std::vector;
+using std::make_shared;
+using std::string;
+using std::static_pointer_cast;
+
+#define error(msg, range) \
+    rangeError(msg, range, __FILE__, __LINE__)
+
+#define errorAt(msg, location, range) \
+    locationRangeError(msg, location, range, __FILE__, __LINE__)
+
+// edge length of the square tiles used by multiply and transpose, 64 doubles
+// per row keeps a tile of each operand comfortably inside the L1/L2 caches
+static const size_t BLOCK_SIZE = 64;
+
+// products with fewer multiply-adds than this run on the calling thread,
+// spawning threads costs more than it saves for small matrices
+static const size_t PARALLEL_THRESHOLD = 1 << 21;
+
+//***********************************************
+// Kernels
+//***********************************************
+
+// c[rowStart..rowEnd) += a * b, where a is n x m, b is m x p and c is n x p.
+// The loops are tiled so a block of b is reused from cache for every row of
+// the block of a, and the innermost loop walks b and c contiguously.
+static void multiplyRows(const double *a, const double *b, double *c, size_t m, size_t p, size_t rowStart, size_t rowEnd)
+{
+    for (size_t ii = rowStart; ii < rowEnd; ii += BLOCK_SIZE)
+    {
+        size_t iEnd = std::min(ii + BLOCK_SIZE, rowEnd);
+        for (size_t kk = 0; kk < m; kk += BLOCK_SIZE)
+        {
+            size_t kEnd = std::min(kk + BLOCK_SIZE, m);
+            for (size_t jj = 0; jj < p; jj += BLOCK_SIZE)
+            {
+                size_t jEnd = std::min(jj + BLOCK_SIZE, p);
+                for (size_t i = ii; i < iEnd; ++i)
+                {
+                    double *cRow = c + i * p;
+                    for (size_t k = kk; k < kEnd; ++k)
+                    {
+                        double aik = a[i * m + k];
+                        const double *bRow = b + k * p;
+                        for (size_t j = jj; j < jEnd; ++j)
+                        {
+                            cRow[j] += aik * bRow[j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// reads a whole number in [0, limit) from arg, reports an error and returns false otherwise
+static bool readIndex(const shared_ptr<Value> &arg, size_t limit, const string &what, size_t &index, const Range &range)
+{
+    if (arg->getType() != Value::Type::number)
+    {
+        errorAt(what + " must be a number, but got " + arg->typeAsString(), arg->getRange().getStart(), range);
+        return false;
+    }
+
+    double value = static_pointer_cast<NumberValue>(arg)->getValue();
+    if (value < 0 || value != std::trunc(value) || value >= static_cast<double>(limit))
+    {
+        errorAt(what + " " + NumberValue::format(value) + " is out of bounds", arg->getRange().getStart(), range);
+        return false;
+    }
+
+    index = static_cast<size_t>(value);
+    return true;
+}
+
+// applies op to every element of self and either a number or a matrix of the same shape
+template <typename Op>
+static shared_ptr<Value> elementWise(const MatrixValue &self, const string &name, const vector<shared_ptr<Value>> &args, Op op, const Range &range)
+{
+    if (args.size() != 1)
+    {
+        error(name + "() expects exactly 1 argument, but got " + std::to_string(args.size()), range);
+        return nullptr;
+    }
+
+    auto result = make_shared<MatrixValue>(self.rowCount(), self.colCount(), range);
+    const vector<double> &lhs = self.getData();
+    vector<double> &out = result->getData();
+
+    if (args[0]->getType() == Value::Type::number)
+    {
+        double scalar = static_pointer_cast<NumberValue>(args[0])->getValue();
+        for (size_t i = 0; i < out.size(); ++i)
+        {
+            out[i] = op(lhs[i], scalar);
+        }
+        return result;
+    }
+
+    if (args[0]->getType() != Value::Type::matrix)
+    {
+        errorAt(name + "() expects a number or a matrix, but got " + args[0]->typeAsString(), args[0]->getRange().getStart(), range);
+        return nullptr;
+    }
+
+    auto other = static_pointer_cast<MatrixValue>(args[0]);
+    if (other->rowCount() != self.rowCount() || other->colCount() != self.colCount())
+    {
+        errorAt(name + "() expects a " + std::to_string(self.rowCount()) + "x" + std::to_string(self.colCount()) +
+            " matrix, but got " + std::to_string(other->rowCount()) + "x" + std::to_string(other->colCount()), args[0]->getRange().getStart(), range);
+        return nullptr;
+    }
+
+    const vector<double> &rhs = other->getData();
+    for (size_t i = 0; i < out.size(); ++i)
+    {
+        out[i] = op(lhs[i], rhs[i]);
+    }
+    return result;
+}
+
+//***********************************************
+// MatrixValue
+//***********************************************
+
+MatrixValue::MatrixValue(size_t rows, size_t cols, const Range &range):
+    Value(Type::matrix, range),
+    rows(rows),
+    cols(cols),
+    data(rows * cols)
+{
+}
+
+shared_ptr<MatrixValue> MatrixValue::multiply(const MatrixValue &a, const MatrixValue &b, const Range &range)
+{
+    auto result = make_shared<MatrixValue>(a.rows, b.cols, range);
+    const double *aData = a.data.data();
+    const double *bData = b.data.data();
+    double *cData = result->data.data();
+    size_t m = a.cols;
+    size_t p = b.cols;
+
+    size_t work = a.rows * m * p;
+    size_t blocks = (a.rows + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    size_t threadCount = std::min<size_t>(std::thread::hardware_concurrency(), blocks);
+    if (work < PARALLEL_THRESHOLD || threadCount < 2)
+    {
+        multiplyRows(aData, bData, cData, m, p, 0, a.rows);
+        return result;
+    }
+
+    // every thread owns a disjoint band of whole row blocks of the result
+    vector<std::thread> threads;
+    threads.reserve(threadCount);
+    size_t blocksPerThread = (blocks + threadCount - 1) / threadCount;
+    for (size_t t = 0; t < threadCount; ++t)
+    {
+        size_t rowStart = t * blocksPerThread * BLOCK_SIZE;
+        size_t rowEnd = std::min(rowStart + blocksPerThread * BLOCK_SIZE, a.rows);
+        if (rowStart >= rowEnd)
+        {
+            break;
+        }
+        threads.emplace_back(multiplyRows, aData, bData, cData, m, p, rowStart, rowEnd);
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    return result;
+}
+
+shared_ptr<MatrixValue> MatrixValue::transpose(const Range &range) const
+{
+    auto result = make_shared<MatrixValue>(cols, rows, range);
+    vector<double> &out = result->data;
+
+    // tiled so both the reads and the writes stay within a few cache lines
+    for (size_t ii = 0; ii < rows; ii += BLOCK_SIZE)
+    {
+        size_t iEnd = std::min(ii + BLOCK_SIZE, rows);
+        for (size_t jj = 0; jj < cols; jj += BLOCK_SIZE)
+        {
+            size_t jEnd = std::min(jj + BLOCK_SIZE, cols);
+            for (size_t i = ii; i < iEnd; ++i)
+            {
+                for (size_t j = jj; j < jEnd; ++j)
+                {
+                    out[j * rows + i] = data[i * cols + j];
+                }
+            }
+        }
+    }
+    return result;
+}
+
+shared_ptr<Value> MatrixValue::getMember(const string &name) const
+{
+    // builtins are registered on first use, like strings and arrays
+    if (members.empty())
+    {
+        const_cast<MatrixValue *>(this)->registerBuiltins();
+    }
+    return Value::getMember(name);
+}
+
+void MatrixValue::registerBuiltins()
+{
+    // rows() -> number
+    addMember("rows", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("rows() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            return make_shared<NumberValue>(static_cast<double>(rows), range);
+        },
+        getRange()
+    ), true);
+
+    // cols() -> number
+    addMember("cols", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("cols() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            return make_shared<NumberValue>(static_cast<double>(cols), range);
+        },
+        getRange()
+    ), true);
+
+    // get(row, col) -> number
+    addMember("get", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (args.size() != 2)
+            {
+                error("get() expects exactly 2 arguments, but got " + std::to_string(args.size()), range);
+                return nullptr;
+            }
+
+            size_t row, col;
+            if (!readIndex(args[0], rows, "row", row, range) || !readIndex(args[1], cols, "column", col, range))
+            {
+                return nullptr;
+            }
+            return make_shared<NumberValue>(get(row, col), range);
+        },
+        getRange()
+    ), true);
+
+    // set(row, col, value) -> null
+    addMember("set", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (args.size() != 3)
+            {
+                error("set() expects exactly 3 arguments, but got " + std::to_string(args.size()), range);
+                return nullptr;
+            }
+
+            size_t row, col;
+            if (!readIndex(args[0], rows, "row", row, range) || !readIndex(args[1], cols, "column", col, range))
+            {
+                return nullptr;
+            }
+
+            if (args[2]->getType() != Value::Type::number)
+            {
+                errorAt("set() expects a number value, but got " + args[2]->typeAsString(), args[2]->getRange().getStart(), range);
+                return nullptr;
+            }
+
+            set(row, col, static_pointer_cast<NumberValue>(args[2])->getValue());
+            return make_shared<NullValue>(range);
+        },
+        getRange()
+    ), true);
+
+    // row(index) -> Float64Array copy of the row
+    addMember("row", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (args.size() != 1)
+            {
+                error("row() expects exactly 1 argument, but got " + std::to_string(args.size()), range);
+                return nullptr;
+            }
+
+            size_t row;
+            if (!readIndex(args[0], rows, "row", row, range))
+            {
+                return nullptr;
+            }
+
+            auto result = make_shared<TypedArrayValue>(TypedArrayValue::ElementType::float64, cols, range);
+            std::copy(data.begin() + row * cols, data.begin() + (row + 1) * cols, result->getFloats().begin());
+            return result;
+        },
+        getRange()
+    ), true);
+
+    // col(index) -> Float64Array copy of the column
+    addMember("col", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (args.size() != 1)
+            {
+                error("col() expects exactly 1 argument, but got " + std::to_string(args.size()), range);
+                return nullptr;
+            }
+
+            size_t col;
+            if (!readIndex(args[0], cols, "column", col, range))
+            {
+                return nullptr;
+            }
+
+            auto result = make_shared<TypedArrayValue>(TypedArrayValue::ElementType::float64, rows, range);
+            vector<double> &out = result->getFloats();
+            for (size_t i = 0; i < rows; ++i)
+            {
+                out[i] = get(i, col);
+            }
+            return result;
+        },
+        getRange()
+    ), true);
+
+    // slice(rowStart, rowEnd, colStart, colEnd) -> sub matrix, the ends are exclusive
+    addMember("slice", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (args.size() != 4)
+            {
+                error("slice() expects exactly 4 arguments, but got " + std::to_string(args.size()), range);
+                return nullptr;
+            }
+
+            size_t rowStart, rowEnd, colStart, colEnd;
+            if (!readIndex(args[0], rows + 1, "row", rowStart, range) || !readIndex(args[1], rows + 1, "row", rowEnd, range) ||
+                !readIndex(args[2], cols + 1, "column", colStart, range) || !readIndex(args[3], cols + 1, "column", colEnd, range))
+            {
+                return nullptr;
+            }
+
+            if (rowEnd < rowStart || colEnd < colStart)
+            {
+                error("slice() end must not be before start", range);
+                return nullptr;
+            }
+
+            auto result = make_shared<MatrixValue>(rowEnd - rowStart, colEnd - colStart, range);
+            for (size_t i = rowStart; i < rowEnd; ++i)
+            {
+                std::copy(data.begin() + i * cols + colStart, data.begin() + i * cols + colEnd,
+                    result->data.begin() + (i - rowStart) * result->cols);
+            }
+            return result;
+        },
+        getRange()
+    ), true);
+
+    // transpose() -> new matrix
+    addMember("transpose", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("transpose() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            return transpose(range);
+        },
+        getRange()
+    ), true);
+
+    // matmul(other) -> new matrix
+    addMember("matmul", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (args.size() != 1)
+            {
+                error("matmul() expects exactly 1 argument, but got " + std::to_string(args.size()), range);
+                return nullptr;
+            }
+
+            if (args[0]->getType() != Value::Type::matrix)
+            {
+                errorAt("matmul() expects a matrix argument, but got " + args[0]->typeAsString(), args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+
+            auto other = static_pointer_cast<MatrixValue>(args[0]);
+            if (other->rows != cols)
+            {
+                errorAt("matmul() expects a matrix with " + std::to_string(cols) + " rows, but got " + std::to_string(other->rows), args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            return multiply(*this, *other, range);
+        },
+        getRange()
+    ), true);
+
+    // add(other) -> new matrix, other is a number or a matrix of the same shape
+    addMember("add", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            return elementWise(*this, "add", args, [](double a, double b) { return a + b; }, range);
+        },
+        getRange()
+    ), true);
+
+    // subtract(other) -> new matrix, other is a number or a matrix of the same shape
+    addMember("subtract", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            return elementWise(*this, "subtract", args, [](double a, double b) { return a - b; }, range);
+        },
+        getRange()
+    ), true);
+
+    // multiply(other) -> new matrix, element-wise, other is a number or a matrix of the same shape
+    addMember("multiply", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            return elementWise(*this, "multiply", args, [](double a, double b) { return a * b; }, range);
+        },
+        getRange()
+    ), true);
+
+    // scale(factor) -> new matrix
+    addMember("scale", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (args.size() == 1 && args[0]->getType() != Value::Type::number)
+            {
+                errorAt("scale() expects a number argument, but got " + args[0]->typeAsString(), args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            return elementWise(*this, "scale", args, [](double a, double b) { return a * b; }, range);
+        },
+        getRange()
+    ), true);
+
+    // sum() -> number
+    addMember("sum", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("sum() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+
+            double sum = 0;
+            for (double value : data)
+            {
+                sum += value;
+            }
+            return make_shared<NumberValue>(sum, range);
+        },
+        getRange()
+    ), true);
+
+    // toArray() -> array of arrays of numbers
+    addMember("toArray", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("toArray() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+
+            vector<shared_ptr<Value>> result;
+            result.reserve(rows);
+            for (size_t i = 0; i < rows; ++i)
+            {
+                vector<shared_ptr<Value>> row;
+                row.reserve(cols);
+                for (size_t j = 0; j < cols; ++j)
+                {
+                    row.push_back(make_shared<NumberValue>(get(i, j), range));
+                }
+                result.push_back(make_shared<ArrayValue>(row, range));
+            }
+            return make_shared<ArrayValue>(result, range);
+        },
+        getRange()
+    ), true);
+}
+
+string MatrixValue::toString() const
+{
+    string result = "[";
+    for (size_t i = 0; i < rows; ++i)
+    {
+        result += "[";
+        for (size_t j = 0; j < cols; ++j)
+        {
+            result += NumberValue::format(get(i, j));
+            if (j + 1 < cols)
+            {
+                result += ", ";
+            }
+        }
+        result += "]";
+        if (i + 1 < rows)
+        {
+            result += ", ";
+        }
+    }
+    result += "]";
+    return result;
+}
+
+bool MatrixValue::toBoolean() const
+{
+    return !data.empty();
+}
+
+string MatrixValue::typeAsString() const
+{
+    return "Matrix";
+}
+
+shared_ptr<Value> MatrixValue::eq(const shared_ptr<NullValue> &other) const
+{
+    return make_shared<BooleanValue>(false, Range(getRange().getStart(), other->getRange().getEnd()));
+}
+
+shared_ptr<Value> MatrixValue::ne(const shared_ptr<NullValue> &other) const
+{
+    return make_shared<BooleanValue>(true, Range(getRange().getStart(), other->getRange().getEnd()));
+}
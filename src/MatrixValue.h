@@ -0,0 +1,49 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Value.h"
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+// A two dimensional matrix of numbers stored contiguously in row-major order,
+// so rows are cache friendly and no element is boxed in a NumberValue.
+class MatrixValue : public Value
+{
+public:
+    MatrixValue(size_t rows, size_t cols, const Range &range = {});
+
+    void registerBuiltins();
+
+    inline size_t rowCount() const { return rows; }
+    inline size_t colCount() const { return cols; }
+
+    inline double get(size_t row, size_t col) const { return data[row * cols + col]; }
+    inline void set(size_t row, size_t col, double value) { data[row * cols + col] = value; }
+
+    inline vector<double> &getData() { return data; }
+    inline const vector<double> &getData() const { return data; }
+
+    // matrix product, a.colCount() must equal b.rowCount()
+    static shared_ptr<MatrixValue> multiply(const MatrixValue &a, const MatrixValue &b, const Range &range = {});
+    shared_ptr<MatrixValue> transpose(const Range &range = {}) const;
+
+    virtual shared_ptr<Value> getMember(const string &name) const override;
+
+    string toString() const override;
+    bool toBoolean() const override;
+
+    virtual string typeAsString() const override;
+
+public:
+    virtual shared_ptr<Value> eq(const shared_ptr<NullValue> &other) const override;
+    virtual shared_ptr<Value> ne(const shared_ptr<NullValue> &other) const override;
+
+private:
+    size_t rows;
+    size_t cols;
+    vector<double> data;
+};
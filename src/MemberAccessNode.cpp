@@ -28,6 +28,11 @@ shared_ptr<ExpressionNode> MemberAccessNode::getExpression() const
     return expression;
 }
 
+void MemberAccessNode::setExpression(shared_ptr<ExpressionNode> expression)
+{
+    this->expression = expression;
+}
+
 const Token &MemberAccessNode::getIdentifier() const
 {
     return identifier;
@@ -24,6 +24,7 @@ public:
     MemberAccessNode(shared_ptr<ExpressionNode> expression, const Token &identifier);
 
     shared_ptr<ExpressionNode> getExpression() const;
+    void setExpression(shared_ptr<ExpressionNode> expression);
 
     const Token &getIdentifier() const;
 
@@ -43,6 +43,7 @@
 #include "IfStatementNode.h"
 #include "ImportNode.h"
 #include "ReturnStatementNode.h"
+#include "YieldNode.h"
 #include "StatementNode.h"
 #include "StatementsNode.h"
 #include "VarDeclNode.h"
@@ -21,6 +21,16 @@ string NullValue::typeAsString() const
     return "null";
 }
 
+size_t NullValue::hash() const
+{
+    return 0;
+}
+
+bool NullValue::equals(const Value &other) const
+{
+    return other.getType() == Type::null;
+}
+
 shared_ptr<Value> NullValue::add(const shared_ptr<StringValue> &other) const
 {
     if (!other) return nullptr;
@@ -10,6 +10,8 @@ public:
     virtual string toString() const override;
     virtual bool toBoolean() const override;
     virtual string typeAsString() const override;
+    virtual size_t hash() const override;
+    virtual bool equals(const Value &other) const override;
 public:
     virtual shared_ptr<Value> add(const shared_ptr<StringValue> &other) const override;
 
@@ -7,13 +7,58 @@
 // a numeric literal in the abstract syntax tree (AST).
 //***********************************************
 
+#include <charconv>
+#include <cmath>
+
 #include "NumberNode.h"
 
 NumberNode::NumberNode(const Token &token):
     token(token),
-    value(std::stod(token.getValue()))
+    value(0),
+    intValue(0),
+    integer(false)
 {
     setRange(token.getRange());
+
+    // the tokenizer only makes digits with an optional '-' and '.'
+    const string &text = token.getValue();
+    const char *end = text.data() + text.size();
+    if (text.find('.') == string::npos)
+    {
+        auto result = std::from_chars(text.data(), end, intValue);
+        integer = result.ec == std::errc() && result.ptr == end;
+    }
+
+    if (integer)
+    {
+        value = static_cast<double>(intValue);
+    }
+    else if (std::from_chars(text.data(), end, value).ec == std::errc::result_out_of_range)
+    {
+        // more digits than a double holds
+        value = text[0] == '-' ? -HUGE_VAL : HUGE_VAL;
+    }
+}
+
+NumberNode::NumberNode(int64_t value, const Range &range):
+    token(Token::NUMBER, range, std::to_string(value)),
+    value(static_cast<double>(value)),
+    intValue(value),
+    integer(true)
+{
+    setRange(range);
+}
+
+NumberNode::NumberNode(double value, const Range &range):
+    value(value),
+    intValue(0),
+    integer(false)
+{
+    // shortest text that reads back as the same double
+    char text[32];
+    auto result = std::to_chars(text, text + sizeof(text), value);
+    token = Token(Token::NUMBER, range, std::string(text, result.ptr));
+    setRange(range);
 }
 
 const Token &NumberNode::getToken() const
@@ -26,6 +71,16 @@ double NumberNode::getValue() const
     return value;
 }
 
+bool NumberNode::isInteger() const
+{
+    return integer;
+}
+
+int64_t NumberNode::getIntValue() const
+{
+    return intValue;
+}
+
 void NumberNode::visit(Visitor *visitor)
 {
     visitor->visit(this);
@@ -10,6 +10,7 @@
 #pragma once
 
 #include <memory>
+#include <cstdint>
 #include "ExpressionNode.h"
 #include "Visitor.h"
 #include "Token.h"
@@ -21,12 +22,22 @@ class NumberNode : public ExpressionNode
 public:
     NumberNode(const Token &token);
 
+    // a literal made by the optimizer rather than read from the source
+    NumberNode(int64_t value, const Range &range);
+    NumberNode(double value, const Range &range);
+
     const Token &getToken() const;
 
     double getValue() const;
 
+    // true for literals without a decimal point that fit in 64 bits
+    bool isInteger() const;
+    int64_t getIntValue() const;
+
     virtual void visit(Visitor *visitor) override;
 private:
     Token token;
     double value;
+    int64_t intValue;
+    bool integer;
 };
\ No newline at end of file
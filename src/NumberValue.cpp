@@ -1,4 +1,9 @@
 #include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <charconv>
 
 #include "NumberValue.h"
 #include "Values.h"
@@ -25,21 +30,43 @@ constexpr double EPSILON = 1e-15;
     throw ErrorException(msg, range)
 
 NumberValue::NumberValue(int value, const Range &range):
-    Value(Type::number, range), value(value)
+    Value(Type::number, range), value(value), intValue(value), integer(true)
+{
+}
+
+NumberValue::NumberValue(int64_t value, const Range &range):
+    Value(Type::number, range), value(static_cast<double>(value)), intValue(value), integer(true)
 {
-    registerBuiltins();
 }
 
 NumberValue::NumberValue(unsigned long value, const Range &range):
-    Value(Type::number, range), value(static_cast<double>(value))
+    Value(Type::number, range), value(static_cast<double>(value)), intValue(static_cast<int64_t>(value)), integer(value <= static_cast<unsigned long>(INT64_MAX))
 {
-    registerBuiltins();
 }
 
 NumberValue::NumberValue(double value, const Range &range):
-    Value(Type::number, range), value(value)
+    Value(Type::number, range), value(value), intValue(0), integer(false)
 {
-    registerBuiltins();
+}
+
+shared_ptr<NumberValue> NumberValue::fromWhole(double value, const Range &range)
+{
+    // 2^63 itself is the first double past INT64_MAX
+    if (value >= -9223372036854775808.0 && value < 9223372036854775808.0)
+    {
+        return make_shared<NumberValue>(static_cast<int64_t>(value), range);
+    }
+    return make_shared<NumberValue>(value, range);
+}
+
+shared_ptr<Value> NumberValue::getMember(const string &name) const
+{
+    // builtins are registered on first use, like strings and arrays
+    if (members.empty())
+    {
+        const_cast<NumberValue *>(this)->registerBuiltins();
+    }
+    return Value::getMember(name);
 }
 
 void NumberValue::registerBuiltins()
@@ -54,7 +81,11 @@ void NumberValue::registerBuiltins()
                 errorAt("round() does not take any arguments", args[0]->getRange().getStart(), range);
                 return nullptr;
             }
-            return make_shared<NumberValue>(std::round(value), range);
+            if (integer)
+            {
+                return make_shared<NumberValue>(intValue, range);
+            }
+            return fromWhole(std::round(value), range);
         },
         getRange()
     ), true);
@@ -69,6 +100,10 @@ void NumberValue::registerBuiltins()
                 errorAt("abs() does not take any arguments", args[0]->getRange().getStart(), range);
                 return nullptr;
             }
+            if (integer && intValue != INT64_MIN)
+            {
+                return make_shared<NumberValue>(intValue < 0 ? -intValue : intValue, range);
+            }
             return make_shared<NumberValue>(std::abs(value), range);
         }
     ), true);
@@ -83,7 +118,11 @@ void NumberValue::registerBuiltins()
                 errorAt("floor() does not take any arguments", args[0]->getRange().getStart(), range);
                 return nullptr;
             }
-            return make_shared<NumberValue>(std::floor(value), range);
+            if (integer)
+            {
+                return make_shared<NumberValue>(intValue, range);
+            }
+            return fromWhole(std::floor(value), range);
         }
     ), true);
 
@@ -97,24 +136,119 @@ void NumberValue::registerBuiltins()
                 errorAt("ceil() does not take any arguments", args[0]->getRange().getStart(), range);
                 return nullptr;
             }
-            return make_shared<NumberValue>(std::ceil(value), range);
+            if (integer)
+            {
+                return make_shared<NumberValue>(intValue, range);
+            }
+            return fromWhole(std::ceil(value), range);
         }
     ), true);
 }
 
+bool NumberValue::isWhole() const
+{
+    return integer || (std::isfinite(value) && value == std::floor(value));
+}
+
+int64_t NumberValue::indexInto(size_t length) const
+{
+    if (integer)
+    {
+        return intValue >= 0 && static_cast<uint64_t>(intValue) < length ? intValue : -1;
+    }
+
+    // NaN fails both comparisons
+    if (value >= 0 && value < static_cast<double>(length) && value == std::floor(value))
+    {
+        return static_cast<int64_t>(value);
+    }
+    return -1;
+}
+
+shared_ptr<NumberValue> NumberValue::plus(int delta, const Range &range) const
+{
+    int64_t result;
+    if (integer && !__builtin_add_overflow(intValue, static_cast<int64_t>(delta), &result))
+    {
+        return make_shared<NumberValue>(result, range);
+    }
+    return make_shared<NumberValue>(value + delta, range);
+}
+
 string NumberValue::toString() const
+{
+    if (integer)
+    {
+        char buffer[24];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), intValue);
+        return string(buffer, result.ptr);
+    }
+    return format(value);
+}
+
+string NumberValue::format(double value)
 {
     // Round to 15 decimal places to eliminate floating-point precision artifacts
     double rounded = std::round(value * 1e15) / 1e15;
 
-    string str = to_string(rounded);
-    str.erase(str.find_last_not_of('0') + 1, string::npos);
-    str.erase(str.find_last_not_of('.') + 1, string::npos);
-    if (str.empty())
+    // the same digits std::to_string gives (6 decimals), without going through
+    // printf and the locale; DBL_MAX needs 309 digits before the point
+    char buffer[400];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), rounded, std::chars_format::fixed, 6);
+    char *end = result.ptr;
+
+    // inf and nan have no decimals to trim
+    if (std::memchr(buffer, '.', end - buffer))
     {
-        str = "0";
+        while (end[-1] == '0')
+        {
+            end--;
+        }
+        if (end[-1] == '.')
+        {
+            end--;
+        }
     }
-    return str;
+    return string(buffer, end);
+}
+
+shared_ptr<NumberValue> NumberValue::parse(const string &text, const Range &range)
+{
+    // the same numbers std::stod reads: leading spaces and a '+' are skipped
+    // and anything after the number is ignored
+    const char *begin = text.data();
+    const char *end = text.data() + text.size();
+    while (begin != end && std::isspace(static_cast<unsigned char>(*begin)))
+    {
+        begin++;
+    }
+    if (begin != end && *begin == '+' && begin + 1 != end && *(begin + 1) != '-')
+    {
+        begin++;
+    }
+
+    double parsed;
+    auto result = std::from_chars(begin, end, parsed);
+    if (result.ec == std::errc::invalid_argument)
+    {
+        return nullptr;
+    }
+
+    // from_chars has no hex and reports overflow instead of giving inf, strtod
+    // handles both the way stod would
+    bool hex = result.ptr != end && (*result.ptr == 'x' || *result.ptr == 'X');
+    if (hex || result.ec == std::errc::result_out_of_range)
+    {
+        return make_shared<NumberValue>(std::strtod(begin, nullptr), range);
+    }
+
+    int64_t whole;
+    auto integral = std::from_chars(begin, result.ptr, whole);
+    if (integral.ec == std::errc() && integral.ptr == result.ptr)
+    {
+        return make_shared<NumberValue>(whole, range);
+    }
+    return make_shared<NumberValue>(parsed, range);
 }
 
 bool NumberValue::toBoolean() const
@@ -127,9 +261,35 @@ string NumberValue::typeAsString() const
     return "number";
 }
 
+size_t NumberValue::hash() const
+{
+    // 0 and -0 are equal so they must hash the same
+    return std::hash<double>()(value == 0 ? 0.0 : value);
+}
+
+bool NumberValue::equals(const Value &other) const
+{
+    if (other.getType() != Type::number)
+    {
+        return false;
+    }
+    auto &number = static_cast<const NumberValue &>(other);
+    if (integer && number.integer)
+    {
+        return intValue == number.intValue;
+    }
+    double otherValue = number.value;
+    return value == otherValue || (std::isnan(value) && std::isnan(otherValue));
+}
+
 shared_ptr<Value> NumberValue::add(const shared_ptr<NumberValue> &other) const
 {
     if (!other) return nullptr;
+    int64_t result;
+    if (integer && other->integer && !__builtin_add_overflow(intValue, other->intValue, &result))
+    {
+        return make_shared<NumberValue>(result, Range(getRange().getStart(), other->getRange().getEnd()));
+    }
     return make_shared<NumberValue>(value + other->getValue(), Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
@@ -140,11 +300,21 @@ shared_ptr<Value> NumberValue::add(const shared_ptr<StringValue> &other) const
 
 shared_ptr<Value> NumberValue::sub(const shared_ptr<NumberValue> &other) const
 {
+    int64_t result;
+    if (integer && other->integer && !__builtin_sub_overflow(intValue, other->intValue, &result))
+    {
+        return make_shared<NumberValue>(result, Range(getRange().getStart(), other->getRange().getEnd()));
+    }
     return make_shared<NumberValue>(value - other->getValue(), Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
 shared_ptr<Value> NumberValue::mul(const shared_ptr<NumberValue> &other) const
 {
+    int64_t result;
+    if (integer && other->integer && !__builtin_mul_overflow(intValue, other->intValue, &result))
+    {
+        return make_shared<NumberValue>(result, Range(getRange().getStart(), other->getRange().getEnd()));
+    }
     return make_shared<NumberValue>(value * other->getValue(), Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
@@ -155,6 +325,13 @@ shared_ptr<Value> NumberValue::div(const shared_ptr<NumberValue> &other) const
         error("cannot divide by zero", other->getRange());
         return make_shared<NullValue>(Range::getEmpty()); // This won't be reached due to exception
     }
+
+    // only exact quotients stay integers, INT64_MIN / -1 doesn't fit so it
+    // becomes a double (and INT64_MIN % -1 would trap)
+    if (integer && other->integer && !(intValue == INT64_MIN && other->intValue == -1) && intValue % other->intValue == 0)
+    {
+        return make_shared<NumberValue>(intValue / other->intValue, Range(getRange().getStart(), other->getRange().getEnd()));
+    }
     return make_shared<NumberValue>(value / other->getValue(), Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
@@ -165,11 +342,23 @@ shared_ptr<Value> NumberValue::mod(const shared_ptr<NumberValue> &other) const
         error("cannot divide by zero", other->getRange());
         return make_shared<NullValue>(Range::getEmpty()); // This won't be reached due to exception
     }
+
+    if (integer && other->integer)
+    {
+        // INT64_MIN % -1 traps, the answer is 0 for any x % -1
+        int64_t result = other->intValue == -1 ? 0 : intValue % other->intValue;
+        return make_shared<NumberValue>(result, Range(getRange().getStart(), other->getRange().getEnd()));
+    }
     return make_shared<NumberValue>(fmod(value, other->getValue()), Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
 shared_ptr<Value> NumberValue::eq(const shared_ptr<NumberValue> &other) const
 {
+    if (integer && other->integer)
+    {
+        return make_shared<BooleanValue>(intValue == other->intValue, Range(getRange().getStart(), other->getRange().getEnd()));
+    }
+
     // Use epsilon comparison for floating-point numbers to handle precision issues
     double diff = std::abs(value - other->getValue());
     bool isEqual = diff < EPSILON;
@@ -184,6 +373,10 @@ shared_ptr<Value> NumberValue::eq(const shared_ptr<NullValue> &other) const
 
 shared_ptr<Value> NumberValue::ne(const shared_ptr<NumberValue> &other) const
 {
+    if (integer && other->integer)
+    {
+        return make_shared<BooleanValue>(intValue != other->intValue, Range(getRange().getStart(), other->getRange().getEnd()));
+    }
     return make_shared<BooleanValue>(value != other->getValue(), Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
@@ -195,21 +388,37 @@ shared_ptr<Value> NumberValue::ne(const shared_ptr<NullValue> &other) const
 
 shared_ptr<Value> NumberValue::lt(const shared_ptr<NumberValue> &other) const
 {
+    if (integer && other->integer)
+    {
+        return make_shared<BooleanValue>(intValue < other->intValue, Range(getRange().getStart(), other->getRange().getEnd()));
+    }
     return make_shared<BooleanValue>(value < other->getValue(), Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
 shared_ptr<Value> NumberValue::le(const shared_ptr<NumberValue> &other) const
 {
+    if (integer && other->integer)
+    {
+        return make_shared<BooleanValue>(intValue <= other->intValue, Range(getRange().getStart(), other->getRange().getEnd()));
+    }
     return make_shared<BooleanValue>(value <= other->getValue(), Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
 shared_ptr<Value> NumberValue::gt(const shared_ptr<NumberValue> &other) const
 {
+    if (integer && other->integer)
+    {
+        return make_shared<BooleanValue>(intValue > other->intValue, Range(getRange().getStart(), other->getRange().getEnd()));
+    }
     return make_shared<BooleanValue>(value > other->getValue(), Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
 shared_ptr<Value> NumberValue::ge(const shared_ptr<NumberValue> &other) const
 {
+    if (integer && other->integer)
+    {
+        return make_shared<BooleanValue>(intValue >= other->intValue, Range(getRange().getStart(), other->getRange().getEnd()));
+    }
     return make_shared<BooleanValue>(value >= other->getValue(), Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
@@ -225,10 +434,79 @@ shared_ptr<Value> NumberValue::logicalOr(const shared_ptr<NumberValue> &other) c
 
 shared_ptr<Value> NumberValue::unaryMinus() const
 {
+    if (integer && intValue != INT64_MIN)
+    {
+        return make_shared<NumberValue>(-intValue, getRange());
+    }
     return make_shared<NumberValue>(-value, getRange());
 }
 
 shared_ptr<Value> NumberValue::unaryNot() const
 {
     return make_shared<BooleanValue>(!toBoolean(), getRange());
-}
\ No newline at end of file
+}
+
+shared_ptr<Value> NumberValue::bitNot() const
+{
+    return make_shared<NumberValue>(~bitwiseOperand(getRange()), getRange());
+}
+
+int64_t NumberValue::bitwiseOperand(const Range &range) const
+{
+    if (integer)
+    {
+        return intValue;
+    }
+
+    if (value != std::floor(value) || value < -9223372036854775808.0 || value >= 9223372036854775808.0)
+    {
+        error("bitwise operators need whole numbers, got " + toString(), range);
+        return 0; // This won't be reached due to exception
+    }
+    return static_cast<int64_t>(value);
+}
+
+shared_ptr<Value> NumberValue::bitAnd(const shared_ptr<NumberValue> &other) const
+{
+    int64_t result = bitwiseOperand(getRange()) & other->bitwiseOperand(other->getRange());
+    return make_shared<NumberValue>(result, Range(getRange().getStart(), other->getRange().getEnd()));
+}
+
+shared_ptr<Value> NumberValue::bitOr(const shared_ptr<NumberValue> &other) const
+{
+    int64_t result = bitwiseOperand(getRange()) | other->bitwiseOperand(other->getRange());
+    return make_shared<NumberValue>(result, Range(getRange().getStart(), other->getRange().getEnd()));
+}
+
+shared_ptr<Value> NumberValue::bitXor(const shared_ptr<NumberValue> &other) const
+{
+    int64_t result = bitwiseOperand(getRange()) ^ other->bitwiseOperand(other->getRange());
+    return make_shared<NumberValue>(result, Range(getRange().getStart(), other->getRange().getEnd()));
+}
+
+shared_ptr<Value> NumberValue::shiftLeft(const shared_ptr<NumberValue> &other) const
+{
+    int64_t count = other->bitwiseOperand(other->getRange());
+    if (count < 0 || count > 63)
+    {
+        error("shift count must be between 0 and 63, got " + other->toString(), other->getRange());
+        return nullptr; // This won't be reached due to exception
+    }
+
+    // shifted as unsigned so bits shifted out are dropped instead of overflowing
+    uint64_t bits = static_cast<uint64_t>(bitwiseOperand(getRange()));
+    return make_shared<NumberValue>(static_cast<int64_t>(bits << count), Range(getRange().getStart(), other->getRange().getEnd()));
+}
+
+shared_ptr<Value> NumberValue::shiftRight(const shared_ptr<NumberValue> &other) const
+{
+    int64_t count = other->bitwiseOperand(other->getRange());
+    if (count < 0 || count > 63)
+    {
+        error("shift count must be between 0 and 63, got " + other->toString(), other->getRange());
+        return nullptr; // This won't be reached due to exception
+    }
+
+    // arithmetic shift, negative numbers stay negative
+    return make_shared<NumberValue>(bitwiseOperand(getRange()) >> count, Range(getRange().getStart(), other->getRange().getEnd()));
+}
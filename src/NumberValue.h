@@ -1,26 +1,62 @@
 #pragma once
 
 #include <memory>
+#include <cstdint>
 
 #include "Values.h"
 #include "Range.h"
 
+// A number is either a 64 bit integer or a double. Integer literals and
+// operations on integers stay integers, so index math and hashing are exact,
+// and a result becomes a double only when it isn't whole or doesn't fit.
+// getValue() works for both, value is kept in step with intValue.
 class NumberValue : public Value
 {
 public:
     NumberValue(int value, const Range &range = {});
+    NumberValue(int64_t value, const Range &range = {});
     NumberValue(unsigned long value, const Range &range = {});
     NumberValue(double value, const Range &range = {});
 
+    // an integer if value is whole and fits, a double otherwise
+    static shared_ptr<NumberValue> fromWhole(double value, const Range &range = {});
+
     void registerBuiltins();
 
     inline double getValue() const { return value; }
-    inline void setValue(double v) { value = v; }
+    inline void setValue(double v) { value = v; integer = false; }
+    inline void setValue(int64_t v) { intValue = v; value = static_cast<double>(v); integer = true; }
     inline bool isInteger() const { return value == static_cast<int>(value); }
 
+    // true if the number is held as an integer, getInt() is then exact
+    inline bool isInt() const { return integer; }
+    inline int64_t getInt() const { return integer ? intValue : static_cast<int64_t>(value); }
+
+    // finite and without a fraction, what an index has to be
+    bool isWhole() const;
+
+    // the element this number picks out of length elements, -1 if it isn't
+    // a whole number below length; checked before narrowing, so a number
+    // too large for an int64_t or an int can't wrap around to an index
+    int64_t indexInto(size_t length) const;
+
+    // the number plus delta, for ++ and --
+    shared_ptr<NumberValue> plus(int delta, const Range &range = {}) const;
+
+    // formats a number the way toString() does
+    static string format(double value);
+
+    // reads a number from the start of text like std::stod, but integers
+    // stay integers; nullptr if text doesn't start with a number
+    static shared_ptr<NumberValue> parse(const string &text, const Range &range = {});
+
+    virtual shared_ptr<Value> getMember(const string &name) const override;
+
     virtual string toString() const override;
     virtual bool toBoolean() const override;
     virtual string typeAsString() const override;
+    virtual size_t hash() const override;
+    virtual bool equals(const Value &other) const override;
 
 public:
     virtual shared_ptr<Value> add(const shared_ptr<NumberValue> &other) const override;
@@ -52,10 +88,25 @@ public:
 
     virtual shared_ptr<Value> logicalOr(const shared_ptr<NumberValue> &other) const override;
 
+    virtual shared_ptr<Value> bitAnd(const shared_ptr<NumberValue> &other) const override;
+    virtual shared_ptr<Value> bitOr(const shared_ptr<NumberValue> &other) const override;
+    virtual shared_ptr<Value> bitXor(const shared_ptr<NumberValue> &other) const override;
+    virtual shared_ptr<Value> shiftLeft(const shared_ptr<NumberValue> &other) const override;
+    virtual shared_ptr<Value> shiftRight(const shared_ptr<NumberValue> &other) const override;
+
     virtual shared_ptr<Value> unaryMinus() const override;
 
     virtual shared_ptr<Value> unaryNot() const override;
 
+    virtual shared_ptr<Value> bitNot() const override;
+
+private:
+    // the operands of a bitwise operator as integers, reports an error for
+    // numbers that aren't whole
+    int64_t bitwiseOperand(const Range &range) const;
+
 private:
     double value;
+    int64_t intValue;
+    bool integer;
 };
\ No newline at end of file
@@ -0,0 +1,536 @@
+#include "Optimizer.h"
+#include "LoopAnalysisVisitor.h"
+#include "TypeInferenceVisitor.h"
+#include "Nodes.h"
+#include "Values.h"
+#include "Token.h"
+
+using std::dynamic_pointer_cast;
+using std::make_shared;
+using std::shared_ptr;
+using std::static_pointer_cast;
+using std::string;
+using std::vector;
+
+Optimizer::Optimizer():
+    replaced(nullptr)
+{
+}
+
+void Optimizer::visitAllChildren(Node *node)
+{
+    replaced = nullptr;
+    replacement = nullptr;
+    node->visit(this);
+
+    // folding may have turned loop bounds into literals
+    LoopAnalysisVisitor loops;
+    loops.visitAllChildren(node);
+
+    TypeInferenceVisitor types;
+    types.visitAllChildren(node);
+}
+
+void Optimizer::visit(StatementsNode *node)
+{
+    vector<shared_ptr<StatementNode>> statements;
+    bool reachable = true;
+    for (const auto &statement : node->getStatements())
+    {
+        // function declarations are hoisted, they are there even after a return
+        if (!reachable && !dynamic_pointer_cast<FuncDeclNode>(statement))
+        {
+            continue;
+        }
+
+        auto simplified = simplify(statement);
+        if (!simplified)
+        {
+            continue;
+        }
+        statements.push_back(simplified);
+
+        if (dynamic_cast<ReturnStatementNode *>(simplified.get()) ||
+            dynamic_cast<BreakNode *>(simplified.get()) ||
+            dynamic_cast<ContinueNode *>(simplified.get()))
+        {
+            reachable = false;
+        }
+    }
+    node->setStatements(std::move(statements));
+}
+
+void Optimizer::visit(BinaryExprNode *node)
+{
+    int op = node->getOperator()->getType();
+
+    node->setLeft(fold(node->getLeft()));
+    auto left = literal(node->getLeft().get());
+
+    // the right operand of && and || doesn't run when the left decides
+    if (left && (op == Token::AND || op == Token::OR) && left->toBoolean() == (op == Token::OR))
+    {
+        replace(node, node->getLeft());
+        return;
+    }
+
+    node->setRight(fold(node->getRight()));
+    auto right = literal(node->getRight().get());
+
+    if (left && right && foldable(op, *left, *right))
+    {
+        if (auto folded = toNode(evaluate(op, left, right), node->getRange()))
+        {
+            replace(node, folded);
+        }
+        return;
+    }
+
+    // operations that give back their operand unchanged
+    auto is = [](const shared_ptr<ExpressionNode> &operand, int64_t value)
+    {
+        auto number = dynamic_cast<NumberNode *>(operand.get());
+        return number && number->isInteger() && number->getIntValue() == value;
+    };
+
+    ExpressionNode *leftNode = node->getLeft().get();
+    ExpressionNode *rightNode = node->getRight().get();
+    switch (op)
+    {
+    case '*':
+        if (is(node->getRight(), 1) && isNumber(leftNode))
+        {
+            replace(node, node->getLeft());
+        }
+        else if (is(node->getLeft(), 1) && isNumber(rightNode))
+        {
+            replace(node, node->getRight());
+        }
+        break;
+    case '/':
+        if (is(node->getRight(), 1) && isNumber(leftNode))
+        {
+            replace(node, node->getLeft());
+        }
+        break;
+    case '-':
+        if (is(node->getRight(), 0) && isNumber(leftNode))
+        {
+            replace(node, node->getLeft());
+        }
+        break;
+    case '+':
+        if (is(node->getRight(), 0) && isInteger(leftNode))
+        {
+            replace(node, node->getLeft());
+        }
+        else if (is(node->getLeft(), 0) && isInteger(rightNode))
+        {
+            replace(node, node->getRight());
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void Optimizer::visit(UnaryExprNode *node)
+{
+    node->setExpression(fold(node->getExpression()));
+    if (!node->isPrefix())
+    {
+        return;
+    }
+
+    auto value = literal(node->getExpression().get());
+    if (!value)
+    {
+        return;
+    }
+
+    shared_ptr<Value> result;
+    bool number = value->getType() == Value::Type::number;
+    switch (node->getOperator()->getType())
+    {
+    case '-':
+        if (number)
+        {
+            result = value->unaryMinus();
+        }
+        break;
+    case '!':
+        if (number || value->getType() == Value::Type::boolean)
+        {
+            result = value->unaryNot();
+        }
+        break;
+    case '~':
+        if (number && static_cast<NumberValue &>(*value).isInt())
+        {
+            result = value->bitNot();
+        }
+        break;
+    default:
+        break;
+    }
+
+    if (auto folded = toNode(result, node->getRange()))
+    {
+        replace(node, folded);
+    }
+}
+
+void Optimizer::visit(VarDeclNode *node)
+{
+    node->setExpr(fold(node->getExpr()));
+}
+
+void Optimizer::visit(AssignNode *node)
+{
+    // an element being assigned may have an index to fold
+    if (node->getAsignee())
+    {
+        node->getAsignee()->visit(this);
+    }
+    node->setExpr(fold(node->getExpr()));
+}
+
+void Optimizer::visit(ArgListNode *node)
+{
+    for (int i = 0; i < node->getArgCount(); i++)
+    {
+        node->setArg(i, fold(node->getArg(i)));
+    }
+}
+
+void Optimizer::visit(ArrayNode *node)
+{
+    for (size_t i = 0; i < node->getElements().size(); i++)
+    {
+        node->setElement(i, fold(node->getElements()[i]));
+    }
+}
+
+void Optimizer::visit(ArrayAccessNode *node)
+{
+    if (node->getArray())
+    {
+        node->getArray()->visit(this);
+    }
+    node->setIndex(fold(node->getIndex()));
+}
+
+void Optimizer::visit(MemberAccessNode *node)
+{
+    node->setExpression(fold(node->getExpression()));
+}
+
+void Optimizer::visit(ReturnStatementNode *node)
+{
+    if (node->getExpression())
+    {
+        node->setExpression(fold(node->getExpression()));
+    }
+}
+
+void Optimizer::visit(YieldNode *node)
+{
+    node->setExpression(fold(node->getExpression()));
+}
+
+void Optimizer::visit(IfStatementNode *node)
+{
+    node->setCondition(fold(node->getCondition()));
+    node->setThenBranch(simplify(node->getThenBranch()));
+    node->setElseBranch(simplify(node->getElseBranch()));
+
+    auto condition = literal(node->getCondition().get());
+    if (!condition)
+    {
+        return;
+    }
+
+    // a block makes the same scope in place of the if, a single statement
+    // keeps its if so it isn't hoisted or printed where it wasn't before
+    auto branch = condition->toBoolean() ? node->getThenBranch() : node->getElseBranch();
+    if (!branch)
+    {
+        replace(node, nullptr);
+    }
+    else if (dynamic_pointer_cast<BlockNode>(branch))
+    {
+        replace(node, branch);
+    }
+}
+
+void Optimizer::visit(WhileNode *node)
+{
+    node->setCondition(fold(node->getCondition()));
+    if (node->getBody())
+    {
+        node->getBody()->visit(this);
+    }
+
+    auto condition = literal(node->getCondition().get());
+    if (condition && !condition->toBoolean())
+    {
+        replace(node, nullptr);
+    }
+}
+
+void Optimizer::visit(ForStatementNode *node)
+{
+    if (node->getInit())
+    {
+        node->getInit()->visit(this);
+    }
+    if (auto condition = dynamic_pointer_cast<ExpressionNode>(node->getCondition()))
+    {
+        node->setCondition(fold(condition));
+    }
+    node->setIncrement(fold(node->getIncrement()));
+    if (node->getBody())
+    {
+        node->getBody()->visit(this);
+    }
+}
+
+shared_ptr<ExpressionNode> Optimizer::fold(const shared_ptr<ExpressionNode> &expression)
+{
+    auto simplified = simplify(expression);
+    auto folded = dynamic_pointer_cast<ExpressionNode>(simplified);
+    return folded ? folded : expression;
+}
+
+shared_ptr<StatementNode> Optimizer::simplify(const shared_ptr<StatementNode> &statement)
+{
+    if (!statement)
+    {
+        return nullptr;
+    }
+
+    replaced = nullptr;
+    statement->visit(this);
+    if (replaced != statement.get())
+    {
+        return statement;
+    }
+
+    replaced = nullptr;
+    auto result = replacement;
+    replacement = nullptr;
+    return result;
+}
+
+void Optimizer::replace(Node *node, const shared_ptr<StatementNode> &with)
+{
+    replaced = node;
+    replacement = with;
+}
+
+shared_ptr<Value> Optimizer::literal(Node *node)
+{
+    if (auto number = dynamic_cast<NumberNode *>(node))
+    {
+        if (number->isInteger())
+        {
+            return make_shared<NumberValue>(number->getIntValue(), number->getRange());
+        }
+        return make_shared<NumberValue>(number->getValue(), number->getRange());
+    }
+    if (auto text = dynamic_cast<StringNode *>(node))
+    {
+        return make_shared<StringValue>(text->getValue());
+    }
+    if (auto boolean = dynamic_cast<BooleanNode *>(node))
+    {
+        return make_shared<BooleanValue>(boolean->getValue());
+    }
+    return nullptr;
+}
+
+shared_ptr<ExpressionNode> Optimizer::toNode(const shared_ptr<Value> &value, const Range &range)
+{
+    if (!value)
+    {
+        return nullptr;
+    }
+
+    switch (value->getType())
+    {
+    case Value::Type::number:
+    {
+        auto &number = static_cast<const NumberValue &>(*value);
+        if (number.isInt())
+        {
+            return make_shared<NumberNode>(number.getInt(), range);
+        }
+        return make_shared<NumberNode>(number.getValue(), range);
+    }
+    case Value::Type::string_:
+        return make_shared<StringNode>(Token(Token::STRING, range, string(static_cast<const StringValue &>(*value).view())));
+    case Value::Type::boolean:
+    {
+        bool truth = value->toBoolean();
+        return make_shared<BooleanNode>(Token(truth ? Token::TRUE : Token::FALSE, range, truth ? "true" : "false"));
+    }
+    default:
+        return nullptr;
+    }
+}
+
+bool Optimizer::foldable(int op, const Value &left, const Value &right)
+{
+    Value::Type leftType = left.getType();
+    Value::Type rightType = right.getType();
+    bool comparison = op == '<' || op == '>' || op == Token::LE || op == Token::GE || op == Token::EQ || op == Token::NE;
+
+    if (leftType == Value::Type::number && rightType == Value::Type::number)
+    {
+        auto &a = static_cast<const NumberValue &>(left);
+        auto &b = static_cast<const NumberValue &>(right);
+        switch (op)
+        {
+        case '+':
+        case '-':
+        case '*':
+        case Token::AND:
+        case Token::OR:
+            return true;
+        case '/':
+        case '%':
+            return b.getValue() != 0.0;
+        case '&':
+        case '|':
+        case '^':
+            return a.isInt() && b.isInt();
+        case Token::SHL:
+        case Token::SHR:
+            return a.isInt() && b.isInt() && b.getInt() >= 0 && b.getInt() <= 63;
+        default:
+            return comparison;
+        }
+    }
+
+    if (leftType == Value::Type::string_ && rightType == Value::Type::string_)
+    {
+        return op == '+' || comparison;
+    }
+
+    if (leftType == Value::Type::boolean && rightType == Value::Type::boolean)
+    {
+        return op == Token::AND || op == Token::OR || comparison;
+    }
+
+    // a string and a number or boolean only concatenate
+    bool leftString = leftType == Value::Type::string_;
+    bool rightString = rightType == Value::Type::string_;
+    bool leftScalar = leftType == Value::Type::number || leftType == Value::Type::boolean;
+    bool rightScalar = rightType == Value::Type::number || rightType == Value::Type::boolean;
+    return op == '+' && ((leftString && rightScalar) || (leftScalar && rightString));
+}
+
+shared_ptr<Value> Optimizer::evaluate(int op, const shared_ptr<Value> &left, const shared_ptr<Value> &right)
+{
+    switch (op)
+    {
+    case '+':
+        return left->add(right);
+    case '-':
+        return left->sub(right);
+    case '*':
+        return left->mul(right);
+    case '/':
+        return left->div(right);
+    case '%':
+        return left->mod(right);
+    case Token::EQ:
+        return left->eq(right);
+    case Token::NE:
+        return left->ne(right);
+    case Token::LE:
+        return left->le(right);
+    case Token::GE:
+        return left->ge(right);
+    case '<':
+        return left->lt(right);
+    case '>':
+        return left->gt(right);
+    case Token::AND:
+        return left->logicalAnd(right);
+    case Token::OR:
+        return left->logicalOr(right);
+    case '&':
+        return left->bitAnd(right);
+    case '|':
+        return left->bitOr(right);
+    case '^':
+        return left->bitXor(right);
+    case Token::SHL:
+        return left->shiftLeft(right);
+    case Token::SHR:
+        return left->shiftRight(right);
+    default:
+        return nullptr;
+    }
+}
+
+bool Optimizer::isNumber(ExpressionNode *node)
+{
+    if (dynamic_cast<NumberNode *>(node))
+    {
+        return true;
+    }
+
+    // only numbers have these operators, anything else is an error
+    if (auto unary = dynamic_cast<UnaryExprNode *>(node))
+    {
+        int op = unary->getOperator()->getType();
+        return unary->isPrefix() && (op == '-' || op == '~');
+    }
+    if (auto binary = dynamic_cast<BinaryExprNode *>(node))
+    {
+        switch (binary->getOperator()->getType())
+        {
+        case '+':
+            return isNumber(binary->getLeft().get()) && isNumber(binary->getRight().get());
+        case '-':
+        case '*':
+        case '/':
+        case '%':
+            return true;
+        default:
+            return isInteger(node);
+        }
+    }
+    return false;
+}
+
+bool Optimizer::isInteger(ExpressionNode *node)
+{
+    if (auto number = dynamic_cast<NumberNode *>(node))
+    {
+        return number->isInteger();
+    }
+
+    // bitwise results are always integers
+    if (auto unary = dynamic_cast<UnaryExprNode *>(node))
+    {
+        return unary->isPrefix() && unary->getOperator()->getType() == '~';
+    }
+    if (auto binary = dynamic_cast<BinaryExprNode *>(node))
+    {
+        switch (binary->getOperator()->getType())
+        {
+        case '&':
+        case '|':
+        case '^':
+        case Token::SHL:
+        case Token::SHR:
+            return true;
+        default:
+            return false;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <memory>
+
+#include "Visitor.h"
+#include "Range.h"
+
+class ExpressionNode;
+class StatementNode;
+class Value;
+
+// Simplifies a program before it runs, changing the tree in place. Runs on
+// every program and module once the SemanticErrorVisitor has passed it.
+//
+// - Operators whose operands are literals are worked out with the value
+//   classes the interpreter uses, so the result is the one running them
+//   would give. Operations that would report an error (dividing by zero, a
+//   shift out of range) are left for the interpreter to report.
+// - && and || whose left operand is a literal that decides them become it.
+// - x * 1, 1 * x, x / 1 and x - 0 become x where x can only be a number,
+//   x + 0 and 0 + x where it can only be an integer (-0 + 0 is 0).
+// - An if or while whose condition is a literal loses what can't run, and
+//   statements after a return, break or continue in the same block are
+//   dropped, function declarations excepted since they are hoisted.
+//
+// Afterwards the loops are looked at again, their bounds may have become
+// literals, and the TypeInferenceVisitor marks the locals that only hold
+// numbers.
+class Optimizer : public Visitor
+{
+public:
+    Optimizer();
+
+    virtual void visitAllChildren(Node *node) override;
+public:
+    virtual void visit(StatementsNode *node) override;
+    virtual void visit(BinaryExprNode *node) override;
+    virtual void visit(UnaryExprNode *node) override;
+    virtual void visit(VarDeclNode *node) override;
+    virtual void visit(AssignNode *node) override;
+    virtual void visit(ArgListNode *node) override;
+    virtual void visit(ArrayNode *node) override;
+    virtual void visit(ArrayAccessNode *node) override;
+    virtual void visit(MemberAccessNode *node) override;
+    virtual void visit(ReturnStatementNode *node) override;
+    virtual void visit(YieldNode *node) override;
+    virtual void visit(IfStatementNode *node) override;
+    virtual void visit(WhileNode *node) override;
+    virtual void visit(ForStatementNode *node) override;
+private:
+    // the node an expression or statement became, a statement that goes
+    // away becomes nullptr
+    std::shared_ptr<ExpressionNode> fold(const std::shared_ptr<ExpressionNode> &expression);
+    std::shared_ptr<StatementNode> simplify(const std::shared_ptr<StatementNode> &statement);
+
+    // called by a visit to have its node replaced
+    void replace(Node *node, const std::shared_ptr<StatementNode> &with);
+
+    // the value of a number, string or boolean literal, nullptr for anything else
+    static std::shared_ptr<Value> literal(Node *node);
+    static std::shared_ptr<ExpressionNode> toNode(const std::shared_ptr<Value> &value, const Range &range);
+
+    // true if op on these values gives a value without reporting an error
+    static bool foldable(int op, const Value &left, const Value &right);
+    static std::shared_ptr<Value> evaluate(int op, const std::shared_ptr<Value> &left, const std::shared_ptr<Value> &right);
+
+    // true if whatever the expression evaluates to is a number (or an error)
+    static bool isNumber(ExpressionNode *node);
+    static bool isInteger(ExpressionNode *node);
+
+private:
+    Node *replaced;
+    std::shared_ptr<StatementNode> replacement;
+};
@@ -14,6 +14,8 @@
 #include "Utils.h"
 #include "Nodes.h"
 #include "Tokenizer.h"
+#include "FreeVariableVisitor.h"
+#include "LoopAnalysisVisitor.h"
 
 #define accept(x) return { true, x }
 #define reject() return { false, nullptr }
@@ -59,7 +61,8 @@ Parser::Parser():
     tokenizer(),
     currentToken(),
     hadError(false),
-    depth(0)
+    depth(0),
+    sawYield(false)
 { }
 
 set<int> Parser::additFirsts = { '+', '-' };
@@ -68,6 +71,9 @@ set<int> Parser::argListFirsts = exprFirsts;
 set<int> Parser::assertFirsts = { Token::ASSERT };
 set<int> Parser::assignFirsts = { Token::NUMBER, Token::IDENT, Token::STRING,Token::LET, Token::CONST, Token::INC, Token::DEC, Token::NULL_TOKEN, Token::TRUE, Token::FALSE, '(', '[', ';', '+', '!' };
 set<int> Parser::assignPFirsts = { '=', Token::PLUS_EQUAL, Token::MINUS_EQUAL, Token::MUL_EQUAL, Token::DIV_EQUAL, Token::MOD_EQUAL };
+set<int> Parser::bitAndFirsts = { '&' };
+set<int> Parser::bitOrFirsts = { '|' };
+set<int> Parser::bitXorFirsts = { '^' };
 set<int> Parser::blockFirsts = { '{' };
 set<int> Parser::breakStmtFirsts = { Token::BREAK };
 set<int> Parser::classDeclFirsts = { Token::CLASS };
@@ -75,8 +81,8 @@ set<int> Parser::constStmtFirsts = { Token::CONST };
 set<int> Parser::continueStmtFirsts = { Token::CONTINUE };
 set<int> Parser::deleteStmtFirsts = { Token::DELETE };
 set<int> Parser::equalityFirsts = { Token::EQ, Token::NE };
-set<int> Parser::exprFirsts = { Token::NUMBER, Token::IDENT, Token::STRING, Token::LET, Token::CONST, Token::INC, Token::DEC, Token::NULL_TOKEN, Token::TRUE, Token::FALSE, '(', '[', '-', '+', '!' };
-set<int> Parser::exprStmtFirsts = { Token::NUMBER, Token::IDENT, Token::STRING, Token::LET, Token::CONST, Token::INC, Token::DEC, Token::NULL_TOKEN, Token::TRUE, Token::FALSE, '(', '[', ';', '-', '+', '!' };
+set<int> Parser::exprFirsts = { Token::NUMBER, Token::IDENT, Token::STRING, Token::LET, Token::CONST, Token::INC, Token::DEC, Token::NULL_TOKEN, Token::TRUE, Token::FALSE, '(', '[', '-', '+', '!', '~' };
+set<int> Parser::exprStmtFirsts = { Token::NUMBER, Token::IDENT, Token::STRING, Token::LET, Token::CONST, Token::INC, Token::DEC, Token::NULL_TOKEN, Token::TRUE, Token::FALSE, '(', '[', ';', '-', '+', '!', '~' };
 set<int> Parser::forEachStmtFirsts = { Token::FOREACH };
 set<int> Parser::forStmtFirsts = { Token::FOR };
 set<int> Parser::funcDeclFirsts = { Token::FN };
@@ -84,12 +90,14 @@ set<int> Parser::ifStmtFirsts = { Token::IF };
 set<int> Parser::importFirsts = { Token::IMPORT };
 set<int> Parser::letStmtFirsts = { Token::LET };
 set<int> Parser::multFirsts = { '*', '/', '%' };
-set<int> Parser::postFirsts = { Token::NUMBER, Token::IDENT, Token::STRING, '(', '[', '-', '+', '!' };
+set<int> Parser::postFirsts = { Token::NUMBER, Token::IDENT, Token::STRING, '(', '[', '-', '+', '!', '~' };
 set<int> Parser::postPFirsts = { '(', '[', '.', Token::INC, Token::DEC, '?' };
 set<int> Parser::relationFirsts = { '>', '<', Token::LE, Token::GE };
 set<int> Parser::returnStmtFirsts = { Token::RETURN };
+set<int> Parser::shiftFirsts = { Token::SHL, Token::SHR };
 set<int> Parser::unaryFirsts = { '+', '-', '!', '~' };
 set<int> Parser::whileStmtFirsts = { Token::WHILE };
+set<int> Parser::yieldStmtFirsts = { Token::YIELD };
 
 Token Parser::peekToken() const
 {
@@ -122,6 +130,15 @@ Result<Node> Parser::parse(const string &input, const string &filename)
 
     // Clear tokenizer before successful return
     tokenizer = Tokenizer();
+
+    // decide which nested functions can be flat closures
+    FreeVariableVisitor freeVariables;
+    freeVariables.visitAllChildren(result.value.get());
+
+    // find the for loops that can run as counted loops
+    LoopAnalysisVisitor loops;
+    loops.visitAllChildren(result.value.get());
+
     accept(result.value);
 }
 
@@ -141,6 +158,15 @@ Result<Node> Parser::parseFromPosition(const string &input, size_t startPos, con
 
     // Clear tokenizer before successful return
     tokenizer = Tokenizer();
+
+    // decide which nested functions can be flat closures
+    FreeVariableVisitor freeVariables;
+    freeVariables.visitAllChildren(result.value.get());
+
+    // find the for loops that can run as counted loops
+    LoopAnalysisVisitor loops;
+    loops.visitAllChildren(result.value.get());
+
     accept(result.value);
 }
 
@@ -174,6 +200,7 @@ Result<StatementsNode> Parser::parseStmts()
 //       | fnDecl       - firsts: FN
 //       | classDecl    - firsts: CLASS
 //       | returnStmt   - firsts: RETURN
+//       | yieldStmt    - firsts: YIELD
 //       | breakStmt    - firsts: BREAK
 //       | importStmt   - firsts: IMPORT
 Result<StatementNode> Parser::parseStmt()
@@ -220,6 +247,10 @@ Result<StatementNode> Parser::parseStmt()
     {
         acceptNode(parseReturnStmt());
     }
+    else if (inSet(token, yieldStmtFirsts))
+    {
+        acceptNode(parseYieldStmt());
+    }
     else if (inSet(token, breakStmtFirsts))
     {
         acceptNode(parseBreakStmt());
@@ -539,14 +570,20 @@ Result<FuncDeclNode> Parser::parseFuncDecl()
 
     Token closeParenToken = expectToken(')');
 
-    // Function must have a body (block statement)
+    // Function must have a body (block statement), a yield in it (but not in
+    // a function nested in it) makes this function a generator
+    bool outerSawYield = sawYield;
+    sawYield = false;
     auto bodyResult = parseBlock();
+    bool generator = sawYield;
+    sawYield = outerSawYield;
     if (!bodyResult.status)
     {
         reject();
     }
 
     auto funcDecl = make_shared<FuncDeclNode>(identifier, params, bodyResult.value);
+    funcDecl->setGenerator(generator);
     funcDecl->setRangeStart(fnToken.getRange().getStart());
     funcDecl->setRangeEnd(bodyResult.value->getRange().getEnd());
 
@@ -705,6 +742,37 @@ Result<ReturnStatementNode> Parser::parseReturnStmt()
     accept(returnStmt);
 }
 
+// yieldStmt -> YIELD expr ;
+//            | YIELD ;
+Result<YieldNode> Parser::parseYieldStmt()
+{
+    Token yieldToken = expectToken(Token::YIELD);
+    sawYield = true;
+
+    Token token = peekToken();
+    if (token == ';')
+    {
+        advanceToken(); // consume ';'
+
+        auto yieldStmt = make_shared<YieldNode>();
+        yieldStmt->setRange(yieldToken.getRange());
+        accept(yieldStmt);
+    }
+
+    auto exprResult = parseExpr();
+    if (!exprResult.status)
+    {
+        reject();
+    }
+
+    Token semicolonToken = expectToken(';');
+
+    auto yieldStmt = make_shared<YieldNode>(exprResult.value);
+    yieldStmt->setRangeStart(yieldToken.getRange().getStart());
+
+    accept(yieldStmt);
+}
+
 Result<BreakNode> Parser::parseBreakStmt()
 {
     Token breakToken = expectToken(Token::BREAK);
@@ -981,10 +1049,10 @@ Result<ExpressionNode> Parser::parseOrP(shared_ptr<ExpressionNode> lhs)
 }
 
 //***************************************************
-// and -> equality and'
+// and -> bitOr and'
 Result<ExpressionNode> Parser::parseAnd()
 {
-    auto result = parseEquality();
+    auto result = parseBitOr();
     if (!result.status)
     {
         reject();
@@ -998,7 +1066,7 @@ Result<ExpressionNode> Parser::parseAnd()
 
     accept(result.value);
 }
-// and' -> AND equality and'
+// and' -> AND bitOr and'
 //       | nothing
 Result<ExpressionNode> Parser::parseAndP(shared_ptr<ExpressionNode> lhs)
 {
@@ -1009,7 +1077,7 @@ Result<ExpressionNode> Parser::parseAndP(shared_ptr<ExpressionNode> lhs)
     }
     advanceToken(); // consume 'eq'
 
-    auto rhs = parseEquality();
+    auto rhs = parseBitOr();
     if (!rhs.status)
     {
         reject();
@@ -1024,6 +1092,138 @@ Result<ExpressionNode> Parser::parseAndP(shared_ptr<ExpressionNode> lhs)
     accept(rhs.value);
 }
 
+//***************************************************
+// bitOr -> bitXor bitOr'
+Result<ExpressionNode> Parser::parseBitOr()
+{
+    auto result = parseBitXor();
+    if (!result.status)
+    {
+        reject();
+    }
+
+    result = parseBitOrP(result.value);
+    if (!result.status)
+    {
+        reject();
+    }
+
+    accept(result.value);
+}
+// bitOr' -> | bitXor bitOr'
+//        | nothing
+Result<ExpressionNode> Parser::parseBitOrP(shared_ptr<ExpressionNode> lhs)
+{
+    Token token = peekToken();
+    if (token != '|')
+    {
+        accept(lhs);
+    }
+    advanceToken(); // consume operator
+
+    auto rhs = parseBitXor();
+    if (!rhs.status)
+    {
+        reject();
+    }
+
+    rhs = parseBitOrP(make_shared<BinaryExprNode>(lhs, make_shared<OpNode>(token), rhs.value));
+    if (!rhs.status)
+    {
+        reject();
+    }
+
+    accept(rhs.value);
+}
+
+//***************************************************
+// bitXor -> bitAnd bitXor'
+Result<ExpressionNode> Parser::parseBitXor()
+{
+    auto result = parseBitAnd();
+    if (!result.status)
+    {
+        reject();
+    }
+
+    result = parseBitXorP(result.value);
+    if (!result.status)
+    {
+        reject();
+    }
+
+    accept(result.value);
+}
+// bitXor' -> ^ bitAnd bitXor'
+//         | nothing
+Result<ExpressionNode> Parser::parseBitXorP(shared_ptr<ExpressionNode> lhs)
+{
+    Token token = peekToken();
+    if (token != '^')
+    {
+        accept(lhs);
+    }
+    advanceToken(); // consume operator
+
+    auto rhs = parseBitAnd();
+    if (!rhs.status)
+    {
+        reject();
+    }
+
+    rhs = parseBitXorP(make_shared<BinaryExprNode>(lhs, make_shared<OpNode>(token), rhs.value));
+    if (!rhs.status)
+    {
+        reject();
+    }
+
+    accept(rhs.value);
+}
+
+//***************************************************
+// bitAnd -> equality bitAnd'
+Result<ExpressionNode> Parser::parseBitAnd()
+{
+    auto result = parseEquality();
+    if (!result.status)
+    {
+        reject();
+    }
+
+    result = parseBitAndP(result.value);
+    if (!result.status)
+    {
+        reject();
+    }
+
+    accept(result.value);
+}
+// bitAnd' -> & equality bitAnd'
+//         | nothing
+Result<ExpressionNode> Parser::parseBitAndP(shared_ptr<ExpressionNode> lhs)
+{
+    Token token = peekToken();
+    if (token != '&')
+    {
+        accept(lhs);
+    }
+    advanceToken(); // consume operator
+
+    auto rhs = parseEquality();
+    if (!rhs.status)
+    {
+        reject();
+    }
+
+    rhs = parseBitAndP(make_shared<BinaryExprNode>(lhs, make_shared<OpNode>(token), rhs.value));
+    if (!rhs.status)
+    {
+        reject();
+    }
+
+    accept(rhs.value);
+}
+
 //***************************************************
 // equality -> relation equality'
 Result<ExpressionNode> Parser::parseEquality()
@@ -1070,10 +1270,10 @@ Result<ExpressionNode> Parser::parseEqualityP(shared_ptr<ExpressionNode> lhs)
 }
 
 //***************************************************
-// relation -> addit relation'
+// relation -> shift relation'
 Result<ExpressionNode> Parser::parseRelation()
 {
-    auto result = parseAddit();
+    auto result = parseShift();
     if (!result.status)
     {
         reject();
@@ -1087,10 +1287,10 @@ Result<ExpressionNode> Parser::parseRelation()
 
     accept(result.value);
 }
-// relation' -> > addit relation'
-//            | < addit relation'
-//            | GE addit relation'
-//            | LE addit relation'
+// relation' -> > shift relation'
+//            | < shift relation'
+//            | GE shift relation'
+//            | LE shift relation'
 //            | nothing
 Result<ExpressionNode> Parser::parseRelationP(shared_ptr<ExpressionNode> lhs)
 {
@@ -1101,7 +1301,7 @@ Result<ExpressionNode> Parser::parseRelationP(shared_ptr<ExpressionNode> lhs)
     }
     advanceToken(); // consume 'relation' operator
 
-    auto rhs = parseAddit();
+    auto rhs = parseShift();
     if (!rhs.status)
     {
         reject();
@@ -1116,6 +1316,51 @@ Result<ExpressionNode> Parser::parseRelationP(shared_ptr<ExpressionNode> lhs)
     accept(rhs.value);
 }
 
+//***************************************************
+// shift -> addit shift'
+Result<ExpressionNode> Parser::parseShift()
+{
+    auto result = parseAddit();
+    if (!result.status)
+    {
+        reject();
+    }
+
+    result = parseShiftP(result.value);
+    if (!result.status)
+    {
+        reject();
+    }
+
+    accept(result.value);
+}
+// shift' -> SHL addit shift'
+//        | SHR addit shift'
+//        | nothing
+Result<ExpressionNode> Parser::parseShiftP(shared_ptr<ExpressionNode> lhs)
+{
+    Token token = peekToken();
+    if (token != Token::SHL && token != Token::SHR)
+    {
+        accept(lhs);
+    }
+    advanceToken(); // consume operator
+
+    auto rhs = parseAddit();
+    if (!rhs.status)
+    {
+        reject();
+    }
+
+    rhs = parseShiftP(make_shared<BinaryExprNode>(lhs, make_shared<OpNode>(token), rhs.value));
+    if (!rhs.status)
+    {
+        reject();
+    }
+
+    accept(rhs.value);
+}
+
 //***************************************************
 // addit -> mult addit'
 Result<ExpressionNode> Parser::parseAddit()
@@ -1213,6 +1458,7 @@ Result<ExpressionNode> Parser::parseMultP(shared_ptr<ExpressionNode> lhs)
 //        | + mult
 //        | - mult
 //        | ! mult
+//        | ~ mult
 //        | post
 Result<ExpressionNode> Parser::parseUnary()
 {
@@ -1222,7 +1468,8 @@ Result<ExpressionNode> Parser::parseUnary()
         token != Token::DEC &&
         token != '+' &&
         token != '-' &&
-        token != '!')
+        token != '!' &&
+        token != '~')
     {
         acceptNode(parsePost());
     }
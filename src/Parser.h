@@ -115,6 +115,10 @@ private:
     //             | RETURN ;
     Result<ReturnStatementNode> parseReturnStmt();
 
+    // yieldStmt -> YIELD expr ;
+    //            | YIELD ;
+    Result<YieldNode> parseYieldStmt();
+
     // breakStmt -> BREAK ;
     Result<BreakNode> parseBreakStmt();
 
@@ -147,7 +151,7 @@ private:
     //***************************************************
     // expr -> assign expr'
     //***************************************************
-    // firsts: INC, DEC, +, -, !, (, [, IDENT, NUMBER, STRING, TRUE, FALSE, NULL
+    // firsts: INC, DEC, +, -, !, ~, (, [, IDENT, NUMBER, STRING, TRUE, FALSE, NULL
     Result<ExpressionNode> parseExpr();
 
     //***************************************************
@@ -160,7 +164,7 @@ private:
     //***************************************************
     // assign -> or assign'
     //***************************************************
-    // firsts: INC, DEC, +, -, !, (, [, IDENT, NUMBER, STRING, TRUE, FALSE, NULL
+    // firsts: INC, DEC, +, -, !, ~, (, [, IDENT, NUMBER, STRING, TRUE, FALSE, NULL
     Result<ExpressionNode> parseAssign();
 
     //***************************************************
@@ -173,7 +177,7 @@ private:
     //***************************************************
     // or -> and or'
     //***************************************************
-    // firsts: INC, DEC, +, -, !, (, [, IDENT, NUMBER, STRING, TRUE, FALSE, NULL
+    // firsts: INC, DEC, +, -, !, ~, (, [, IDENT, NUMBER, STRING, TRUE, FALSE, NULL
     Result<ExpressionNode> parseOr();
 
     //***************************************************
@@ -184,22 +188,61 @@ private:
     Result<ExpressionNode> parseOrP(shared_ptr<ExpressionNode> lhs);
 
     //***************************************************
-    // and -> equality and'
+    // and -> bitOr and'
     //***************************************************
-    // firsts: INC, DEC, +, -, !, (, [, IDENT, NUMBER, STRING, TRUE, FALSE, NULL
+    // firsts: INC, DEC, +, -, !, ~, (, [, IDENT, NUMBER, STRING, TRUE, FALSE, NULL
     Result<ExpressionNode> parseAnd();
 
     //***************************************************
-    // and' -> AND equality and'
+    // and' -> AND bitOr and'
     //       | ϵ
     //***************************************************
     // firsts: AND
     Result<ExpressionNode> parseAndP(shared_ptr<ExpressionNode> lhs);
 
+    //***************************************************
+    // bitOr -> bitXor bitOr'
+    //***************************************************
+    // firsts: INC, DEC, +, -, !, ~, (, [, IDENT, NUMBER, STRING, TRUE, FALSE, NULL
+    Result<ExpressionNode> parseBitOr();
+
+    //***************************************************
+    // bitOr' -> | bitXor bitOr'
+    //        | ϵ
+    //***************************************************
+    // firsts: |
+    Result<ExpressionNode> parseBitOrP(shared_ptr<ExpressionNode> lhs);
+
+    //***************************************************
+    // bitXor -> bitAnd bitXor'
+    //***************************************************
+    // firsts: INC, DEC, +, -, !, ~, (, [, IDENT, NUMBER, STRING, TRUE, FALSE, NULL
+    Result<ExpressionNode> parseBitXor();
+
+    //***************************************************
+    // bitXor' -> ^ bitAnd bitXor'
+    //         | ϵ
+    //***************************************************
+    // firsts: ^
+    Result<ExpressionNode> parseBitXorP(shared_ptr<ExpressionNode> lhs);
+
+    //***************************************************
+    // bitAnd -> equality bitAnd'
+    //***************************************************
+    // firsts: INC, DEC, +, -, !, ~, (, [, IDENT, NUMBER, STRING, TRUE, FALSE, NULL
+    Result<ExpressionNode> parseBitAnd();
+
+    //***************************************************
+    // bitAnd' -> & equality bitAnd'
+    //         | ϵ
+    //***************************************************
+    // firsts: &
+    Result<ExpressionNode> parseBitAndP(shared_ptr<ExpressionNode> lhs);
+
     //***************************************************
     // equality -> relation equality'
     //***************************************************
-    // firsts: INC, DEC, +, -, !, (, [, IDENT, NUMBER, STRING, TRUE, FALSE, NULL
+    // firsts: INC, DEC, +, -, !, ~, (, [, IDENT, NUMBER, STRING, TRUE, FALSE, NULL
     Result<ExpressionNode> parseEquality();
 
     //***************************************************
@@ -211,25 +254,39 @@ private:
     Result<ExpressionNode> parseEqualityP(shared_ptr<ExpressionNode> lhs);
 
     //***************************************************
-    // relation -> addit relation'
+    // relation -> shift relation'
     //***************************************************
-    // firsts: INC, DEC, +, -, !, (, [, IDENT, NUMBER, STRING, TRUE, FALSE, NULL
+    // firsts: INC, DEC, +, -, !, ~, (, [, IDENT, NUMBER, STRING, TRUE, FALSE, NULL
     Result<ExpressionNode> parseRelation();
 
     //***************************************************
-    // relation' -> > addit relation'
-    //            | < addit relation'
-    //            | GE addit relation'
-    //            | LE addit relation'
+    // relation' -> > shift relation'
+    //            | < shift relation'
+    //            | GE shift relation'
+    //            | LE shift relation'
     //            | ϵ
     //***************************************************
     // firsts: >, <, GE, LE
     Result<ExpressionNode> parseRelationP(shared_ptr<ExpressionNode> lhs);
 
+    //***************************************************
+    // shift -> addit shift'
+    //***************************************************
+    // firsts: INC, DEC, +, -, !, ~, (, [, IDENT, NUMBER, STRING, TRUE, FALSE, NULL
+    Result<ExpressionNode> parseShift();
+
+    //***************************************************
+    // shift' -> SHL addit shift'
+    //        | SHR addit shift'
+    //        | ϵ
+    //***************************************************
+    // firsts: SHL, SHR
+    Result<ExpressionNode> parseShiftP(shared_ptr<ExpressionNode> lhs);
+
     //***************************************************
     // addit -> mult addit'
     //***************************************************
-    // firsts: INC, DEC, +, -, !, (, [, IDENT, NUMBER, STRING, TRUE, FALSE, NULL
+    // firsts: INC, DEC, +, -, !, ~, (, [, IDENT, NUMBER, STRING, TRUE, FALSE, NULL
     Result<ExpressionNode> parseAddit();
 
     //***************************************************
@@ -243,7 +300,7 @@ private:
     //***************************************************
     // mult -> unary mult'
     //***************************************************
-    // firsts: INC, DEC, +, -, !, (, [, IDENT, NUMBER, STRING, TRUE, FALSE, NULL
+    // firsts: INC, DEC, +, -, !, ~, (, [, IDENT, NUMBER, STRING, TRUE, FALSE, NULL
     Result<ExpressionNode> parseMult();
 
     //***************************************************
@@ -261,15 +318,16 @@ private:
     //        | + mult
     //        | - mult
     //        | ! mult
+    //        | ~ mult
     //        | post
     //***************************************************
-    // firsts: INC, DEC, +, -, !, (, [, IDENT, NUMBER, STRING, TRUE, FALSE, NULL
+    // firsts: INC, DEC, +, -, !, ~, (, [, IDENT, NUMBER, STRING, TRUE, FALSE, NULL
     Result<ExpressionNode> parseUnary();
 
     //***************************************************
     // argList -> assign argList'
     //***************************************************
-    // firsts: INC, DEC, +, -, !, (, [, IDENT, NUMBER, STRING, TRUE, FALSE, NULL
+    // firsts: INC, DEC, +, -, !, ~, (, [, IDENT, NUMBER, STRING, TRUE, FALSE, NULL
     Result<ArgListNode> parseArgList();
 
     //****************************************************
@@ -321,6 +379,9 @@ private:
     static set<int> argListFirsts;
     static set<int> assertFirsts;
     static set<int> assignFirsts;
+    static set<int> bitAndFirsts;
+    static set<int> bitOrFirsts;
+    static set<int> bitXorFirsts;
     static set<int> blockFirsts;
     static set<int> breakStmtFirsts;
     static set<int> classDeclFirsts;
@@ -342,12 +403,17 @@ private:
     static set<int> printStmtFirsts;
     static set<int> relationFirsts;
     static set<int> returnStmtFirsts;
+    static set<int> shiftFirsts;
     static set<int> unaryFirsts;
     static set<int> whileStmtFirsts;
+    static set<int> yieldStmtFirsts;
     static set<int> assignPFirsts;
 private:
     Tokenizer tokenizer;
     Token currentToken;
     bool hadError;
     int depth;
+
+    // set when the function being parsed contains a yield, which makes it a generator
+    bool sawYield;
 };
\ No newline at end of file
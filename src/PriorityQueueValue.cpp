@@ -0,0 +1,254 @@
+#include <vector>
+#include <algorithm>
+
+#include "PriorityQueueValue.h"
+#include "Values.h"
+#include "Error.h"
+#include "Environment.h"
+#include "Interpreter.h"
+#include "Utils.h"
+
+using std::shared_ptr;
+using std::vector;
+using std::make_shared;
+using std::string;
+using std::static_pointer_cast;
+
+#define error(msg, range) \
+    rangeError(msg, range, __FILE__, __LINE__)
+
+#define errorAt(msg, location, range) \
+    locationRangeError(msg, location, range, __FILE__, __LINE__)
+
+PriorityQueueValue::PriorityQueueValue(const shared_ptr<Value> &comparator, const Range &range):
+    Value(Type::priority_queue, range),
+    comparator(comparator)
+{
+}
+
+bool PriorityQueueValue::before(Interpreter &interpreter, const shared_ptr<Value> &a, const shared_ptr<Value> &b, const Range &range) const
+{
+    if (!comparator)
+    {
+        // push only lets in numbers or strings of one type
+        if (a->getType() == Value::Type::number)
+        {
+            return static_pointer_cast<NumberValue>(a)->getValue() < static_pointer_cast<NumberValue>(b)->getValue();
+        }
+        return static_pointer_cast<StringValue>(a)->view() < static_pointer_cast<StringValue>(b)->view();
+    }
+
+    auto result = interpreter.call(comparator, { a, b }, range);
+    if (!result)
+    {
+        return false;
+    }
+    if (result->getType() == Value::Type::number)
+    {
+        return static_pointer_cast<NumberValue>(result)->getValue() < 0;
+    }
+    return result->toBoolean();
+}
+
+bool PriorityQueueValue::push(Interpreter &interpreter, const shared_ptr<Value> &value, const Range &range)
+{
+    if (!comparator)
+    {
+        if (value->getType() != Value::Type::number && value->getType() != Value::Type::string_)
+        {
+            errorAt("PriorityQueue without a comparator only holds numbers or strings, but got " + value->typeAsString(), value->getRange().getStart(), range);
+            return false;
+        }
+        if (!heap.empty() && heap.front()->getType() != value->getType())
+        {
+            errorAt("PriorityQueue without a comparator expects values of one type, but got " + value->typeAsString() + " after " + heap.front()->typeAsString(), value->getRange().getStart(), range);
+            return false;
+        }
+    }
+
+    // std heaps keep the largest element on top, so compare in reverse
+    heap.push_back(value);
+    std::push_heap(heap.begin(), heap.end(),
+        [&](const shared_ptr<Value> &a, const shared_ptr<Value> &b) { return before(interpreter, b, a, range); });
+    return true;
+}
+
+shared_ptr<Value> PriorityQueueValue::pop(Interpreter &interpreter, const Range &range)
+{
+    if (heap.empty())
+    {
+        return nullptr;
+    }
+
+    std::pop_heap(heap.begin(), heap.end(),
+        [&](const shared_ptr<Value> &a, const shared_ptr<Value> &b) { return before(interpreter, b, a, range); });
+    shared_ptr<Value> value = std::move(heap.back());
+    heap.pop_back();
+    return value;
+}
+
+vector<shared_ptr<Value>> PriorityQueueValue::toVector(Interpreter &interpreter, const Range &range) const
+{
+    vector<shared_ptr<Value>> elements(heap);
+    std::stable_sort(elements.begin(), elements.end(),
+        [&](const shared_ptr<Value> &a, const shared_ptr<Value> &b) { return before(interpreter, a, b, range); });
+    return elements;
+}
+
+shared_ptr<Value> PriorityQueueValue::getMember(const string &name) const
+{
+    // builtins are registered on first use, like strings and arrays
+    if (members.empty())
+    {
+        const_cast<PriorityQueueValue *>(this)->registerBuiltins();
+    }
+    return Value::getMember(name);
+}
+
+void PriorityQueueValue::registerBuiltins()
+{
+    // push(values...) -> null
+    addMember("push", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(env);
+            for (const auto &arg : args)
+            {
+                if (!push(interpreter, arg, range))
+                {
+                    return nullptr;
+                }
+            }
+            return make_shared<NullValue>(range);
+        },
+        getRange()
+    ), true);
+
+    // pop() -> the value that comes first or null when empty
+    addMember("pop", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("pop() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            auto value = pop(interpreter, range);
+            return value ? value : make_shared<NullValue>(range);
+        },
+        getRange()
+    ), true);
+
+    // peek() -> the value that comes first or null when empty
+    addMember("peek", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("peek() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            return heap.empty() ? make_shared<NullValue>(range) : heap.front();
+        },
+        getRange()
+    ), true);
+
+    // length() -> number
+    addMember("length", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("length() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            return make_shared<NumberValue>(static_cast<double>(heap.size()), range);
+        },
+        getRange()
+    ), true);
+
+    // empty() -> boolean
+    addMember("empty", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("empty() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            return make_shared<BooleanValue>(heap.empty(), range);
+        },
+        getRange()
+    ), true);
+
+    // clear() -> null
+    addMember("clear", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("clear() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            heap.clear();
+            return make_shared<NullValue>(range);
+        },
+        getRange()
+    ), true);
+
+    // toArray() -> array in the order the values would be popped
+    addMember("toArray", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("toArray() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            return make_shared<ArrayValue>(toVector(interpreter, range), range);
+        },
+        getRange()
+    ), true);
+}
+
+string PriorityQueueValue::toString() const
+{
+    // the order of everything but the first value depends on the comparator,
+    // which can't be called from here
+    string result = "<PriorityQueue of " + std::to_string(heap.size());
+    if (!heap.empty())
+    {
+        result += ", next " + heap.front()->toString();
+    }
+    return result + ">";
+}
+
+bool PriorityQueueValue::toBoolean() const
+{
+    return !heap.empty();
+}
+
+string PriorityQueueValue::typeAsString() const
+{
+    return "PriorityQueue";
+}
+
+shared_ptr<Value> PriorityQueueValue::eq(const shared_ptr<NullValue> &other) const
+{
+    return make_shared<BooleanValue>(false, Range(getRange().getStart(), other->getRange().getEnd()));
+}
+
+shared_ptr<Value> PriorityQueueValue::ne(const shared_ptr<NullValue> &other) const
+{
+    return make_shared<BooleanValue>(true, Range(getRange().getStart(), other->getRange().getEnd()));
+}
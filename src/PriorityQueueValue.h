@@ -0,0 +1,53 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Value.h"
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+class Interpreter;
+
+// A binary heap that hands out the value that comes first. Without a
+// comparator the values must all be numbers or all strings and the smallest
+// comes first, with one cmp(a, b) returns a negative number or true when a
+// comes before b.
+class PriorityQueueValue : public Value
+{
+public:
+    PriorityQueueValue(const shared_ptr<Value> &comparator = nullptr, const Range &range = {});
+
+    void registerBuiltins();
+
+    // push and pop call back into the interpreter when there is a comparator,
+    // push reports an error and returns false if the value can't be ordered
+    bool push(Interpreter &interpreter, const shared_ptr<Value> &value, const Range &range = {});
+    shared_ptr<Value> pop(Interpreter &interpreter, const Range &range = {});
+
+    inline size_t length() const { return heap.size(); }
+
+    // the elements in the order they would be popped
+    vector<shared_ptr<Value>> toVector(Interpreter &interpreter, const Range &range = {}) const;
+
+    virtual shared_ptr<Value> getMember(const string &name) const override;
+
+    string toString() const override;
+    bool toBoolean() const override;
+
+    virtual string typeAsString() const override;
+
+public:
+    virtual shared_ptr<Value> eq(const shared_ptr<NullValue> &other) const override;
+    virtual shared_ptr<Value> ne(const shared_ptr<NullValue> &other) const override;
+
+private:
+    // true if a comes before b
+    bool before(Interpreter &interpreter, const shared_ptr<Value> &a, const shared_ptr<Value> &b, const Range &range) const;
+
+private:
+    shared_ptr<Value> comparator;
+    vector<shared_ptr<Value>> heap;
+};
@@ -0,0 +1,126 @@
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <signal.h>
+#include <sys/time.h>
+#include <vector>
+
+#include "Profiler.h"
+#include "CallStack.h"
+
+namespace Profiler
+{
+    std::string path;
+    std::atomic<unsigned> ticks(0);
+
+    // microseconds of CPU time between ticks
+    static const long INTERVAL = 1000;
+
+    static std::ofstream output;
+    static bool running = false;
+
+    // the ticks of each stack, keyed by its function ids followed by the
+    // source and position of the statement
+    static std::map<std::vector<uint64_t>, uint64_t> samples;
+    static std::vector<uint64_t> key;
+
+    // the sources of the statements sampled, each at its start
+    static std::vector<Location> sources;
+
+    static void tick(int)
+    {
+        ticks.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static uint64_t source(const Location &location)
+    {
+        for (size_t i = 0; i < sources.size(); ++i)
+        {
+            if (sources[i].sameSource(location))
+            {
+                return i;
+            }
+        }
+        sources.push_back(location.at(0));
+        return sources.size() - 1;
+    }
+
+    bool start()
+    {
+        output.open(path);
+        if (!output)
+        {
+            return false;
+        }
+
+        struct sigaction action = {};
+        action.sa_handler = &tick;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGPROF, &action, nullptr);
+
+        struct itimerval timer = {};
+        timer.it_interval.tv_usec = INTERVAL;
+        timer.it_value.tv_usec = INTERVAL;
+        setitimer(ITIMER_PROF, &timer, nullptr);
+
+        running = true;
+        return true;
+    }
+
+    bool stop()
+    {
+        if (!running)
+        {
+            return true;
+        }
+        running = false;
+
+        struct itimerval timer = {};
+        setitimer(ITIMER_PROF, &timer, nullptr);
+        signal(SIGPROF, SIG_IGN);
+
+        // positions on the same line are one stack
+        std::map<std::string, uint64_t> stacks;
+        for (const auto &sample : samples)
+        {
+            const auto &frames = sample.first;
+            std::string stack;
+            for (size_t i = 0; i + 2 < frames.size(); ++i)
+            {
+                stack += CallStack::name(static_cast<uint32_t>(frames[i])) + ";";
+            }
+
+            Location statement = sources[frames[frames.size() - 2]].at(frames.back());
+            std::string filename = statement.getFilename();
+            stack += (filename.empty() ? "" : filename + ":") + std::to_string(statement.getLine());
+            stacks[stack] += sample.second;
+        }
+
+        for (const auto &stack : stacks)
+        {
+            output << stack.first << " " << stack.second << "\n";
+        }
+        output.close();
+        samples.clear();
+        return static_cast<bool>(output);
+    }
+
+    void sample(const CallStack &stack, const Location &location)
+    {
+        unsigned count = ticks.exchange(0, std::memory_order_relaxed);
+        if (!running || count == 0)
+        {
+            return;
+        }
+
+        key.clear();
+        for (const auto &frame : stack.getFrames())
+        {
+            key.push_back(frame.function);
+        }
+        key.push_back(source(location));
+        key.push_back(location.getPos());
+        samples[key] += count;
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+
+class CallStack;
+class Location;
+
+// Samples where a script spends its CPU time, enabled with --profile=FILE.
+// A SIGPROF timer ticks every millisecond of CPU time the process uses, the
+// signal handler only counts the tick. The interpreter checks for ticks
+// after each statement it runs and hands the call stack and the
+// statement's location to sample(), which counts the ticks for that stack.
+// Statements nested in it have counted their own by then, so time spent in
+// a builtin or a compiled loop is counted at the statement that ran it.
+//
+// stop() writes the stacks in the collapsed format flamegraph tools read,
+// one line per stack: the functions called from the outermost in, then the
+// file and line of the statement, separated by ';', then the ticks counted.
+namespace Profiler
+{
+    // where stop() writes the stacks, set with --profile
+    extern std::string path;
+
+    // ticks not yet counted by sample()
+    extern std::atomic<unsigned> ticks;
+
+    // opens path and starts the timer, false if path can't be written
+    bool start();
+
+    // stops the timer and writes what was sampled, false if it couldn't be
+    // written
+    bool stop();
+
+    void sample(const CallStack &stack, const Location &location);
+}
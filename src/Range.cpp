@@ -21,9 +21,6 @@ Range::Range(const Location &start, const Location &end):
 
 Range::~Range()
 {
-    // No dynamic memory to release, but we can clear the locations
-    start = Location();
-    end = Location();
 }
 
 Range::Range(const Range &other):
@@ -65,12 +62,12 @@ Range &Range::operator=(Range &&other) noexcept
     return *this;
 }
 
-Location Range::getStart() const
+const Location& Range::getStart() const
 {
     return start;
 }
 
-Location Range::getEnd() const
+const Location& Range::getEnd() const
 {
     return end;
 }
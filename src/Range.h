@@ -22,8 +22,8 @@ public:
     Range& operator=(const Range& other);
     Range(Range&& other) noexcept;
     Range& operator=(Range&& other) noexcept;
-    Location getStart() const;
-    Location getEnd() const;
+    const Location& getStart() const;
+    const Location& getEnd() const;
     void setStart(const Location& start);
     void setEnd(const Location& end);
     bool operator==(const Range& other) const;
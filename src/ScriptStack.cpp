@@ -0,0 +1,227 @@
+#include <cctype>
+#include <cstdint>
+#include <exception>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include "ScriptStack.h"
+
+namespace ScriptStack
+{
+    size_t maxSize = 64 * 1024 * 1024;
+
+    // what is left below the last check for the native frames of one more
+    // call, the builtins it calls and reporting the overflow
+    static const size_t RESERVE = 256 * 1024;
+
+    static Bounds bounds = {nullptr, 0};
+
+    // the body run() hands to the new stack and what it threw
+    struct Pending
+    {
+        const std::function<void()> *body;
+        std::exception_ptr failure;
+    };
+    static Pending *pending = nullptr;
+
+    static void entry()
+    {
+        Pending *self = pending;
+        try
+        {
+            (*self->body)();
+        }
+        catch (...)
+        {
+            self->failure = std::current_exception();
+        }
+
+        // returning switches back to the caller through uc_link
+    }
+
+    size_t guardSize()
+    {
+        return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+
+    static size_t mapping(size_t size)
+    {
+        size_t page = guardSize();
+        return (size + page - 1) / page * page + page;
+    }
+
+    size_t mappedSize()
+    {
+        return mapping(maxSize);
+    }
+
+    size_t generatorMappedSize()
+    {
+        return mapping(maxSize < GENERATOR_SIZE ? maxSize : GENERATOR_SIZE);
+    }
+
+    // the thread's own stack, {nullptr, 0} if it can't be found
+    static Bounds nativeBounds()
+    {
+        pthread_attr_t attributes;
+        if (pthread_getattr_np(pthread_self(), &attributes) != 0)
+        {
+            return {nullptr, 0};
+        }
+
+        void *low = nullptr;
+        size_t size = 0;
+        int found = pthread_attr_getstack(&attributes, &low, &size);
+        pthread_attr_destroy(&attributes);
+        if (found != 0)
+        {
+            return {nullptr, 0};
+        }
+        return {static_cast<char *>(low), size};
+    }
+
+    // runs body on the stack it was called on, checking calls against that
+    // stack's size since it can't be set with --max-stack
+    static bool runNative(const std::function<void()> &body)
+    {
+        Bounds previousBounds = bounds;
+        Bounds native = nativeBounds();
+        if (!native.low)
+        {
+            return false;
+        }
+
+        bounds = native;
+        try
+        {
+            body();
+        }
+        catch (...)
+        {
+            bounds = previousBounds;
+            throw;
+        }
+        bounds = previousBounds;
+        return true;
+    }
+
+    bool run(const std::function<void()> &body)
+    {
+        size_t page = guardSize();
+        size_t size = mappedSize();
+        void *stack = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+        if (stack == MAP_FAILED)
+        {
+            // no room for it, the body makes do with the native stack
+            return runNative(body);
+        }
+
+        // the lowest page is a guard so running off the end crashes instead of
+        // overwriting whatever is mapped below
+        mprotect(stack, page, PROT_NONE);
+
+        ucontext_t caller;
+        ucontext_t context;
+        getcontext(&context);
+        context.uc_stack.ss_sp = stack;
+        context.uc_stack.ss_size = size;
+        context.uc_link = &caller;
+        makecontext(&context, &entry, 0);
+
+        Pending state = {&body, nullptr};
+        Pending *previousPending = pending;
+        Bounds previousBounds = bounds;
+        pending = &state;
+        bounds = {static_cast<char *>(stack) + page, size - page};
+
+        swapcontext(&caller, &context);
+
+        bounds = previousBounds;
+        pending = previousPending;
+        munmap(stack, size);
+
+        if (state.failure)
+        {
+            std::rethrow_exception(state.failure);
+        }
+        return true;
+    }
+
+    Bounds current()
+    {
+        return bounds;
+    }
+
+    void setCurrent(const Bounds &newBounds)
+    {
+        bounds = newBounds;
+    }
+
+    bool exhausted()
+    {
+        if (!bounds.low)
+        {
+            return false;
+        }
+
+        // stacks grow down, the frame of this call is as deep as the caller got
+        char *position = static_cast<char *>(__builtin_frame_address(0));
+        return position < bounds.low + RESERVE;
+    }
+
+    bool parseSize(const std::string &text, size_t &bytes)
+    {
+        size_t digits = 0;
+        while (digits < text.size() && std::isdigit(static_cast<unsigned char>(text[digits])))
+        {
+            digits++;
+        }
+        if (digits == 0 || digits > 12 || text.size() > digits + 1)
+        {
+            return false;
+        }
+
+        size_t unit = 1;
+        if (digits < text.size())
+        {
+            switch (std::toupper(static_cast<unsigned char>(text[digits])))
+            {
+            case 'K':
+                unit = 1024;
+                break;
+            case 'M':
+                unit = 1024 * 1024;
+                break;
+            case 'G':
+                unit = 1024 * 1024 * 1024;
+                break;
+            default:
+                return false;
+            }
+        }
+
+        size_t count = std::stoul(text.substr(0, digits));
+        if (count > SIZE_MAX / unit)
+        {
+            return false;
+        }
+        bytes = count * unit;
+        return true;
+    }
+
+    std::string formatSize(size_t bytes)
+    {
+        static const char units[] = {'G', 'M', 'K'};
+        for (int i = 0; i < 3; ++i)
+        {
+            size_t unit = static_cast<size_t>(1) << (30 - 10 * i);
+            if (bytes >= unit && bytes % unit == 0)
+            {
+                return std::to_string(bytes / unit) + units[i];
+            }
+        }
+        return std::to_string(bytes);
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+// Script code runs on a stack mapped from the heap rather than on the
+// thread's own, so how deep a script can recurse is set by --max-stack
+// instead of by the native stack the program was started with. Pages are
+// only backed once touched, a large limit costs nothing until it is used.
+namespace ScriptStack
+{
+    using std::size_t;
+
+    // bytes of stack script code may use, set with --max-stack
+    extern size_t maxSize;
+
+    // the most --max-stack accepts, far more than any script needs and
+    // little enough that rounding it up to pages can't overflow
+    const size_t MAX_SIZE = static_cast<size_t>(1) << 40;
+
+    // the most stack a generator's body may use, each suspended generator
+    // holds its stack's address space so it is kept well below maxSize
+    const size_t GENERATOR_SIZE = 8 * 1024 * 1024;
+
+    // Stacks are their size rounded up to whole pages with a guard page
+    // below, mappedSize() is the whole mapping of the script's stack and the
+    // usable part starts guardSize() bytes into it. generatorMappedSize() is
+    // the same for a generator's stack, the smaller of maxSize and
+    // GENERATOR_SIZE.
+    size_t mappedSize();
+    size_t generatorMappedSize();
+    size_t guardSize();
+
+    // Runs body on a stack of maxSize bytes, an exception it throws is
+    // rethrown here on the caller's stack. If that stack can't be mapped the
+    // body runs on the native stack, bounded by its size instead, and if the
+    // native stack's size can't be found either body isn't run and this
+    // returns false.
+    bool run(const std::function<void()> &body);
+
+    // The stack code is running on, [low, low + size). Generators switch to
+    // their own stacks and set it while their body runs.
+    struct Bounds
+    {
+        char *low;
+        size_t size;
+    };
+    Bounds current();
+    void setCurrent(const Bounds &bounds);
+
+    // true when so little of the current stack is left that starting another
+    // call could overflow it, false when not running on a known stack
+    bool exhausted();
+
+    // reads a size such as 65536, 512K, 64M or 1G, false if it isn't one or
+    // doesn't fit in a size_t
+    bool parseSize(const std::string &text, size_t &bytes);
+
+    // a size the way parseSize reads it, in the largest unit that divides it
+    std::string formatSize(size_t bytes);
+}
@@ -103,6 +103,19 @@ void SemanticErrorVisitor::visit(ReturnStatementNode *node)
     }
 }
 
+void SemanticErrorVisitor::visit(YieldNode *node)
+{
+    if (functionDepth == 0)
+    {
+        error("'yield' used outside of a function", node->getRange());
+    }
+
+    if (node->getExpression())
+    {
+        node->getExpression()->visit(this);
+    }
+}
+
 void SemanticErrorVisitor::visit(ForStatementNode *node)
 {
     loopDepth++;
@@ -17,6 +17,7 @@ public:
 public:
     virtual void visit(FuncDeclNode *node) override;
     virtual void visit(ReturnStatementNode *node) override;
+    virtual void visit(YieldNode *node) override;
     virtual void visit(ForStatementNode *node) override;
     virtual void visit(ForEachNode *node) override;
     virtual void visit(WhileNode *node) override;
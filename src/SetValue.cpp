@@ -0,0 +1,327 @@
+#include <vector>
+
+#include "SetValue.h"
+#include "Values.h"
+#include "Error.h"
+#include "Environment.h"
+#include "Utils.h"
+
+using std::shared_ptr;
+using std::vector;
+using std::make_shared;
+using std::string;
+using std::static_pointer_cast;
+
+#define error(msg, range) \
+    rangeError(msg, range, __FILE__, __LINE__)
+
+#define errorAt(msg, location, range) \
+    locationRangeError(msg, location, range, __FILE__, __LINE__)
+
+SetValue::SetValue(const Range &range):
+    Value(Type::set, range)
+{
+}
+
+bool SetValue::insert(const shared_ptr<Value> &value)
+{
+    if (!index.emplace(value, entries.size()).second)
+    {
+        return false;
+    }
+    entries.push_back(value);
+    return true;
+}
+
+bool SetValue::erase(const shared_ptr<Value> &value)
+{
+    auto it = index.find(value);
+    if (it == index.end())
+    {
+        return false;
+    }
+
+    entries[it->second] = nullptr;
+    index.erase(it);
+
+    // compact once most of the entries are erased ones
+    if (entries.size() > 16 && entries.size() > 2 * index.size())
+    {
+        size_t next = 0;
+        for (auto &entry : entries)
+        {
+            if (entry)
+            {
+                index[entry] = next;
+                entries[next++] = std::move(entry);
+            }
+        }
+        entries.resize(next);
+    }
+    return true;
+}
+
+void SetValue::clear()
+{
+    entries.clear();
+    index.clear();
+}
+
+vector<shared_ptr<Value>> SetValue::toVector() const
+{
+    vector<shared_ptr<Value>> elements;
+    elements.reserve(index.size());
+    for (const auto &entry : entries)
+    {
+        if (entry)
+        {
+            elements.push_back(entry);
+        }
+    }
+    return elements;
+}
+
+shared_ptr<Value> SetValue::getMember(const string &name) const
+{
+    // builtins are registered on first use, like strings and arrays
+    if (members.empty())
+    {
+        const_cast<SetValue *>(this)->registerBuiltins();
+    }
+    return Value::getMember(name);
+}
+
+void SetValue::registerBuiltins()
+{
+    // add(values...) -> true if any value was not in the set yet
+    addMember("add", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            bool added = false;
+            for (const auto &arg : args)
+            {
+                added = insert(arg) || added;
+            }
+            return make_shared<BooleanValue>(added, range);
+        },
+        getRange()
+    ), true);
+
+    // remove(value) -> true if the value was in the set
+    addMember("remove", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (args.size() != 1)
+            {
+                error("remove() expects exactly 1 argument, but got " + std::to_string(args.size()), range);
+                return nullptr;
+            }
+            return make_shared<BooleanValue>(erase(args[0]), range);
+        },
+        getRange()
+    ), true);
+
+    // contains(value) -> boolean
+    addMember("contains", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (args.size() != 1)
+            {
+                error("contains() expects exactly 1 argument, but got " + std::to_string(args.size()), range);
+                return nullptr;
+            }
+            return make_shared<BooleanValue>(contains(args[0]), range);
+        },
+        getRange()
+    ), true);
+
+    // union(other) -> new set with the elements of both sets
+    addMember("union", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (args.size() != 1 || args[0]->getType() != Value::Type::set)
+            {
+                errorAt("union() expects a set argument", range.getStart(), range);
+                return nullptr;
+            }
+
+            auto result = make_shared<SetValue>(range);
+            for (const auto &element : toVector())
+            {
+                result->insert(element);
+            }
+            for (const auto &element : static_pointer_cast<SetValue>(args[0])->toVector())
+            {
+                result->insert(element);
+            }
+            return result;
+        },
+        getRange()
+    ), true);
+
+    // intersection(other) -> new set with the elements in both sets
+    addMember("intersection", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (args.size() != 1 || args[0]->getType() != Value::Type::set)
+            {
+                errorAt("intersection() expects a set argument", range.getStart(), range);
+                return nullptr;
+            }
+
+            auto other = static_pointer_cast<SetValue>(args[0]);
+            auto result = make_shared<SetValue>(range);
+            for (const auto &element : toVector())
+            {
+                if (other->contains(element))
+                {
+                    result->insert(element);
+                }
+            }
+            return result;
+        },
+        getRange()
+    ), true);
+
+    // difference(other) -> new set with the elements that are not in other
+    addMember("difference", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (args.size() != 1 || args[0]->getType() != Value::Type::set)
+            {
+                errorAt("difference() expects a set argument", range.getStart(), range);
+                return nullptr;
+            }
+
+            auto other = static_pointer_cast<SetValue>(args[0]);
+            auto result = make_shared<SetValue>(range);
+            for (const auto &element : toVector())
+            {
+                if (!other->contains(element))
+                {
+                    result->insert(element);
+                }
+            }
+            return result;
+        },
+        getRange()
+    ), true);
+
+    // length() -> number
+    addMember("length", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("length() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            return make_shared<NumberValue>(static_cast<double>(length()), range);
+        },
+        getRange()
+    ), true);
+
+    // empty() -> boolean
+    addMember("empty", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("empty() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            return make_shared<BooleanValue>(index.empty(), range);
+        },
+        getRange()
+    ), true);
+
+    // clear() -> null
+    addMember("clear", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("clear() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            clear();
+            return make_shared<NullValue>(range);
+        },
+        getRange()
+    ), true);
+
+    // toArray() -> array in insertion order
+    addMember("toArray", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("toArray() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            return make_shared<ArrayValue>(toVector(), range);
+        },
+        getRange()
+    ), true);
+}
+
+string SetValue::toString() const
+{
+    string result = "Set{";
+    bool first = true;
+    for (const auto &entry : entries)
+    {
+        if (!entry)
+        {
+            continue;
+        }
+        if (!first)
+        {
+            result += ", ";
+        }
+        result += entry->toString();
+        first = false;
+    }
+    result += "}";
+    return result;
+}
+
+bool SetValue::toBoolean() const
+{
+    return !index.empty();
+}
+
+string SetValue::typeAsString() const
+{
+    return "Set";
+}
+
+shared_ptr<Value> SetValue::eq(const shared_ptr<NullValue> &other) const
+{
+    return make_shared<BooleanValue>(false, Range(getRange().getStart(), other->getRange().getEnd()));
+}
+
+shared_ptr<Value> SetValue::ne(const shared_ptr<NullValue> &other) const
+{
+    return make_shared<BooleanValue>(true, Range(getRange().getStart(), other->getRange().getEnd()));
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <unordered_map>
+
+#include "Value.h"
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+// A hash set of values that remembers insertion order. Numbers, strings,
+// booleans and null are compared by value, everything else by identity
+// (see Value::hash and Value::equals).
+class SetValue : public Value
+{
+public:
+    SetValue(const Range &range = {});
+
+    void registerBuiltins();
+
+    // both return false if nothing changed
+    bool insert(const shared_ptr<Value> &value);
+    bool erase(const shared_ptr<Value> &value);
+
+    inline bool contains(const shared_ptr<Value> &value) const { return index.find(value) != index.end(); }
+    inline size_t length() const { return index.size(); }
+    void clear();
+
+    // the elements in insertion order
+    vector<shared_ptr<Value>> toVector() const;
+
+    virtual shared_ptr<Value> getMember(const string &name) const override;
+
+    string toString() const override;
+    bool toBoolean() const override;
+
+    virtual string typeAsString() const override;
+
+public:
+    virtual shared_ptr<Value> eq(const shared_ptr<NullValue> &other) const override;
+    virtual shared_ptr<Value> ne(const shared_ptr<NullValue> &other) const override;
+
+private:
+    struct Hash
+    {
+        size_t operator()(const shared_ptr<Value> &value) const { return value->hash(); }
+    };
+
+    struct Equal
+    {
+        bool operator()(const shared_ptr<Value> &a, const shared_ptr<Value> &b) const { return a->equals(*b); }
+    };
+
+private:
+    // entries holds the elements in insertion order with nullptr in place of
+    // erased ones, index maps each element to its position in entries
+    vector<shared_ptr<Value>> entries;
+    std::unordered_map<shared_ptr<Value>, size_t, Hash, Equal> index;
+};
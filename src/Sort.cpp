@@ -0,0 +1,20 @@
+#include "Sort.h"
+
+namespace Sort
+{
+    size_t parallelThreshold = 1 << 20;
+
+    size_t runCount(size_t count)
+    {
+        if (parallelThreshold == 0 || count < parallelThreshold)
+        {
+            return 1;
+        }
+
+        // keep every run at least half the threshold so small ranges
+        // are not split into runs that cost more to start than to sort
+        size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        size_t maxRuns = std::max<size_t>(count / std::max<size_t>(parallelThreshold / 2, 1), 1);
+        return std::min(threads, maxRuns);
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+// Sorting shared by arrays and typed arrays. Ranges with at least
+// parallelThreshold elements are split into one run per hardware thread, the
+// runs are sorted concurrently and then merged pairwise, also concurrently.
+namespace Sort
+{
+    using std::size_t;
+
+    // 0 disables parallel sorting, set with --parallel-sort-threshold
+    extern size_t parallelThreshold;
+
+    // number of runs to sort a range of count elements in, 1 means sort serially
+    size_t runCount(size_t count);
+
+    // Sorts [first, last) with comp. The result is the same as std::sort, so
+    // it is only stable if comp breaks ties itself.
+    template <typename It, typename Compare>
+    void sort(It first, It last, Compare comp)
+    {
+        size_t count = static_cast<size_t>(std::distance(first, last));
+        size_t runs = runCount(count);
+        if (runs < 2)
+        {
+            std::sort(first, last, comp);
+            return;
+        }
+
+        std::vector<It> bounds;
+        bounds.reserve(runs + 1);
+        for (size_t i = 0; i < runs; ++i)
+        {
+            bounds.push_back(first + static_cast<std::ptrdiff_t>(count * i / runs));
+        }
+        bounds.push_back(last);
+
+        std::vector<std::thread> threads;
+        threads.reserve(runs);
+        for (size_t i = 0; i < runs; ++i)
+        {
+            threads.emplace_back([&, i]() { std::sort(bounds[i], bounds[i + 1], comp); });
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+
+        // merge neighbouring runs until one is left, the merges in a round
+        // touch disjoint ranges so they run side by side
+        for (size_t width = 1; width < runs; width *= 2)
+        {
+            threads.clear();
+            for (size_t i = 0; i + width < runs; i += 2 * width)
+            {
+                It begin = bounds[i];
+                It middle = bounds[i + width];
+                It end = bounds[std::min(i + 2 * width, runs)];
+                threads.emplace_back([begin, middle, end, &comp]() { std::inplace_merge(begin, middle, end, comp); });
+            }
+            for (auto &thread : threads)
+            {
+                thread.join();
+            }
+        }
+    }
+}
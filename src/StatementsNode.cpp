@@ -54,6 +54,11 @@ const vector<shared_ptr<StatementNode>> &StatementsNode::getStatements() const
     return statements;
 }
 
+void StatementsNode::setStatements(vector<shared_ptr<StatementNode>> statements)
+{
+    this->statements = std::move(statements);
+}
+
 void StatementsNode::visit(Visitor *visitor)
 {
     visitor->visit(this);
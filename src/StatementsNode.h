@@ -33,6 +33,7 @@ public:
     int getStatementCount() const;
 
     const vector<shared_ptr<StatementNode>> &getStatements() const;
+    void setStatements(vector<shared_ptr<StatementNode>> statements);
 
     void visit(Visitor *visitor) override;
 private:
@@ -2,6 +2,8 @@
 #include <vector>
 #include <memory>
 #include <regex>
+#include <algorithm>
+#include <cmath>
 
 #include "StringValue.h"
 #include "Error.h"
@@ -16,6 +18,8 @@ using std::make_shared;
 using std::static_pointer_cast;
 using std::regex;
 
+static const char *WHITESPACE = " \t\n\r\f\v";
+
 #define error(msg, range) \
     rangeError(msg, range, __FILE__, __LINE__)
 
@@ -23,17 +27,29 @@ using std::regex;
     locationRangeError(msg, location, range, __FILE__, __LINE__)
 
 StringValue::StringValue(char c, const Range &range):
-    Value(Type::string_, range), value(1, c)
+    Value(Type::string_, range),
+    buffer(make_shared<string>(1, c)),
+    offset(0),
+    size(1)
 {
     //std::cout << "StringValue constructor called with char: " << c << std::endl; // Debug output
-    registerBuiltins();
 }
 
 StringValue::StringValue(const string &value, const Range &range):
-    Value(Type::string_, range), value(value)
+    Value(Type::string_, range),
+    buffer(make_shared<string>(value)),
+    offset(0),
+    size(value.length())
 {
     //std::cout << "StringValue constructor called with value: " << value << std::endl; // Debug output
-    registerBuiltins();
+}
+
+StringValue::StringValue(const shared_ptr<string> &buffer, size_t offset, size_t size, const Range &range):
+    Value(Type::string_, range),
+    buffer(buffer),
+    offset(offset),
+    size(size)
+{
 }
 
 shared_ptr<StringValue> StringValue::create(const string &value, const Range &range)
@@ -47,6 +63,82 @@ StringValue::~StringValue()
     //std::cout << "StringValue destructor called for value: " << value << std::endl;
 }
 
+const string &StringValue::getValue() const
+{
+    // A view into a larger buffer gets its own copy the first time the
+    // contents are needed as a whole string
+    if (offset != 0 || buffer->length() != size)
+    {
+        buffer = make_shared<string>(*buffer, offset, size);
+        offset = 0;
+    }
+    return *buffer;
+}
+
+void StringValue::setValue(const string &v)
+{
+    buffer = make_shared<string>(v);
+    offset = 0;
+    size = v.length();
+}
+
+void StringValue::append(const string &suffix)
+{
+    if (offset + size != buffer->length())
+    {
+        auto copy = make_shared<string>();
+        copy->reserve((size + suffix.length()) * 2);
+        copy->append(*buffer, offset, size);
+        buffer = copy;
+        offset = 0;
+    }
+    buffer->append(suffix);
+    size += suffix.length();
+}
+
+shared_ptr<StringValue> StringValue::substring(size_t start, size_t count, const Range &range) const
+{
+    start = std::min(start, size);
+    count = std::min(count, size - start);
+
+    // Short strings are cheaper to copy than to share, and a small piece of
+    // a large buffer gets its own copy so it doesn't keep the rest alive
+    bool share = count >= MIN_VIEW_LENGTH &&
+        (buffer->length() <= MAX_SHARED_PARENT || count * 8 >= buffer->length());
+    if (!share)
+    {
+        return make_shared<StringValue>(string(view().substr(start, count)), range);
+    }
+
+    return shared_ptr<StringValue>(new StringValue(buffer, offset + start, count, range));
+}
+
+shared_ptr<Value> StringValue::getMember(const string &name) const
+{
+    // most strings never have a method called on them, so the builtins are
+    // only registered the first time a member is looked up
+    if (members.empty())
+    {
+        const_cast<StringValue *>(this)->registerBuiltins();
+    }
+    return Value::getMember(name);
+}
+
+shared_ptr<Value> StringValue::concat(std::string_view suffix, const Range &range) const
+{
+    if (offset + size == buffer->length())
+    {
+        buffer->append(suffix);
+        return shared_ptr<StringValue>(new StringValue(buffer, offset, size + suffix.length(), range));
+    }
+
+    auto copy = make_shared<string>();
+    copy->reserve((size + suffix.length()) * 2);
+    copy->append(*buffer, offset, size);
+    copy->append(suffix);
+    return shared_ptr<StringValue>(new StringValue(copy, 0, copy->length(), range));
+}
+
 void StringValue::registerBuiltins()
 {
     // length() -> number
@@ -60,7 +152,7 @@ void StringValue::registerBuiltins()
                 errorAt("length() does not take any arguments", args[0]->getRange().getStart(), range);
                 return nullptr;
             }
-            return make_shared<NumberValue>(static_cast<double>(this->value.length()), range);
+            return make_shared<NumberValue>(static_cast<double>(length()), range);
         },
         getRange()
     ), true);
@@ -76,7 +168,7 @@ void StringValue::registerBuiltins()
                 errorAt("empty() does not take any arguments", args[0]->getRange().getStart(), range);
                 return nullptr;
             }
-            return make_shared<BooleanValue>(this->value.empty(), range);
+            return make_shared<BooleanValue>(isEmpty(), range);
         },
         getRange()
     ), true);
@@ -104,18 +196,52 @@ void StringValue::registerBuiltins()
                 delimiter = static_pointer_cast<StringValue>(args[0])->getValue();
             }
             vector<shared_ptr<Value>> parts;
+            std::string_view text = view();
             size_t pos = 0, found;
-            while ((found = this->value.find(delimiter, pos)) != string::npos)
+            while ((found = text.find(delimiter, pos)) != string::npos)
             {
-                parts.push_back(make_shared<StringValue>(this->value.substr(pos, found - pos), range));
+                parts.push_back(substring(pos, found - pos, range));
                 pos = found + delimiter.length();
             }
-            parts.push_back(make_shared<StringValue>(this->value.substr(pos), range));
+            parts.push_back(substring(pos, size - pos, range));
             return make_shared<ArrayValue>(parts, range);
         },
         getRange()
     ), true);
 
+    // splitIter([delimiter]) -> iterator over the same parts as split(), found as needed
+    addMember("splitIter", make_shared<BuiltinFunctionValue>(
+    [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            string delimiter = " ";
+            if (args.size() > 1)
+            {
+                error("splitIter() expects at most 1 argument, but got " + std::to_string(args.size()), range);
+                return nullptr;
+            }
+            if (args.size() == 1)
+            {
+                if (args[0]->getType() != Value::Type::string_)
+                {
+                    error("splitIter() expects a string argument, but got " + args[0]->typeAsString(), range);
+                    return nullptr;
+                }
+
+                delimiter = static_pointer_cast<StringValue>(args[0])->getValue();
+            }
+            if (delimiter.empty())
+            {
+                error("splitIter() delimiter must not be empty", range);
+                return nullptr;
+            }
+            // the iterator holds a view of this string, not the string itself
+            return make_shared<SplitIterator>(substring(0, size, range), delimiter, range);
+        },
+        getRange()
+    ), true);
+
     // lower() -> string
     addMember("lower", make_shared<BuiltinFunctionValue>(
     [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
@@ -128,7 +254,7 @@ void StringValue::registerBuiltins()
                 return nullptr;
             }
 
-            string lowerValue = value;
+            string lowerValue(view());
             for (char &c : lowerValue)
             {
                 c = static_cast<char>(tolower(c));
@@ -150,7 +276,7 @@ void StringValue::registerBuiltins()
                 return nullptr;
             }
 
-            string upperValue = value;
+            string upperValue(view());
             for (char &c : upperValue)
             {
                 c = static_cast<char>(toupper(c));
@@ -172,22 +298,22 @@ void StringValue::registerBuiltins()
                 return nullptr;
             }
 
-            if (value.empty())
+            if (isEmpty())
             {
                 // Return empty array for empty string
                 return make_shared<ArrayValue>(vector<shared_ptr<Value>>(), range);
             }
-            else if (value.length() == 1)
+            else if (length() == 1)
             {
                 // Return single number for single character
-                return make_shared<NumberValue>(static_cast<double>(static_cast<unsigned char>(value[0])), range);
+                return make_shared<NumberValue>(static_cast<double>(static_cast<unsigned char>(getCharAt(0))), range);
             }
             else
             {
                 // Return array of char codes for multi-character string
                 vector<shared_ptr<Value>> charCodes;
-                charCodes.reserve(value.length());
-                for (char c : value)
+                charCodes.reserve(length());
+                for (char c : view())
                 {
                     charCodes.emplace_back(make_shared<NumberValue>(static_cast<double>(static_cast<unsigned char>(c)), range));
                 }
@@ -214,8 +340,8 @@ void StringValue::registerBuiltins()
                 return nullptr;
             }
 
-            const string &substring = static_pointer_cast<StringValue>(args[0])->getValue();
-            size_t pos = value.find(substring);
+            std::string_view substring = static_pointer_cast<StringValue>(args[0])->view();
+            size_t pos = view().find(substring);
             if (pos == string::npos)
             {
                 return make_shared<NullValue>(range); // Not found
@@ -239,7 +365,7 @@ void StringValue::registerBuiltins()
             // Check if the string can be converted to a number
             try
             {
-                stod(value); // Try to convert to double
+                stod(getValue()); // Try to convert to double
                 return make_shared<BooleanValue>(true, range);
             }
             catch (const std::invalid_argument&)
@@ -261,11 +387,11 @@ void StringValue::registerBuiltins()
                 return nullptr;
             }
 
-            string strippedValue = value;
             // Remove leading and trailing whitespace
-            strippedValue.erase(0, strippedValue.find_first_not_of(" \t\n\r\f\v"));
-            strippedValue.erase(strippedValue.find_last_not_of(" \t\n\r\f\v") + 1);
-            return make_shared<StringValue>(strippedValue, range);
+            std::string_view text = view();
+            size_t start = std::min(text.find_first_not_of(WHITESPACE), size);
+            size_t end = text.find_last_not_of(WHITESPACE) + 1;
+            return substring(start, end > start ? end - start : 0, range);
         }
     ), true);
 
@@ -281,10 +407,8 @@ void StringValue::registerBuiltins()
                 return nullptr;
             }
 
-            string rstrippedValue = value;
             // Remove trailing whitespace
-            rstrippedValue.erase(rstrippedValue.find_last_not_of(" \t\n\r\f\v") + 1);
-            return make_shared<StringValue>(rstrippedValue, range);
+            return substring(0, view().find_last_not_of(WHITESPACE) + 1, range);
         }
     ), true);
 
@@ -300,10 +424,9 @@ void StringValue::registerBuiltins()
                 return nullptr;
             }
 
-            string lstrippedValue = value;
             // Remove leading whitespace
-            lstrippedValue.erase(0, lstrippedValue.find_first_not_of(" \t\n\r\f\v"));
-            return make_shared<StringValue>(lstrippedValue, range);
+            size_t start = std::min(view().find_first_not_of(WHITESPACE), size);
+            return substring(start, size - start, range);
         }
     ), true);
 
@@ -325,8 +448,8 @@ void StringValue::registerBuiltins()
                 return nullptr;
             }
 
-            const string &prefix = static_pointer_cast<StringValue>(args[0])->getValue();
-            return make_shared<BooleanValue>(value.rfind(prefix, 0) == 0, range);
+            std::string_view prefix = static_pointer_cast<StringValue>(args[0])->view();
+            return make_shared<BooleanValue>(view().substr(0, prefix.length()) == prefix, range);
         }
     ), true);
 
@@ -348,8 +471,8 @@ void StringValue::registerBuiltins()
                 return nullptr;
             }
 
-            const string &suffix = static_pointer_cast<StringValue>(args[0])->getValue();
-            return make_shared<BooleanValue>(value.length() >= suffix.length() && value.compare(value.length() - suffix.length(), suffix.length(), suffix) == 0, range);
+            std::string_view suffix = static_pointer_cast<StringValue>(args[0])->view();
+            return make_shared<BooleanValue>(size >= suffix.length() && view().substr(size - suffix.length()) == suffix, range);
         }
     ), true);
 
@@ -371,8 +494,8 @@ void StringValue::registerBuiltins()
                 return nullptr;
             }
 
-            const string &substring = static_pointer_cast<StringValue>(args[0])->getValue();
-            return make_shared<BooleanValue>(value.find(substring) != string::npos, range);
+            std::string_view substring = static_pointer_cast<StringValue>(args[0])->view();
+            return make_shared<BooleanValue>(view().find(substring) != string::npos, range);
         }
     ), true);
 
@@ -396,19 +519,61 @@ void StringValue::registerBuiltins()
 
             const string &pattern = static_pointer_cast<StringValue>(args[0])->getValue();
             regex regexPattern(pattern);
-            return make_shared<BooleanValue>(regex_match(value, regexPattern), range);
+            std::string_view text = view();
+            return make_shared<BooleanValue>(regex_match(text.begin(), text.end(), regexPattern), range);
+        }
+    ), true);
+
+    // slice(start, end) -> string
+    addMember("slice", make_shared<BuiltinFunctionValue>(
+    [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (args.empty() || args.size() > 2)
+            {
+                error("slice() expects 1 or 2 arguments, but got " + std::to_string(args.size()), range);
+                return nullptr;
+            }
+
+            double bounds[2] = { 0, static_cast<double>(size) };
+            for (size_t i = 0; i < args.size(); ++i)
+            {
+                if (args[i]->getType() != Value::Type::number)
+                {
+                    errorAt("slice() expects number arguments, but got " + args[i]->typeAsString(), args[i]->getRange().getStart(), range);
+                    return nullptr;
+                }
+
+                // negative indices count back from the end of the string
+                double index = static_pointer_cast<NumberValue>(args[i])->getValue();
+                if (!std::isfinite(index))
+                {
+                    errorAt("slice() expects finite number arguments, but got " + args[i]->toString(), args[i]->getRange().getStart(), range);
+                    return nullptr;
+                }
+                if (index < 0)
+                {
+                    index += static_cast<double>(size);
+                }
+                bounds[i] = std::clamp(index, 0.0, static_cast<double>(size));
+            }
+
+            size_t start = static_cast<size_t>(bounds[0]);
+            size_t end = static_cast<size_t>(bounds[1]);
+            return substring(start, end > start ? end - start : 0, range);
         }
     ), true);
 }
 
 string StringValue::toString() const
 {
-    return value;
+    return string(view());
 }
 
 bool StringValue::toBoolean() const
 {
-    return !value.empty();
+    return size != 0;
 }
 
 string StringValue::typeAsString() const
@@ -416,44 +581,54 @@ string StringValue::typeAsString() const
     return "string";
 }
 
+size_t StringValue::hash() const
+{
+    return std::hash<std::string_view>()(view());
+}
+
+bool StringValue::equals(const Value &other) const
+{
+    return other.getType() == Type::string_ && view() == static_cast<const StringValue &>(other).view();
+}
+
 shared_ptr<Value> StringValue::add(const shared_ptr<NumberValue> &other) const
 {
-    return make_shared<StringValue>(value + other->toString(), Range(getRange().getStart(), other->getRange().getEnd()));
+    return concat(other->toString(), Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
 shared_ptr<Value> StringValue::add(const shared_ptr<StringValue> &other) const
 {
-    return make_shared<StringValue>(value + other->getValue(), Range(getRange().getStart(), other->getRange().getEnd()));
+    return concat(other->view(), Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
 shared_ptr<Value> StringValue::add(const shared_ptr<BooleanValue> &other) const
 {
-    return make_shared<StringValue>(value + (other->getValue() ? "true" : "false"), Range(getRange().getStart(), other->getRange().getEnd()));
+    return concat(other->getValue() ? "true" : "false", Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
 shared_ptr<Value> StringValue::add(const shared_ptr<NullValue> &other) const
 {
-    return make_shared<StringValue>(value + other->toString(), Range(getRange().getStart(), other->getRange().getEnd()));
+    return concat(other->toString(), Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
 shared_ptr<Value> StringValue::add(const shared_ptr<ArrayValue> &other) const
 {
-    return make_shared<StringValue>(value + other->toString(), Range(getRange().getStart(), other->getRange().getEnd()));
+    return concat(other->toString(), Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
 shared_ptr<Value> StringValue::add(const shared_ptr<ClassValue> &other) const
 {
-    return make_shared<StringValue>(value + other->toString(), Range(getRange().getStart(), other->getRange().getEnd()));
+    return concat(other->toString(), Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
 shared_ptr<Value> StringValue::add(const shared_ptr<ObjectValue> &other) const
 {
-    return make_shared<StringValue>(value + other->toString(), Range(getRange().getStart(), other->getRange().getEnd()));
+    return concat(other->toString(), Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
 shared_ptr<Value> StringValue::eq(const shared_ptr<StringValue> &other) const
 {
-    return make_shared<BooleanValue>(value == other->getValue(), Range(getRange().getStart(), other->getRange().getEnd()));
+    return make_shared<BooleanValue>(view() == other->view(), Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
 shared_ptr<Value> StringValue::eq(const shared_ptr<NumberValue> &other) const
@@ -473,7 +648,7 @@ shared_ptr<Value> StringValue::eq(const shared_ptr<NullValue> &other) const
 
 shared_ptr<Value> StringValue::ne(const shared_ptr<StringValue> &other) const
 {
-    return make_shared<BooleanValue>(value != other->getValue(), Range(getRange().getStart(), other->getRange().getEnd()));
+    return make_shared<BooleanValue>(view() != other->view(), Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
 shared_ptr<Value> StringValue::ne(const shared_ptr<NumberValue> &other) const
@@ -493,20 +668,20 @@ shared_ptr<Value> StringValue::ne(const shared_ptr<NullValue> &other) const
 
 shared_ptr<Value> StringValue::lt(const shared_ptr<StringValue> &other) const
 {
-    return make_shared<BooleanValue>(value < other->getValue(), Range(getRange().getStart(), other->getRange().getEnd()));
+    return make_shared<BooleanValue>(view() < other->view(), Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
 shared_ptr<Value> StringValue::le(const shared_ptr<StringValue> &other) const
 {
-    return make_shared<BooleanValue>(value <= other->getValue(), Range(getRange().getStart(), other->getRange().getEnd()));
+    return make_shared<BooleanValue>(view() <= other->view(), Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
 shared_ptr<Value> StringValue::gt(const shared_ptr<StringValue> &other) const
 {
-    return make_shared<BooleanValue>(value > other->getValue(), Range(getRange().getStart(), other->getRange().getEnd()));
+    return make_shared<BooleanValue>(view() > other->view(), Range(getRange().getStart(), other->getRange().getEnd()));
 }
 
 shared_ptr<Value> StringValue::ge(const shared_ptr<StringValue> &other) const
 {
-    return make_shared<BooleanValue>(value >= other->getValue(), Range(getRange().getStart(), other->getRange().getEnd()));
+    return make_shared<BooleanValue>(view() >= other->view(), Range(getRange().getStart(), other->getRange().getEnd()));
 }
\ No newline at end of file
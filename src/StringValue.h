@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string_view>
+
 #include "Value.h"
 
 class StringValue : public Value
@@ -14,17 +16,31 @@ public:
 
     void registerBuiltins();
 
-    inline const string &getValue() const { return value; }
-    inline void setValue(const string &v) { value = v; }
-    inline char getCharAt(int index) const { return value[index]; }
-    inline size_t length() const { return value.length(); }
-    inline bool isEmpty() const { return value.empty(); }
+    const string &getValue() const;
+    void setValue(const string &v);
+    inline std::string_view view() const { return std::string_view(buffer->data() + offset, size); }
+    inline char getCharAt(int index) const { return (*buffer)[offset + index]; }
+    inline size_t length() const { return size; }
+    inline bool isEmpty() const { return size == 0; }
+
+    // Appends in place. Only valid when this value is not shared with
+    // another variable, the interpreter checks that before calling it.
+    void append(const string &suffix);
+
+    // Returns count characters starting at start. Large enough pieces share
+    // this string's buffer instead of copying it.
+    shared_ptr<StringValue> substring(size_t start, size_t count, const Range &range = {}) const;
+
+    virtual shared_ptr<Value> getMember(const string &name) const override;
 
     string toString() const override;
     bool toBoolean() const override; // Override toBoolean for string values
 
     virtual string typeAsString() const override;
 
+    virtual size_t hash() const override;
+    virtual bool equals(const Value &other) const override;
+
 public:
     virtual shared_ptr<Value> add(const shared_ptr<NumberValue> &other) const override;
     virtual shared_ptr<Value> add(const shared_ptr<StringValue> &other) const override;
@@ -53,5 +69,25 @@ public:
     virtual shared_ptr<Value> ge(const shared_ptr<StringValue> &other) const override;
 
 private:
-    string value;
-};
\ No newline at end of file
+    StringValue(const shared_ptr<string> &buffer, size_t offset, size_t size, const Range &range);
+
+    // Returns this + suffix. When this value owns the end of its buffer the
+    // suffix is appended to the shared buffer instead of copying the prefix.
+    shared_ptr<Value> concat(std::string_view suffix, const Range &range) const;
+
+private:
+    // views shorter than this are copied instead of shared
+    static constexpr size_t MIN_VIEW_LENGTH = 16;
+
+    // buffers larger than this are only shared by views covering at least
+    // an eighth of them
+    static constexpr size_t MAX_SHARED_PARENT = 64 * 1024;
+
+    // Buffer shared between a string, the strings built from it with + and
+    // the substrings taken from it. Each value only sees the 'size' bytes at
+    // 'offset'. Bytes that are visible to some value are never modified, so
+    // appending past the end is invisible to the others.
+    mutable shared_ptr<string> buffer;
+    mutable size_t offset;
+    size_t size;
+};
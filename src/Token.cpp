@@ -47,9 +47,12 @@ string Token::tokenTypeToString(int type)
         case OR:            return "operator (||)";
         case PLUS_EQUAL:    return "operator (+=)";
         case RETURN:        return "keyword (return)";
+        case SHL:           return "operator (<<)";
+        case SHR:           return "operator (>>)";
         case STRING:        return "string";
         case TRUE:          return "keyword (true)";
         case WHILE:         return "keyword (while)";
+        case YIELD:         return "keyword (yield)";
         default:
         {
             if (0 < type && type < 256)
@@ -53,9 +53,12 @@ public:
         OR,
         PLUS_EQUAL,
         RETURN,
+        SHL,
+        SHR,
         STRING,
         TRUE,
-        WHILE
+        WHILE,
+        YIELD
     };
 
     static string tokenTypeToString(int type);
@@ -69,7 +69,9 @@ Token Tokenizer::lex()
         c == '[' ||
         c == ']' ||
         c == '.' ||
-        c == '?')
+        c == '?' ||
+        c == '^' ||
+        c == '~')
     {
         advance();
         return Token(static_cast<int>(c), Range(start, location), c);
@@ -107,6 +109,11 @@ Token Tokenizer::lex()
             advance();
             return Token(Token::LE, Range(start, location), "<=");
         }
+        else if (peek() == '<')
+        {
+            advance();
+            return Token(Token::SHL, Range(start, location), "<<");
+        }
         return Token(static_cast<int>(c), Range(start, location), c);
     }
 
@@ -118,6 +125,11 @@ Token Tokenizer::lex()
             advance();
             return Token(Token::GE, Range(start, location), ">=");
         }
+        else if (peek() == '>')
+        {
+            advance();
+            return Token(Token::SHR, Range(start, location), ">>");
+        }
         return Token(static_cast<int>(c), Range(start, location), c);
     }
 
@@ -317,6 +329,7 @@ Token Tokenizer::lex()
         if (identifier == "return") return Token(Token::RETURN, Range(start, location), identifier);
         if (identifier == "true") return Token(Token::TRUE, Range(start, location), identifier);
         if (identifier == "while") return Token(Token::WHILE, Range(start, location), identifier);
+        if (identifier == "yield") return Token(Token::YIELD, Range(start, location), identifier);
 
         //-----------------------------------------------------------
         // identifiers
@@ -0,0 +1,403 @@
+#include "TypeInferenceVisitor.h"
+#include "Nodes.h"
+#include "Token.h"
+#include "Utils.h"
+
+using std::set;
+using std::string;
+
+namespace
+{
+// Collects every name a nested function or class uses, any of the
+// enclosing function's locals among them may be changed by it
+class UsedNames : public Visitor
+{
+public:
+    set<string> names;
+
+    virtual void visitAllChildren(Node *node) override
+    {
+        node->visit(this);
+    }
+
+    virtual void visit(VarExprNode *node) override
+    {
+        names.insert(node->getName());
+    }
+
+    virtual void visit(DeleteNode *node) override
+    {
+        names.insert(node->getName());
+    }
+
+    virtual void visit(VarDeclNode *node) override
+    {
+        if (node->getExpr())
+        {
+            node->getExpr()->visit(this);
+        }
+    }
+
+    virtual void visit(ReturnStatementNode *node) override
+    {
+        if (node->getExpression())
+        {
+            node->getExpression()->visit(this);
+        }
+    }
+};
+}
+
+TypeInferenceVisitor::TypeInferenceVisitor():
+    function(nullptr),
+    imports(false)
+{
+}
+
+void TypeInferenceVisitor::visitAllChildren(Node *node)
+{
+    function = nullptr;
+    node->visit(this);
+}
+
+void TypeInferenceVisitor::visit(FuncDeclNode *node)
+{
+    if (!function)
+    {
+        analyze(node);
+
+        // then the functions nested in it, each on its own
+        Visitor::visit(node);
+        return;
+    }
+
+    UsedNames used;
+    used.visitAllChildren(node);
+    captured.insert(used.names.begin(), used.names.end());
+}
+
+void TypeInferenceVisitor::visit(ClassNode *node)
+{
+    if (!function)
+    {
+        Visitor::visit(node);
+        return;
+    }
+
+    declare(node->getName(), nullptr, false);
+
+    UsedNames used;
+    used.visitAllChildren(node);
+    captured.insert(used.names.begin(), used.names.end());
+}
+
+void TypeInferenceVisitor::visit(BlockNode *node)
+{
+    if (!function)
+    {
+        Visitor::visit(node);
+        return;
+    }
+
+    scopes.emplace_back();
+    if (node->getStatements())
+    {
+        // function declarations are hoisted to the start of their block
+        for (const auto &statement : node->getStatements()->getStatements())
+        {
+            if (auto funcDecl = dynamic_cast<FuncDeclNode *>(statement.get()))
+            {
+                declare(funcDecl->getName(), nullptr, false);
+            }
+        }
+        node->getStatements()->visit(this);
+    }
+    scopes.pop_back();
+}
+
+void TypeInferenceVisitor::visit(VarDeclNode *node)
+{
+    if (!function)
+    {
+        return;
+    }
+
+    // the value is worked out before the name is declared
+    if (node->getExpr())
+    {
+        node->getExpr()->visit(this);
+    }
+
+    int local = declare(node->getName(), node, !node->isConst() && node->getExpr());
+    if (node->getExpr())
+    {
+        locals[local].assignments.emplace_back('=', node->getExpr().get());
+    }
+}
+
+void TypeInferenceVisitor::visit(VarExprNode *node)
+{
+    if (function)
+    {
+        references[node] = resolve(node->getName());
+    }
+}
+
+void TypeInferenceVisitor::visit(AssignNode *node)
+{
+    auto variable = dynamic_cast<VarExprNode *>(node->getAsignee().get());
+    if (!function || !variable)
+    {
+        Visitor::visit(node);
+        return;
+    }
+
+    node->getExpr()->visit(this);
+
+    int local = resolve(variable->getName());
+    if (local >= 0)
+    {
+        locals[local].assignments.emplace_back(node->getOp(), node->getExpr().get());
+    }
+    changes.emplace_back(variable, local);
+}
+
+void TypeInferenceVisitor::visit(UnaryExprNode *node)
+{
+    int op = node->getOperator()->getType();
+    auto variable = dynamic_cast<VarExprNode *>(node->getExpression().get());
+    if (function && variable && (op == Token::INC || op == Token::DEC))
+    {
+        // a number stays one, anything else is an error
+        changes.emplace_back(variable, resolve(variable->getName()));
+        return;
+    }
+    Visitor::visit(node);
+}
+
+void TypeInferenceVisitor::visit(DeleteNode *node)
+{
+    if (!function)
+    {
+        return;
+    }
+
+    int local = resolve(node->getName());
+    if (local >= 0)
+    {
+        locals[local].number = false;
+    }
+}
+
+void TypeInferenceVisitor::visit(ForStatementNode *node)
+{
+    if (!function)
+    {
+        Visitor::visit(node);
+        return;
+    }
+
+    // the loop's scope holds what the init declares
+    scopes.emplace_back();
+    if (node->getInit())
+    {
+        node->getInit()->visit(this);
+    }
+    if (node->getCondition())
+    {
+        node->getCondition()->visit(this);
+    }
+    if (node->getBody())
+    {
+        node->getBody()->visit(this);
+    }
+    if (node->getIncrement())
+    {
+        node->getIncrement()->visit(this);
+    }
+    scopes.pop_back();
+}
+
+void TypeInferenceVisitor::visit(ForEachNode *node)
+{
+    if (!function)
+    {
+        Visitor::visit(node);
+        return;
+    }
+
+    if (node->getIterable())
+    {
+        node->getIterable()->visit(this);
+    }
+
+    // the variables hold whatever the iterable gives
+    scopes.emplace_back();
+    if (node->getKeyDecl())
+    {
+        declare(node->getKeyDecl()->getName(), node->getKeyDecl().get(), false);
+    }
+    if (node->getValueDecl())
+    {
+        declare(node->getValueDecl()->getName(), node->getValueDecl().get(), false);
+    }
+    if (node->getBody())
+    {
+        node->getBody()->visit(this);
+    }
+    scopes.pop_back();
+}
+
+void TypeInferenceVisitor::visit(ReturnStatementNode *node)
+{
+    if (function && node->getExpression())
+    {
+        node->getExpression()->visit(this);
+    }
+}
+
+void TypeInferenceVisitor::visit(ImportNode *node)
+{
+    UNUSED(node);
+    imports = true;
+}
+
+void TypeInferenceVisitor::analyze(FuncDeclNode *node)
+{
+    function = node;
+    locals.clear();
+    scopes.clear();
+    references.clear();
+    changes.clear();
+    captured.clear();
+    imports = false;
+
+    // the parameters hold whatever the caller passes
+    scopes.emplace_back();
+    auto params = node->getParams();
+    for (int i = 0; params && i < params->getParamCount(); ++i)
+    {
+        declare(params->getParam(i)->getName(), params->getParam(i).get(), false);
+    }
+    if (node->getBody())
+    {
+        node->getBody()->visit(this);
+    }
+
+    for (auto &local : locals)
+    {
+        if (imports || (local.node && captured.count(local.node->getName())))
+        {
+            local.number = false;
+        }
+    }
+
+    // start from every local being a number and drop the ones given
+    // something that may not be, until none are dropped
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (auto &local : locals)
+        {
+            if (!local.number)
+            {
+                continue;
+            }
+            for (const auto &assignment : local.assignments)
+            {
+                int op = assignment.first;
+                bool number = op == Token::MINUS_EQUAL || op == Token::MUL_EQUAL ||
+                              op == Token::DIV_EQUAL || op == Token::MOD_EQUAL ||
+                              isNumber(assignment.second);
+                if (!number)
+                {
+                    local.number = false;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    for (const auto &local : locals)
+    {
+        if (local.node)
+        {
+            local.node->setNumericLocal(local.number);
+        }
+    }
+    for (const auto &change : changes)
+    {
+        change.first->setNumericLocal(change.second >= 0 && locals[change.second].number);
+    }
+
+    function = nullptr;
+}
+
+int TypeInferenceVisitor::declare(const string &name, VarDeclNode *node, bool candidate)
+{
+    Local local;
+    local.node = node;
+    local.number = candidate;
+    locals.push_back(local);
+    scopes.back()[name] = static_cast<int>(locals.size()) - 1;
+    return static_cast<int>(locals.size()) - 1;
+}
+
+int TypeInferenceVisitor::resolve(const string &name) const
+{
+    for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope)
+    {
+        auto found = scope->find(name);
+        if (found != scope->end())
+        {
+            return found->second;
+        }
+    }
+    return -1;
+}
+
+bool TypeInferenceVisitor::isNumber(ExpressionNode *expression) const
+{
+    if (dynamic_cast<NumberNode *>(expression))
+    {
+        return true;
+    }
+
+    if (auto variable = dynamic_cast<VarExprNode *>(expression))
+    {
+        auto reference = references.find(variable);
+        return reference != references.end() && reference->second >= 0 && locals[reference->second].number;
+    }
+
+    // a number or an error
+    if (auto unary = dynamic_cast<UnaryExprNode *>(expression))
+    {
+        int op = unary->getOperator()->getType();
+        return op == '-' || op == '~' || op == Token::INC || op == Token::DEC;
+    }
+
+    if (auto binary = dynamic_cast<BinaryExprNode *>(expression))
+    {
+        switch (binary->getOperator()->getType())
+        {
+        case '-':
+        case '*':
+        case '/':
+        case '%':
+        case '&':
+        case '|':
+        case '^':
+        case Token::SHL:
+        case Token::SHR:
+            return true;
+        case '+':
+            return isNumber(binary->getLeft().get()) && isNumber(binary->getRight().get());
+        default:
+            return false;
+        }
+    }
+
+    return false;
+}
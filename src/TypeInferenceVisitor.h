@@ -0,0 +1,83 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Visitor.h"
+
+class ExpressionNode;
+
+// Proves which of a function's locals only ever hold numbers and marks them
+// (see VarDeclNode::isNumericLocal) along with the variables of the
+// assignments and steps that change them (see VarExprNode::isNumericLocal),
+// where the interpreter then changes the number a local holds in place
+// rather than making a new one. The Optimizer runs it once it is done.
+//
+// Each function is looked at on its own and without regard to the order its
+// statements run in. Names are resolved the way the interpreter resolves
+// them, block by block with declarations seen from where they are made and
+// functions and classes from the start of their block. A let with a value
+// makes a local, it holds numbers if every value assigned to it is one:
+// literals, other such locals, -, *, /, %, bitwise operators, shifts, ++, --
+// and + of two numbers. -=, *=, /= and %= give numbers or report an error.
+// Parameters, for-each variables, consts, deleted locals, locals nested
+// functions or classes use and every local of a function that imports are
+// left alone.
+class TypeInferenceVisitor : public Visitor
+{
+public:
+    TypeInferenceVisitor();
+
+    virtual void visitAllChildren(Node *node) override;
+public:
+    virtual void visit(FuncDeclNode *node) override;
+    virtual void visit(ClassNode *node) override;
+    virtual void visit(BlockNode *node) override;
+    virtual void visit(VarDeclNode *node) override;
+    virtual void visit(VarExprNode *node) override;
+    virtual void visit(AssignNode *node) override;
+    virtual void visit(UnaryExprNode *node) override;
+    virtual void visit(DeleteNode *node) override;
+    virtual void visit(ForStatementNode *node) override;
+    virtual void visit(ForEachNode *node) override;
+    virtual void visit(ReturnStatementNode *node) override;
+    virtual void visit(ImportNode *node) override;
+private:
+    void analyze(FuncDeclNode *node);
+
+    // declares a name in the innermost block, the index of its local
+    int declare(const std::string &name, VarDeclNode *node, bool candidate);
+
+    // the local a name refers to where it is used, -1 if it isn't one of
+    // the function's
+    int resolve(const std::string &name) const;
+
+    bool isNumber(ExpressionNode *expression) const;
+
+private:
+    struct Local
+    {
+        VarDeclNode *node;
+        bool number;
+
+        // the operators and values of the assignments to it
+        std::vector<std::pair<int, ExpressionNode *>> assignments;
+    };
+
+    // the function being looked at, nullptr while looking for functions
+    FuncDeclNode *function;
+    std::vector<Local> locals;
+    std::vector<std::map<std::string, int>> scopes;
+
+    // what the variables read, assigned and stepped refer to
+    std::map<VarExprNode *, int> references;
+    std::vector<std::pair<VarExprNode *, int>> changes;
+
+    // names the nested functions and classes use
+    std::set<std::string> captured;
+
+    bool imports;
+};
@@ -0,0 +1,599 @@
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include "TypedArrayValue.h"
+#include "Values.h"
+#include "Error.h"
+#include "Environment.h"
+#include "Utils.h"
+#include "Sort.h"
+
+using std::shared_ptr;
+using std::vector;
+using std::make_shared;
+using std::string;
+using std::static_pointer_cast;
+
+#define error(msg, range) \
+    rangeError(msg, range, __FILE__, __LINE__)
+
+#define errorAt(msg, location, range) \
+    locationRangeError(msg, location, range, __FILE__, __LINE__)
+
+//***********************************************
+// Kernels
+//
+// The loops below are written so the compiler can vectorize them: plain
+// indexed loops over contiguous storage, and reductions that keep four
+// independent accumulators instead of one so the additions can be done
+// side by side without reassociating a single running sum. Integer math is
+// done on uint64_t so overflow wraps instead of being undefined.
+//***********************************************
+
+static double sumOf(const vector<double> &data)
+{
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t n = data.size();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        s0 += data[i];
+        s1 += data[i + 1];
+        s2 += data[i + 2];
+        s3 += data[i + 3];
+    }
+    for (; i < n; ++i)
+    {
+        s0 += data[i];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+static int64_t sumOf(const vector<int64_t> &data)
+{
+    uint64_t sum = 0;
+    for (int64_t value : data)
+    {
+        sum += static_cast<uint64_t>(value);
+    }
+    return static_cast<int64_t>(sum);
+}
+
+template <typename A, typename B>
+static double dotOf(const vector<A> &a, const vector<B> &b)
+{
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t n = a.size();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        s0 += static_cast<double>(a[i]) * static_cast<double>(b[i]);
+        s1 += static_cast<double>(a[i + 1]) * static_cast<double>(b[i + 1]);
+        s2 += static_cast<double>(a[i + 2]) * static_cast<double>(b[i + 2]);
+        s3 += static_cast<double>(a[i + 3]) * static_cast<double>(b[i + 3]);
+    }
+    for (; i < n; ++i)
+    {
+        s0 += static_cast<double>(a[i]) * static_cast<double>(b[i]);
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+// returns the smallest (or largest when wantMax is set) element, data must not be empty
+template <typename T>
+static T extremeOf(const vector<T> &data, bool wantMax)
+{
+    T m0 = data[0], m1 = data[0], m2 = data[0], m3 = data[0];
+    size_t n = data.size();
+    size_t i = 0;
+    if (wantMax)
+    {
+        for (; i + 4 <= n; i += 4)
+        {
+            m0 = data[i] > m0 ? data[i] : m0;
+            m1 = data[i + 1] > m1 ? data[i + 1] : m1;
+            m2 = data[i + 2] > m2 ? data[i + 2] : m2;
+            m3 = data[i + 3] > m3 ? data[i + 3] : m3;
+        }
+        for (; i < n; ++i)
+        {
+            m0 = data[i] > m0 ? data[i] : m0;
+        }
+        return std::max(std::max(m0, m1), std::max(m2, m3));
+    }
+
+    for (; i + 4 <= n; i += 4)
+    {
+        m0 = data[i] < m0 ? data[i] : m0;
+        m1 = data[i + 1] < m1 ? data[i + 1] : m1;
+        m2 = data[i + 2] < m2 ? data[i + 2] : m2;
+        m3 = data[i + 3] < m3 ? data[i + 3] : m3;
+    }
+    for (; i < n; ++i)
+    {
+        m0 = data[i] < m0 ? data[i] : m0;
+    }
+    return std::min(std::min(m0, m1), std::min(m2, m3));
+}
+
+// truncates value to an integer, false if it isn't finite or doesn't fit
+static bool toInt64(double value, int64_t &result)
+{
+    // -2^63 is exact as a double, 2^63 is the first value past the range,
+    // and NaN fails both comparisons
+    if (!(value >= -9223372036854775808.0 && value < 9223372036854775808.0))
+    {
+        return false;
+    }
+    result = static_cast<int64_t>(value);
+    return true;
+}
+
+static void scaleBy(vector<double> &data, double factor)
+{
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] *= factor;
+    }
+}
+
+static void scaleBy(vector<int64_t> &data, int64_t factor)
+{
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = static_cast<int64_t>(static_cast<uint64_t>(data[i]) * static_cast<uint64_t>(factor));
+    }
+}
+
+static void addScalar(vector<double> &data, double amount)
+{
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] += amount;
+    }
+}
+
+static void addScalar(vector<int64_t> &data, int64_t amount)
+{
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = static_cast<int64_t>(static_cast<uint64_t>(data[i]) + static_cast<uint64_t>(amount));
+    }
+}
+
+template <typename B>
+static void addArray(vector<double> &data, const vector<B> &other)
+{
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] += static_cast<double>(other[i]);
+    }
+}
+
+static void addArray(vector<int64_t> &data, const vector<int64_t> &other)
+{
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = static_cast<int64_t>(static_cast<uint64_t>(data[i]) + static_cast<uint64_t>(other[i]));
+    }
+}
+
+// false, with data unchanged, if a sum doesn't fit in an int64_t; the
+// first of them is left in unfit
+static bool addArray(vector<int64_t> &data, const vector<double> &other, double &unfit)
+{
+    int64_t sum = 0;
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        if (!toInt64(static_cast<double>(data[i]) + other[i], sum))
+        {
+            unfit = static_cast<double>(data[i]) + other[i];
+            return false;
+        }
+    }
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        toInt64(static_cast<double>(data[i]) + other[i], data[i]);
+    }
+    return true;
+}
+
+//***********************************************
+// TypedArrayValue
+//***********************************************
+
+TypedArrayValue::TypedArrayValue(ElementType elementType, size_t length, const Range &range):
+    Value(Type::typed_array, range),
+    elementType(elementType)
+{
+    if (elementType == ElementType::float64)
+    {
+        floats.resize(length);
+    }
+    else
+    {
+        ints.resize(length);
+    }
+}
+
+double TypedArrayValue::get(size_t index) const
+{
+    return elementType == ElementType::float64 ? floats[index] : static_cast<double>(ints[index]);
+}
+
+bool TypedArrayValue::set(size_t index, double value)
+{
+    if (elementType == ElementType::float64)
+    {
+        floats[index] = value;
+        return true;
+    }
+    return toInt64(value, ints[index]);
+}
+
+bool TypedArrayValue::set(size_t index, const NumberValue &value)
+{
+    if (elementType == ElementType::int64 && value.isInt())
+    {
+        ints[index] = value.getInt();
+        return true;
+    }
+    return set(index, value.getValue());
+}
+
+string TypedArrayValue::rangeMessage(double value)
+{
+    return "Int64Array elements must be finite and fit in 64 bits, but got " + NumberValue::format(value);
+}
+
+shared_ptr<Value> TypedArrayValue::getElement(size_t index, const Range &range) const
+{
+    if (elementType == ElementType::int64)
+    {
+        return make_shared<NumberValue>(ints[index], range);
+    }
+    return make_shared<NumberValue>(floats[index], range);
+}
+
+shared_ptr<Value> TypedArrayValue::getMember(const string &name) const
+{
+    // builtins are registered on first use, like strings and arrays
+    if (members.empty())
+    {
+        const_cast<TypedArrayValue *>(this)->registerBuiltins();
+    }
+    return Value::getMember(name);
+}
+
+void TypedArrayValue::registerBuiltins()
+{
+    // length() -> number
+    addMember("length", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("length() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+            return make_shared<NumberValue>(length(), range);
+        },
+        getRange()
+    ), true);
+
+    // sum() -> number
+    addMember("sum", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("sum() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+
+            if (elementType == ElementType::float64)
+            {
+                return make_shared<NumberValue>(sumOf(floats), range);
+            }
+            return make_shared<NumberValue>(sumOf(ints), range);
+        },
+        getRange()
+    ), true);
+
+    // min() -> number or null when empty
+    addMember("min", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("min() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+
+            if (length() == 0)
+            {
+                return make_shared<NullValue>(range);
+            }
+
+            if (elementType == ElementType::float64)
+            {
+                return make_shared<NumberValue>(extremeOf(floats, false), range);
+            }
+            return make_shared<NumberValue>(extremeOf(ints, false), range);
+        },
+        getRange()
+    ), true);
+
+    // max() -> number or null when empty
+    addMember("max", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("max() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+
+            if (length() == 0)
+            {
+                return make_shared<NullValue>(range);
+            }
+
+            if (elementType == ElementType::float64)
+            {
+                return make_shared<NumberValue>(extremeOf(floats, true), range);
+            }
+            return make_shared<NumberValue>(extremeOf(ints, true), range);
+        },
+        getRange()
+    ), true);
+
+    // dot(other) -> number
+    addMember("dot", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (args.size() != 1)
+            {
+                error("dot() expects exactly 1 argument, but got " + std::to_string(args.size()), range);
+                return nullptr;
+            }
+
+            if (args[0]->getType() != Value::Type::typed_array)
+            {
+                errorAt("dot() expects a typed array argument, but got " + args[0]->typeAsString(), args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+
+            auto other = static_pointer_cast<TypedArrayValue>(args[0]);
+            if (other->length() != length())
+            {
+                errorAt("dot() expects arrays of the same length, got " + std::to_string(length()) + " and " + std::to_string(other->length()), args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+
+            double result;
+            if (elementType == ElementType::float64)
+            {
+                result = other->elementType == ElementType::float64 ? dotOf(floats, other->floats) : dotOf(floats, other->ints);
+            }
+            else
+            {
+                result = other->elementType == ElementType::float64 ? dotOf(ints, other->floats) : dotOf(ints, other->ints);
+            }
+            return make_shared<NumberValue>(result, range);
+        },
+        getRange()
+    ), true);
+
+    // scale(factor) -> null, multiplies every element in place
+    addMember("scale", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (args.size() != 1)
+            {
+                error("scale() expects exactly 1 argument, but got " + std::to_string(args.size()), range);
+                return nullptr;
+            }
+
+            if (args[0]->getType() != Value::Type::number)
+            {
+                errorAt("scale() expects a number argument, but got " + args[0]->typeAsString(), args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+
+            double factor = static_pointer_cast<NumberValue>(args[0])->getValue();
+            if (elementType == ElementType::float64)
+            {
+                scaleBy(floats, factor);
+            }
+            else
+            {
+                int64_t integerFactor = 0;
+                if (factor != std::trunc(factor) || !toInt64(factor, integerFactor))
+                {
+                    errorAt("scale() on an Int64Array expects an integer factor that fits in 64 bits", args[0]->getRange().getStart(), range);
+                    return nullptr;
+                }
+                scaleBy(ints, integerFactor);
+            }
+            return make_shared<NullValue>(range);
+        },
+        getRange()
+    ), true);
+
+    // add(other) -> null, adds a number or a typed array element-wise in place
+    addMember("add", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (args.size() != 1)
+            {
+                error("add() expects exactly 1 argument, but got " + std::to_string(args.size()), range);
+                return nullptr;
+            }
+
+            if (args[0]->getType() == Value::Type::number)
+            {
+                double amount = static_pointer_cast<NumberValue>(args[0])->getValue();
+                if (elementType == ElementType::float64)
+                {
+                    addScalar(floats, amount);
+                }
+                else
+                {
+                    int64_t integerAmount = 0;
+                    if (!toInt64(amount, integerAmount))
+                    {
+                        errorAt(rangeMessage(amount), args[0]->getRange().getStart(), range);
+                        return nullptr;
+                    }
+                    addScalar(ints, integerAmount);
+                }
+                return make_shared<NullValue>(range);
+            }
+
+            if (args[0]->getType() != Value::Type::typed_array)
+            {
+                errorAt("add() expects a number or a typed array, but got " + args[0]->typeAsString(), args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+
+            auto other = static_pointer_cast<TypedArrayValue>(args[0]);
+            if (other->length() != length())
+            {
+                errorAt("add() expects arrays of the same length, got " + std::to_string(length()) + " and " + std::to_string(other->length()), args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+
+            if (elementType == ElementType::float64)
+            {
+                if (other->elementType == ElementType::float64)
+                {
+                    addArray(floats, other->floats);
+                }
+                else
+                {
+                    addArray(floats, other->ints);
+                }
+            }
+            else
+            {
+                if (other->elementType == ElementType::float64)
+                {
+                    double unfit = 0;
+                    if (!addArray(ints, other->floats, unfit))
+                    {
+                        errorAt(rangeMessage(unfit), args[0]->getRange().getStart(), range);
+                        return nullptr;
+                    }
+                }
+                else
+                {
+                    addArray(ints, other->ints);
+                }
+            }
+            return make_shared<NullValue>(range);
+        },
+        getRange()
+    ), true);
+
+    // sort() -> null, sorts in ascending order in place
+    addMember("sort", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("sort() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+
+            if (elementType == ElementType::float64)
+            {
+                // NaN is not ordered, keep it out of the comparisons and put it last
+                auto last = std::partition(floats.begin(), floats.end(), [](double value) { return !std::isnan(value); });
+                Sort::sort(floats.begin(), last, std::less<double>());
+            }
+            else
+            {
+                Sort::sort(ints.begin(), ints.end(), std::less<int64_t>());
+            }
+            return make_shared<NullValue>(range);
+        },
+        getRange()
+    ), true);
+
+    // toArray() -> array of numbers
+    addMember("toArray", make_shared<BuiltinFunctionValue>(
+        [this](Interpreter &interpreter, const vector<shared_ptr<Value>>& args, shared_ptr<Environment> env, const Range &range = {}) -> shared_ptr<Value>
+        {
+            UNUSED(interpreter);
+            UNUSED(env);
+            if (!args.empty())
+            {
+                errorAt("toArray() does not take any arguments", args[0]->getRange().getStart(), range);
+                return nullptr;
+            }
+
+            vector<shared_ptr<Value>> elements;
+            elements.reserve(length());
+            for (size_t i = 0; i < length(); ++i)
+            {
+                elements.push_back(getElement(i, range));
+            }
+            return make_shared<ArrayValue>(elements, range);
+        },
+        getRange()
+    ), true);
+}
+
+string TypedArrayValue::toString() const
+{
+    string result = "[";
+    for (size_t i = 0; i < length(); ++i)
+    {
+        result += NumberValue::format(get(i));
+        if (i + 1 < length())
+        {
+            result += ", ";
+        }
+    }
+    result += "]";
+    return result;
+}
+
+bool TypedArrayValue::toBoolean() const
+{
+    return length() != 0;
+}
+
+string TypedArrayValue::typeAsString() const
+{
+    return elementType == ElementType::float64 ? "Float64Array" : "Int64Array";
+}
+
+shared_ptr<Value> TypedArrayValue::eq(const shared_ptr<NullValue> &other) const
+{
+    return make_shared<BooleanValue>(false, Range(getRange().getStart(), other->getRange().getEnd()));
+}
+
+shared_ptr<Value> TypedArrayValue::ne(const shared_ptr<NullValue> &other) const
+{
+    return make_shared<BooleanValue>(true, Range(getRange().getStart(), other->getRange().getEnd()));
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include "Value.h"
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+class NumberValue;
+
+// A fixed length array of numbers stored contiguously, either as doubles
+// (Float64Array) or as 64 bit integers (Int64Array), instead of as a vector
+// of separately allocated NumberValues.
+class TypedArrayValue : public Value
+{
+public:
+    enum class ElementType
+    {
+        float64,
+        int64
+    };
+
+public:
+    TypedArrayValue(ElementType elementType, size_t length, const Range &range = {});
+
+    void registerBuiltins();
+
+    inline ElementType getElementType() const { return elementType; }
+    inline size_t length() const { return elementType == ElementType::float64 ? floats.size() : ints.size(); }
+
+    // element access, values written to an Int64Array are truncated; set
+    // stores nothing and returns false for a value an Int64Array can't hold,
+    // one that isn't finite or is outside the range of int64_t
+    double get(size_t index) const;
+    bool set(size_t index, double value);
+    // stores an integer NumberValue exactly, where a double could round it
+    bool set(size_t index, const NumberValue &value);
+
+    // the error for a value set() won't store
+    static string rangeMessage(double value);
+
+    shared_ptr<Value> getElement(size_t index, const Range &range = {}) const;
+
+    inline vector<double> &getFloats() { return floats; }
+    inline vector<int64_t> &getInts() { return ints; }
+
+    virtual shared_ptr<Value> getMember(const string &name) const override;
+
+    string toString() const override;
+    bool toBoolean() const override;
+
+    virtual string typeAsString() const override;
+
+public:
+    virtual shared_ptr<Value> eq(const shared_ptr<NullValue> &other) const override;
+    virtual shared_ptr<Value> ne(const shared_ptr<NullValue> &other) const override;
+
+private:
+    ElementType elementType;
+    vector<double> floats;
+    vector<int64_t> ints;
+};
@@ -27,6 +27,11 @@ shared_ptr<ExpressionNode> UnaryExprNode::getExpression() const
     return expr;
 }
 
+void UnaryExprNode::setExpression(shared_ptr<ExpressionNode> expression)
+{
+    expr = expression;
+}
+
 bool UnaryExprNode::isPrefix() const
 {
     return prefix;
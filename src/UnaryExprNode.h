@@ -19,6 +19,7 @@ public:
 
     shared_ptr<OpNode> getOperator() const;
     shared_ptr<ExpressionNode> getExpression() const;
+    void setExpression(shared_ptr<ExpressionNode> expression);
     bool isPrefix() const;
 
     virtual void visit(Visitor *visitor) override;
@@ -21,6 +21,16 @@ bool Value::toBoolean() const
     return type != Type::null;
 }
 
+size_t Value::hash() const
+{
+    return std::hash<const Value *>()(this);
+}
+
+bool Value::equals(const Value &other) const
+{
+    return this == &other;
+}
+
 shared_ptr<Value> Value::getMember(const string &name) const
 {
     // default implementation just returns whatever is in the properties map
@@ -419,6 +429,51 @@ shared_ptr<Value> Value::logicalOr(const shared_ptr<Value> &other) const
     }
 }
 
+shared_ptr<Value> Value::bitAnd(const shared_ptr<Value> &other) const
+{
+    if (!other || other->getType() != Type::number)
+    {
+        return nullptr; // Unsupported type for bitwise operation
+    }
+    return bitAnd(static_pointer_cast<NumberValue>(other));
+}
+
+shared_ptr<Value> Value::bitOr(const shared_ptr<Value> &other) const
+{
+    if (!other || other->getType() != Type::number)
+    {
+        return nullptr; // Unsupported type for bitwise operation
+    }
+    return bitOr(static_pointer_cast<NumberValue>(other));
+}
+
+shared_ptr<Value> Value::bitXor(const shared_ptr<Value> &other) const
+{
+    if (!other || other->getType() != Type::number)
+    {
+        return nullptr; // Unsupported type for bitwise operation
+    }
+    return bitXor(static_pointer_cast<NumberValue>(other));
+}
+
+shared_ptr<Value> Value::shiftLeft(const shared_ptr<Value> &other) const
+{
+    if (!other || other->getType() != Type::number)
+    {
+        return nullptr; // Unsupported type for bitwise operation
+    }
+    return shiftLeft(static_pointer_cast<NumberValue>(other));
+}
+
+shared_ptr<Value> Value::shiftRight(const shared_ptr<Value> &other) const
+{
+    if (!other || other->getType() != Type::number)
+    {
+        return nullptr; // Unsupported type for bitwise operation
+    }
+    return shiftRight(static_pointer_cast<NumberValue>(other));
+}
+
 shared_ptr<Value> Value::comma(const shared_ptr<Value> &other) const
 {
     if (!other) return nullptr;
@@ -1067,12 +1122,47 @@ shared_ptr<Value> Value::comma(const shared_ptr<ArrayValue> &other) const
     return nullptr;
 }
 
+shared_ptr<Value> Value::bitAnd(const shared_ptr<NumberValue> &other) const
+{
+    if (!other) return nullptr;
+    return nullptr;
+}
+
+shared_ptr<Value> Value::bitOr(const shared_ptr<NumberValue> &other) const
+{
+    if (!other) return nullptr;
+    return nullptr;
+}
+
+shared_ptr<Value> Value::bitXor(const shared_ptr<NumberValue> &other) const
+{
+    if (!other) return nullptr;
+    return nullptr;
+}
+
+shared_ptr<Value> Value::shiftLeft(const shared_ptr<NumberValue> &other) const
+{
+    if (!other) return nullptr;
+    return nullptr;
+}
+
+shared_ptr<Value> Value::shiftRight(const shared_ptr<NumberValue> &other) const
+{
+    if (!other) return nullptr;
+    return nullptr;
+}
+
 shared_ptr<Value> Value::unaryMinus() const
 {
     return nullptr;
 }
 
 shared_ptr<Value> Value::unaryNot() const
+{
+    return nullptr;
+}
+
+shared_ptr<Value> Value::bitNot() const
 {
     return nullptr;
 }
\ No newline at end of file
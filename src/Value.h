@@ -45,6 +45,12 @@ public:
         builtin,
         class_,
         object, // for instances of classes
+        typed_array,
+        matrix,
+        deque,
+        set,
+        priority_queue,
+        iterator,
         error   // for error values
     };
 
@@ -70,6 +76,12 @@ public:
     virtual string toString() const = 0; // makes this class abstract
     virtual bool toBoolean() const;
 
+    // hashing and equality for the hash based collections, values that are
+    // equals() must hash the same. By default a value is only equal to itself,
+    // numbers, strings, booleans and null compare by value.
+    virtual size_t hash() const;
+    virtual bool equals(const Value &other) const;
+
     // it's recommended to call this base implementation in any subclasses that override this method
     // to avoid duplicate code for property retrieval, then if it returns nullptr, you can implement
     // specific behavior in the subclass (see string length property for example)
@@ -99,6 +111,11 @@ public:
     shared_ptr<Value> logicalAnd(const shared_ptr<Value> &other) const;
     shared_ptr<Value> logicalOr(const shared_ptr<Value> &other) const;
     shared_ptr<Value> comma(const shared_ptr<Value> &other) const;
+    shared_ptr<Value> bitAnd(const shared_ptr<Value> &other) const;
+    shared_ptr<Value> bitOr(const shared_ptr<Value> &other) const;
+    shared_ptr<Value> bitXor(const shared_ptr<Value> &other) const;
+    shared_ptr<Value> shiftLeft(const shared_ptr<Value> &other) const;
+    shared_ptr<Value> shiftRight(const shared_ptr<Value> &other) const;
 
     // + operator overloads
     virtual shared_ptr<Value> add(const shared_ptr<NullValue> &other) const;
@@ -234,9 +251,17 @@ public:
     virtual shared_ptr<Value> comma(const shared_ptr<BuiltinFunctionValue> &other) const;
     virtual shared_ptr<Value> comma(const shared_ptr<ArrayValue> &other) const;
 
+    // & | ^ << >> operator overloads, only numbers support them
+    virtual shared_ptr<Value> bitAnd(const shared_ptr<NumberValue> &other) const;
+    virtual shared_ptr<Value> bitOr(const shared_ptr<NumberValue> &other) const;
+    virtual shared_ptr<Value> bitXor(const shared_ptr<NumberValue> &other) const;
+    virtual shared_ptr<Value> shiftLeft(const shared_ptr<NumberValue> &other) const;
+    virtual shared_ptr<Value> shiftRight(const shared_ptr<NumberValue> &other) const;
+
     // Unary operators
     virtual shared_ptr<Value> unaryMinus() const;
     virtual shared_ptr<Value> unaryNot() const;
+    virtual shared_ptr<Value> bitNot() const;
 
 protected:
     Type type;
@@ -10,4 +10,11 @@
 #include "FunctionValue.h"
 #include "ArrayValue.h"
 #include "ClassValue.h"
-#include "ObjectValue.h"
\ No newline at end of file
+#include "ObjectValue.h"
+#include "TypedArrayValue.h"
+#include "MatrixValue.h"
+#include "DequeValue.h"
+#include "SetValue.h"
+#include "PriorityQueueValue.h"
+#include "IteratorValue.h"
+#include "GeneratorValue.h"
\ No newline at end of file
@@ -8,7 +8,8 @@ VarDeclNode::VarDeclNode(const Token &token,
     bool isConst):
     token(token),
     constFlag(isConst),
-    expr(move(expr))
+    expr(move(expr)),
+    numericLocal(false)
 {
     setRange(token.getRange());
     if (this->expr)
@@ -32,11 +33,26 @@ shared_ptr<ExpressionNode> VarDeclNode::getExpr() const
     return expr;
 }
 
+void VarDeclNode::setExpr(shared_ptr<ExpressionNode> expression)
+{
+    expr = expression;
+}
+
 bool VarDeclNode::isConst() const
 {
     return constFlag;
 }
 
+bool VarDeclNode::isNumericLocal() const
+{
+    return numericLocal;
+}
+
+void VarDeclNode::setNumericLocal(bool numeric)
+{
+    numericLocal = numeric;
+}
+
 void VarDeclNode::visit(Visitor *visitor)
 {
     visitor->visit(this);
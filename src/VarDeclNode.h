@@ -18,14 +18,21 @@ public:
     virtual const string &getName() const override;
 
     std::shared_ptr<ExpressionNode> getExpr() const;
+    void setExpr(std::shared_ptr<ExpressionNode> expression);
 
     virtual bool isConst() const override;
 
+    // set by the TypeInferenceVisitor when this is a function's local that
+    // only ever holds numbers
+    bool isNumericLocal() const;
+    void setNumericLocal(bool numeric);
+
     virtual void visit(Visitor *visitor) override;
 private:
     Token token;
     bool constFlag;
     std::shared_ptr<ExpressionNode> expr;
+    bool numericLocal;
 };
 
 using VarDeclNodePtr = std::shared_ptr<VarDeclNode>;
\ No newline at end of file
@@ -15,7 +15,8 @@
 using std::string;
 
 VarExprNode::VarExprNode(const Token &token):
-    token(token)
+    token(token),
+    numericLocal(false)
 {
     setRange(token.getRange());
 }
@@ -37,6 +38,16 @@ bool VarExprNode::isLval() const
     return true;
 }
 
+bool VarExprNode::isNumericLocal() const
+{
+    return numericLocal;
+}
+
+void VarExprNode::setNumericLocal(bool numeric)
+{
+    numericLocal = numeric;
+}
+
 void VarExprNode::visit(Visitor *visitor)
 {
     visitor->visit(this);
@@ -34,7 +34,13 @@ public:
 
     virtual bool isLval() const override;
 
+    // set by the TypeInferenceVisitor on a variable that is assigned or
+    // stepped when it is a function's local that only ever holds numbers
+    bool isNumericLocal() const;
+    void setNumericLocal(bool numeric);
+
     void visit(Visitor *visitor) override;
 private:
     Token token;
+    bool numericLocal;
 };
\ No newline at end of file
@@ -297,4 +297,12 @@ void Visitor::visit(WhileNode *node)
     {
         node->getBody()->visit(this);
     }
+}
+
+void Visitor::visit(YieldNode *node)
+{
+    if (node->getExpression())
+    {
+        node->getExpression()->visit(this);
+    }
 }
\ No newline at end of file
@@ -41,6 +41,7 @@ class UnaryExprNode;
 class VarDeclNode;
 class VarExprNode;
 class WhileNode;
+class YieldNode;
 
 class Visitor
 {
@@ -83,4 +84,5 @@ public:
     virtual void visit(VarDeclNode *node);
     virtual void visit(VarExprNode *node);
     virtual void visit(WhileNode *node);
+    virtual void visit(YieldNode *node);
 };
\ No newline at end of file
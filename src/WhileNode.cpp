@@ -36,6 +36,11 @@ shared_ptr<StatementNode> WhileNode::getBody() const
     return body;
 }
 
+void WhileNode::setCondition(shared_ptr<ExpressionNode> condition)
+{
+    this->condition = condition;
+}
+
 void WhileNode::visit(Visitor *visitor)
 {
     visitor->visit(this);
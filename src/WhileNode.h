@@ -5,6 +5,7 @@
 #include "Node.h"
 #include "ExpressionNode.h"
 #include "StatementNode.h"
+#include "Jit.h"
 
 using std::shared_ptr;
 
@@ -18,11 +19,16 @@ public:
     shared_ptr<ExpressionNode> getCondition() const;
 
     shared_ptr<StatementNode> getBody() const;
+    void setCondition(shared_ptr<ExpressionNode> condition);
+
+    // iterations counted until the loop is hot and the machine code made then
+    Jit::LoopState &getJitState() { return jitState; }
 
     void visit(Visitor *visitor) override;
 private:
     shared_ptr<ExpressionNode> condition;
     shared_ptr<StatementNode> body;
+    Jit::LoopState jitState;
 };
 
 using WhileNodePtr = shared_ptr<WhileNode>;
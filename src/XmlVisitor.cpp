@@ -76,6 +76,16 @@ void XmlVisitor::visit(ReturnStatementNode *node)
     closeTag("ReturnStatement");
 }
 
+void XmlVisitor::visit(YieldNode *node)
+{
+    openTag("Yield");
+    if (node->getExpression())
+    {
+        node->getExpression()->visit(this);
+    }
+    closeTag("Yield");
+}
+
 void XmlVisitor::visit(VarExprNode *node)
 {
     openTag("VarExpr", {"name=\"" + node->getToken().getValue() + "\""}, true);
@@ -85,7 +95,8 @@ void XmlVisitor::visit(VarDeclNode *node)
 {
     openTag("VarDecl", {
         "name=\"" + node->getToken().getValue() + "\"",
-        "is_const=\"" + std::string(node->isConst() ? "true" : "false") + "\""
+        "is_const=\"" + std::string(node->isConst() ? "true" : "false") + "\"",
+        "is_number=\"" + std::string(node->isNumericLocal() ? "true" : "false") + "\""
     }, false);
     if (node->getExpr())
     {
@@ -96,7 +107,7 @@ void XmlVisitor::visit(VarDeclNode *node)
 
 void XmlVisitor::visit(NumberNode *node)
 {
-    openTag("Number", {"value=\"" + std::to_string(node->getValue()) + "\""}, true);
+    openTag("Number", {"value=\"" + node->getToken().getValue() + "\""}, true);
 }
 
 void XmlVisitor::visit(CallNode *node)
@@ -271,4 +282,48 @@ void XmlVisitor::visit(BreakNode *node)
 void XmlVisitor::visit(DeleteNode *node)
 {
     openTag("Delete", {"identifier=\"" + node->getName() + "\""}, true);
-}
\ No newline at end of file
+}
+
+void XmlVisitor::visit(UnaryExprNode *node)
+{
+    openTag("UnaryExpression", {"prefix=\"" + std::string(node->isPrefix() ? "true" : "false") + "\""}, false);
+    node->getOperator()->visit(this);
+    if (node->getExpression())
+    {
+        node->getExpression()->visit(this);
+    }
+    closeTag("UnaryExpression");
+}
+
+void XmlVisitor::visit(ArrayNode *node)
+{
+    openTag("Array");
+    for (const auto &element : node->getElements())
+    {
+        if (element)
+        {
+            element->visit(this);
+        }
+    }
+    closeTag("Array");
+}
+
+void XmlVisitor::visit(ArrayAccessNode *node)
+{
+    openTag("ArrayAccess");
+    if (node->getArray())
+    {
+        node->getArray()->visit(this);
+    }
+    if (node->getIndex())
+    {
+        node->getIndex()->visit(this);
+    }
+    closeTag("ArrayAccess");
+}
+
+void XmlVisitor::visit(ContinueNode *node)
+{
+    UNUSED(node);
+    openTag("Continue", {}, true);
+}
@@ -28,6 +28,7 @@ public:
 public:
     void visit(StatementsNode *node) override;
     void visit(ReturnStatementNode *node) override;
+    void visit(YieldNode *node) override;
     void visit(VarExprNode *node) override;
     void visit(VarDeclNode *node) override;
     void visit(NumberNode *node) override;
@@ -47,6 +48,10 @@ public:
     void visit(NullNode *node) override;
     void visit(BreakNode *node) override;
     void visit(DeleteNode *node) override;
+    void visit(UnaryExprNode *node) override;
+    void visit(ArrayNode *node) override;
+    void visit(ArrayAccessNode *node) override;
+    void visit(ContinueNode *node) override;
 private:
     void openTag(const string &tagName, vector<string> attributes = {}, bool selfClosing = false);
     void closeTag(const string &tagName);
@@ -0,0 +1,26 @@
+#include "YieldNode.h"
+#include "Visitor.h"
+
+YieldNode::YieldNode(shared_ptr<ExpressionNode> expr):
+    expression(expr)
+{
+    if (expr)
+    {
+        setRange(expr->getRange());
+    }
+}
+
+shared_ptr<ExpressionNode> YieldNode::getExpression() const
+{
+    return expression;
+}
+
+void YieldNode::setExpression(shared_ptr<ExpressionNode> expr)
+{
+    expression = expr;
+}
+
+void YieldNode::visit(Visitor *visitor)
+{
+    visitor->visit(this);
+}
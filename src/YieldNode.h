@@ -0,0 +1,24 @@
+#pragma once
+
+#include <memory>
+
+#include "StatementNode.h"
+#include "ExpressionNode.h"
+#include "Visitor.h"
+
+using std::shared_ptr;
+
+// yield expr; hands a value to whoever is iterating the generator the
+// enclosing function returned, and pauses the function until the next one
+class YieldNode : public StatementNode
+{
+public:
+    YieldNode(shared_ptr<ExpressionNode> expr = nullptr);
+
+    shared_ptr<ExpressionNode> getExpression() const;
+    void setExpression(shared_ptr<ExpressionNode> expr);
+
+    void visit(Visitor *visitor) override;
+private:
+    shared_ptr<ExpressionNode> expression;
+};
@@ -15,10 +15,16 @@
 #include "Interpreter.h"
 #include "Environment.h"
 #include "SemanticErrorVisitor.h"
+#include "Optimizer.h"
+#include "XmlVisitor.h"
 #include "Values.h"
 #include "Error.h"
 #include "Color.h"
 #include "Exceptions.h"  // Add this for ExitException
+#include "Sort.h"
+#include "ScriptStack.h"
+#include "Jit.h"
+#include "Profiler.h"
 
 using std::cout;
 using std::cerr;
@@ -35,20 +41,37 @@ using std::vector;
 
 int runInteractiveMode(const vector<string> &args);
 int runFileMode(const vector<string> &args);
+bool applyOption(const string &option);
+
+// --dump-optimized prints the optimized tree of the script instead of running it
+static bool dumpOptimized = false;
 
 int main(int argc, char **argv)
 {
     srandom(static_cast<unsigned int>(time(nullptr) ^ getpid()));
 
-    vector<string> args;
-    if (argc > 1)
+    vector<string> args(argv + 1, argv + argc);
+
+    // leading --name=value arguments configure the interpreter,
+    // the script and its own arguments follow them
+    size_t optionCount = 0;
+    while (optionCount < args.size() && args[optionCount].rfind("--", 0) == 0)
+    {
+        if (!applyOption(args[optionCount]))
+        {
+            return 1;
+        }
+        optionCount++;
+    }
+    args.erase(args.begin(), args.begin() + optionCount);
+
+    if (!args.empty())
     {
-        args = vector<string>(argv + 1, argv + argc);
         Utils::removePrefix(args[0], "./");
     }
 
     // if no file is specified, or args[0] is not a file, run interactive mode
-    if (argc == 1 || !Utils::fileExists(args[0]))
+    if (args.empty() || !Utils::fileExists(args[0]))
     {
         cout << yellow << "lithium " << blue << INTERPRETER_VERSION << reset << "\ntype '" << cyan << "exit" << reset << "' to quit." << endl;
         return runInteractiveMode(args);
@@ -105,9 +128,16 @@ int runInteractiveMode(const vector<string> &args)
             continue;
         }
 
+        Optimizer optimizer;
+        optimizer.visitAllChildren(result.value.get());
+
         try
         {
-            interpreter.interpret(result.value.get()); // Reuse the same interpreter
+            // Reuse the same interpreter
+            if (!ScriptStack::run([&]() { interpreter.interpret(result.value.get()); }))
+            {
+                generalError("failed to allocate a stack of " + ScriptStack::formatSize(ScriptStack::maxSize) + ", see --max-stack", __FILE__, __LINE__);
+            }
         }
         catch (const ExitException &e)
         {
@@ -160,20 +190,127 @@ int runFileMode(const vector<string> &args)
         return 1;
     }
 
+    Optimizer optimizer;
+    optimizer.visitAllChildren(result.value.get());
+
+    if (dumpOptimized)
+    {
+        XmlVisitor xml;
+        xml.visitAllChildren(result.value.get());
+        cout << xml.getOutput();
+        return 0;
+    }
+
     shared_ptr<Environment> env = make_shared<Environment>();
 
     Interpreter interpreter(false, env, args);
+    if (!Profiler::path.empty() && !Profiler::start())
+    {
+        error("failed to open profile file: " + Profiler::path);
+    }
+
+    int status = 0;
     try
     {
-        if (!interpreter.interpret(result.value.get()))
+        bool succeeded = false;
+        if (!ScriptStack::run([&]() { succeeded = interpreter.interpret(result.value.get()); }))
         {
-            return 1;
+            generalError("failed to allocate a stack of " + ScriptStack::formatSize(ScriptStack::maxSize) + ", see --max-stack", __FILE__, __LINE__);
+        }
+        if (!succeeded)
+        {
+            status = 1;
         }
     }
     catch (const ExitException &e)
     {
-        return e.exitCode;
+        status = e.exitCode;
     }
 
-    return 0;
+    if (!Profiler::stop())
+    {
+        error("failed to write profile file: " + Profiler::path);
+    }
+
+    return status;
+}
+
+bool applyOption(const string &option)
+{
+    size_t equals = option.find('=');
+    string name = option.substr(0, equals);
+    string value = equals == string::npos ? "" : option.substr(equals + 1);
+
+    if (name == "--parallel-sort-threshold")
+    {
+        try
+        {
+            if (value.find_first_not_of("0123456789") != string::npos)
+            {
+                throw std::invalid_argument(value);
+            }
+            Sort::parallelThreshold = std::stoul(value);
+            return true;
+        }
+        catch (const exception &)
+        {
+            generalError("--parallel-sort-threshold expects a number of elements, 0 disables parallel sorting", __FILE__, __LINE__);
+            return false;
+        }
+    }
+
+    if (name == "--jit-threshold")
+    {
+        try
+        {
+            if (value.find_first_not_of("0123456789") != string::npos)
+            {
+                throw std::invalid_argument(value);
+            }
+            Jit::threshold = std::stoul(value);
+            return true;
+        }
+        catch (const exception &)
+        {
+            generalError("--jit-threshold expects a number of loop iterations, 0 disables compiling loops", __FILE__, __LINE__);
+            return false;
+        }
+    }
+
+    if (name == "--max-stack")
+    {
+        size_t bytes = 0;
+        if (!ScriptStack::parseSize(value, bytes) || bytes < 1024 * 1024 || bytes > ScriptStack::MAX_SIZE)
+        {
+            generalError("--max-stack expects a size from 1M to 1024G, such as 256M or 2G", __FILE__, __LINE__);
+            return false;
+        }
+        ScriptStack::maxSize = bytes;
+        return true;
+    }
+
+    if (name == "--profile")
+    {
+        if (value.empty())
+        {
+            generalError("--profile expects a file to write the profile to, such as --profile=out.folded", __FILE__, __LINE__);
+            return false;
+        }
+        Profiler::path = value;
+        return true;
+    }
+
+    if (name == "--dump-optimized")
+    {
+        if (!value.empty())
+        {
+            generalError("--dump-optimized doesn't take a value", __FILE__, __LINE__);
+            return false;
+        }
+        dumpOptimized = true;
+        return true;
+    }
+
+    generalError("unknown option: " + option, __FILE__, __LINE__);
+    return false;
 }